@@ -0,0 +1,158 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+// A Plant133 running the real watering code on simulated hardware, for native tests and tools.
+// millis(), the moisture ADCs, the reservoir float and the pump pins are faked with
+//  ArduinoFake, which is global, so they read and write the current Hardware.  To run several
+//  devices in a process, give each one its own Hardware and select it with setHardware()
+//  before running the device.
+
+#include <ArduinoFake.h>
+#include <ArduinoJson.h>
+#include <og3/ha_app.h>
+#include <trace_log.h>
+#include <watering.h>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+// Pins as wired in src/main.cpp.
+constexpr uint8_t kWaterPin = 23;
+constexpr uint8_t kModeLED = 17;
+constexpr unsigned kNumPlants = 4;
+constexpr uint8_t kMoistureAnalogPin[kNumPlants] = {32, 33, 34, 35};
+constexpr uint8_t kPumpCtlPin[kNumPlants] = {18, 13, 16, 19};
+constexpr const char* kPlantNames[kNumPlants] = {"plant1", "plant2", "plant3", "plant4"};
+
+// The simulated hardware.
+struct Hardware {
+  // The value of millis(), which wraps around at 2^32 as on the device.
+  uint32_t now_msec = 0;
+  uint16_t adc[kNumPlants] = {};
+  int float_level = HIGH;
+  bool pump_on[kNumPlants] = {};
+  // Called when the code turns a pump on or off.
+  std::function<void(unsigned plant, bool on)> on_pump;
+};
+
+inline Hardware*& currentHardware() {
+  static Hardware s_default;
+  static Hardware* s_current = &s_default;
+  return s_current;
+}
+
+// The hardware which the fakes currently read and write.
+inline Hardware& hw() { return *currentHardware(); }
+inline void setHardware(Hardware* hardware) { currentHardware() = hardware; }
+
+inline void fakeHardware() {
+  using namespace fakeit;
+  When(Method(ArduinoFake(), millis)).AlwaysDo([]() -> unsigned long { return hw().now_msec; });
+  When(Method(ArduinoFake(), pinMode)).AlwaysReturn();
+  When(Method(ArduinoFake(), digitalWrite)).AlwaysDo([](uint8_t pin, uint8_t val) {
+    for (unsigned i = 0; i < kNumPlants; i++) {
+      const bool on = val == HIGH;
+      if (pin == kPumpCtlPin[i] && hw().pump_on[i] != on) {
+        hw().pump_on[i] = on;
+        if (hw().on_pump) {
+          hw().on_pump(i, on);
+        }
+      }
+    }
+  });
+  When(Method(ArduinoFake(), digitalRead)).AlwaysDo([](uint8_t pin) -> int {
+    return pin == kWaterPin ? hw().float_level : LOW;
+  });
+  When(Method(ArduinoFake(), analogRead)).AlwaysDo([](uint8_t pin) -> int {
+    for (unsigned i = 0; i < kNumPlants; i++) {
+      if (pin == kMoistureAnalogPin[i]) {
+        return hw().adc[i];
+      }
+    }
+    return 0;
+  });
+}
+
+// The modules built the way src/main.cpp builds them, as if the device just booted.
+// Set hw().now_msec before creating one.  With trace, the device records a trace in memory
+//  as src/main.cpp does, except for the config, which the caller records with
+//  trace()->addConfig(config()) like src/main.cpp after applying any config.
+class Device {
+ public:
+  explicit Device(bool trace = false)
+      : m_app(og3::HAApp::Options("Plant133", "sim", og3::WifiApp::Options())),
+        m_reservoir(kWaterPin, &m_app) {
+    if (trace) {
+      m_trace.reset(new og3::TraceLog(&m_app));
+    }
+    for (unsigned i = 0; i < kNumPlants; i++) {
+      m_plants[i].reset(new og3::Watering(i, kPlantNames[i], kMoistureAnalogPin[i], kModeLED,
+                                          kPumpCtlPin[i], &m_app));
+      m_plants[i]->setClimate(&m_climate);
+    }
+    m_app.setup();
+  }
+
+  og3::Watering& plant(unsigned i) { return *m_plants[i]; }
+  og3::ReservoirCheck& reservoir() { return m_reservoir; }
+  og3::ClimateReadings& climate() { return m_climate; }
+  // The trace recorded by the device, or nullptr if it doesn't record one.
+  og3::TraceLog* trace() { return m_trace.get(); }
+
+  // Run the update of each plant, as the application loop does.
+  void loop() {
+    for (auto& plant : m_plants) {
+      plant->loop();
+    }
+  }
+
+  // Apply a config like the one recorded at the start of a trace:
+  //  {"plants": [ like GET /api/plants ], "reservoir": { reservoir config variables }}.
+  bool applyConfig(const char* json, size_t len) {
+    JsonDocument doc;
+    if (deserializeJson(doc, json, len)) {
+      return false;
+    }
+    m_reservoir.updateConfig(doc["reservoir"].as<JsonObject>());
+    for (JsonObject plant : doc["plants"].as<JsonArray>()) {
+      const int id = plant["id"] | 0;
+      if (id >= 1 && id <= static_cast<int>(kNumPlants)) {
+        // The device already accepted the config, so apply it as it is.
+        m_plants[id - 1]->applyApiPlants(plant);
+      }
+    }
+    return true;
+  }
+
+  // The current config, in the form taken by applyConfig().
+  std::string config() const {
+    JsonDocument doc;
+    JsonArray plants = doc["plants"].to<JsonArray>();
+    for (unsigned i = 0; i < kNumPlants; i++) {
+      JsonObject json = plants.add<JsonObject>();
+      json["id"] = i + 1;
+      m_plants[i]->getApiPlants(json);
+    }
+    m_reservoir.configVariables().toJson(doc["reservoir"].to<JsonObject>(),
+                                         og3::VariableBase::Flags::kConfig);
+    std::string out;
+    serializeJson(doc, out);
+    return out;
+  }
+
+ private:
+  og3::HAApp m_app;
+  std::unique_ptr<og3::TraceLog> m_trace;
+  og3::ReservoirCheck m_reservoir;
+  og3::ClimateReadings m_climate;
+  std::array<std::unique_ptr<og3::Watering>, kNumPlants> m_plants;
+};
+
+}  // namespace sim
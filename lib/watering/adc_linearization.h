@@ -0,0 +1,84 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <cstdint>
+
+namespace og3 {
+namespace adc {
+
+// Lookup tables which correct the nonlinear response of the ESP32 ADC1, which reads low
+//  near the bottom of its range and compresses near the top.
+// Each table maps the 12-bit raw counts of an attenuation to the input millivolts, computed
+//  at compile time from a polynomial fit and stored in flash, so a correction is a single
+//  lookup: millivolts<Fit11db>(counts).
+// The eFuse calibration of each chip (a reference voltage or two-point fit) changes the
+//  gain and offset of the ADC, which cancel when readings are mapped between two
+//  calibration points in raw counts, as moisture readings are.
+
+constexpr unsigned kNumCounts = 1 << 12;
+
+// The input voltage for raw counts at 11 dB attenuation, the Arduino default, fit to
+//  measurements across the whole range.
+struct Fit11db {
+  static constexpr double volts(unsigned counts) {
+    return 0.034143524634089 +
+           counts * (1.109019271794e-3 +
+                     counts * (-3.01211691e-7 + counts * (1.18171e-10 + counts * -1.6e-14)));
+  }
+};
+
+namespace detail {
+
+// A sequence of counts 0, 1, ... N-1, built in log2(N) steps so the depth of template
+//  instantiation stays small.
+template <unsigned... Is>
+struct Seq {};
+template <typename A, typename B>
+struct Concat;
+template <unsigned... A, unsigned... B>
+struct Concat<Seq<A...>, Seq<B...>> {
+  using type = Seq<A..., (sizeof...(A) + B)...>;
+};
+template <unsigned N>
+struct MakeSeq {
+  using type = typename Concat<typename MakeSeq<N / 2>::type,
+                               typename MakeSeq<N - N / 2>::type>::type;
+};
+template <>
+struct MakeSeq<0> {
+  using type = Seq<>;
+};
+template <>
+struct MakeSeq<1> {
+  using type = Seq<0>;
+};
+
+constexpr uint16_t toMillivolts(double volts) {
+  return volts <= 0.0 ? 0 : static_cast<uint16_t>(volts * 1000.0 + 0.5);
+}
+
+template <typename Fit, typename S>
+struct Table;
+template <typename Fit, unsigned... Is>
+struct Table<Fit, Seq<Is...>> {
+  static constexpr uint16_t kMillivolts[sizeof...(Is)] = {toMillivolts(Fit::volts(Is))...};
+};
+template <typename Fit, unsigned... Is>
+constexpr uint16_t Table<Fit, Seq<Is...>>::kMillivolts[sizeof...(Is)];
+
+}  // namespace detail
+
+// The millivolts table for an attenuation.
+template <typename Fit>
+using MillivoltTable = detail::Table<Fit, detail::MakeSeq<kNumCounts>::type>;
+
+// The input millivolts for raw counts.  Counts past 12 bits are masked, not checked.
+template <typename Fit>
+inline uint16_t millivolts(unsigned counts) {
+  return MillivoltTable<Fit>::kMillivolts[counts & (kNumCounts - 1)];
+}
+
+}  // namespace adc
+}  // namespace og3
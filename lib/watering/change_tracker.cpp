@@ -0,0 +1,120 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "change_tracker.h"
+
+#include <cstring>
+
+namespace og3 {
+
+namespace {
+
+// FNV-1a hash.
+constexpr uint32_t kFnvOffset = 2166136261u;
+constexpr uint32_t kFnvPrime = 16777619u;
+
+uint32_t hashBytes(const char* data, size_t len, uint32_t hash = kFnvOffset) {
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ static_cast<uint8_t>(data[i])) * kFnvPrime;
+  }
+  return hash;
+}
+
+uint32_t hashStr(const char* str, uint32_t hash = kFnvOffset) {
+  return hashBytes(str, strlen(str), hash);
+}
+
+// Hashes JSON as serializeJson() writes it, so values of any size are hashed in full.
+class HashWriter {
+ public:
+  size_t write(uint8_t c) {
+    m_hash = (m_hash ^ c) * kFnvPrime;
+    return 1;
+  }
+  size_t write(const uint8_t* data, size_t len) {
+    m_hash = hashBytes(reinterpret_cast<const char*>(data), len, m_hash);
+    return len;
+  }
+  uint32_t hash() const { return m_hash; }
+
+ private:
+  uint32_t m_hash = kFnvOffset;
+};
+
+}  // namespace
+
+void ChangeTracker::setVolatile(const char* key, unsigned long min_msec) {
+  m_volatile[hashStr(key)] = min_msec;
+}
+
+void ChangeTracker::bump() {
+  // All of the changes seen while building one response get the same new version.
+  if (!m_bumped) {
+    m_version += 1;
+    m_bumped = true;
+  }
+}
+
+unsigned ChangeTracker::diff(const char* path, JsonObjectConst in, JsonObject out, uint32_t since,
+                             const char* keep_key) {
+  const bool full = !isValidSince(since);
+  const uint32_t path_hash = hashStr(".", hashStr(path));
+  m_pass += 1;
+  unsigned count = 0;
+  for (JsonPairConst kv : in) {
+    HashWriter writer;
+    serializeJson(kv.value(), writer);
+    const uint32_t value_hash = writer.hash();
+    const uint32_t key_hash = hashStr(kv.key().c_str(), path_hash);
+
+    auto iter = m_entries.find(key_hash);
+    bool changed = iter == m_entries.end() || !iter->second.present ||
+                   iter->second.value_hash != value_hash;
+    if (changed && iter != m_entries.end() && iter->second.present) {
+      const auto volatile_iter = m_volatile.find(hashStr(kv.key().c_str()));
+      if (volatile_iter != m_volatile.end() &&
+          m_now_msec - iter->second.changed_msec < volatile_iter->second) {
+        changed = false;
+      }
+    }
+    if (changed) {
+      bump();
+      Entry& entry = m_entries[key_hash];
+      entry.value_hash = value_hash;
+      entry.version = m_version;
+      entry.changed_msec = m_now_msec;
+      entry.path_hash = path_hash;
+      entry.present = true;
+      entry.key = kv.key().c_str();
+      iter = m_entries.find(key_hash);
+    }
+    iter->second.seen = m_pass;
+    if (full || iter->second.version > since) {
+      out[kv.key()] = kv.value();
+      count += 1;
+    }
+  }
+  // Keys which were in the object before and are not now.
+  for (auto& kv : m_entries) {
+    Entry& entry = kv.second;
+    if (entry.path_hash != path_hash || entry.seen == m_pass) {
+      continue;
+    }
+    if (entry.present) {
+      bump();
+      entry.version = m_version;
+      entry.changed_msec = m_now_msec;
+      entry.present = false;
+    }
+    if (!full && entry.version > since) {
+      out[entry.key.c_str()] = nullptr;
+      count += 1;
+    }
+  }
+  if (count > 0 && keep_key && out[keep_key].isNull()) {
+    out[keep_key] = in[keep_key];
+  }
+  return count;
+}
+
+}  // namespace og3
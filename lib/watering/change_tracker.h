@@ -0,0 +1,82 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <ArduinoJson.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace og3 {
+
+// ChangeTracker assigns versions to changes of the values in JSON responses, so that a
+//  client which polls for data can be sent only the values that changed since its last poll.
+// Values are compared when a response is built, so all changes found while building one
+//  response get the same version.  Values are compared by a hash of their JSON.
+// A key which is left out of an object it was in before, such as a forecast which is only
+//  sent while it is valid, is a change, and is sent as null in deltas.
+class ChangeTracker {
+ public:
+  // Versions start from first_version, which should differ between boots so that
+  //  a version from before a reboot is not mistaken for a current one.
+  explicit ChangeTracker(uint32_t first_version)
+      : m_first_version(first_version), m_version(first_version) {}
+
+  // The version of the latest change which has been seen.
+  uint32_t version() const { return m_version; }
+
+  // Whether since is a version from this tracker which a delta can be computed from.
+  bool isValidSince(uint32_t since) const {
+    return since >= m_first_version && since <= m_version;
+  }
+
+  // Changes to the values of key, such as a raw reading which changes with every read, are
+  //  only recorded once the last recorded change is at least min_msec old, so that they don't
+  //  put the key in every delta.
+  void setVolatile(const char* key, unsigned long min_msec);
+
+  // Call this before comparing the values in a new response built at now_msec.
+  void beginResponse(unsigned long now_msec) {
+    m_bumped = false;
+    m_now_msec = now_msec;
+  }
+
+  // Record the values of in, and copy into out the values which changed after version since,
+  //  with null for keys which have been removed since then.
+  // If since is not a valid version, all values are copied.  If any value is copied, the
+  //  value of keep_key (such as an id) is also copied.  Returns the number of changed values.
+  // The path identifies in among all of the objects tracked.
+  unsigned diff(const char* path, JsonObjectConst in, JsonObject out, uint32_t since,
+                const char* keep_key = nullptr);
+
+ private:
+  struct Entry {
+    uint32_t value_hash = 0;
+    uint32_t version = 0;
+    unsigned long changed_msec = 0;
+    // The object the key is in, and the diff() which last saw the key in it.
+    uint32_t path_hash = 0;
+    uint32_t seen = 0;
+    // Whether the key was in the object when it was last seen.
+    bool present = false;
+    std::string key;
+  };
+
+  // Give the changes found while building the response a version.
+  void bump();
+
+  const uint32_t m_first_version;
+  uint32_t m_version;
+  bool m_bumped = false;
+  // Counts calls to diff(), to find the keys which it didn't see.
+  uint32_t m_pass = 0;
+  unsigned long m_now_msec = 0;
+  // Value hash and change version by hash of the value path.
+  std::map<uint32_t, Entry> m_entries;
+  // The minimum msec between recorded changes by hash of volatile keys.
+  std::map<uint32_t, unsigned long> m_volatile;
+};
+
+}  // namespace og3
@@ -0,0 +1,35 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include "trace_format.h"
+
+namespace og3 {
+
+// The latest good temperature and humidity readings, as used by the watering state machines.
+// Readings are rounded to the resolution stored in traces, so a replayed trace gives the
+//  same values the device used.
+class ClimateReadings {
+ public:
+  // Whether there is a good reading.
+  bool ok() const { return m_sample_msec != 0; }
+  float temperature() const { return m_temperature; }
+  float humidity() const { return m_humidity; }
+  // The uptime in msec of the latest good reading, or 0 if there is none.
+  unsigned long sampleMsec() const { return m_sample_msec; }
+
+  void set(float temperature, float humidity, unsigned long msec) {
+    m_temperature = trace::fromCenti(trace::toCenti(temperature));
+    m_humidity = trace::fromCenti(trace::toCenti(humidity));
+    // Never 0, so that ok() is true after the first reading.
+    m_sample_msec = msec | 1;
+  }
+
+ private:
+  float m_temperature = 0.0f;
+  float m_humidity = 0.0f;
+  unsigned long m_sample_msec = 0;
+};
+
+}  // namespace og3
@@ -0,0 +1,39 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "climate_sampler.h"
+
+#include <og3/constants.h>
+
+namespace og3 {
+
+const char ClimateSampler::kName[] = "climate";
+
+ClimateSampler::ClimateSampler(const char* vg_name, unsigned long period_msec, HAApp* app)
+    : Module(kName, &app->module_system()),
+      m_app(app),
+      m_vg(vg_name),
+      m_shtc3("temperature", "humidity", &app->module_system(), "temperature", m_vg),
+      m_scheduler(10 * kMsecInSec, period_msec, [this]() { sample(); }, &app->tasks()) {
+  add_link_fn([this](og3::NameToModule& name_to_module) -> bool {
+    m_telemetry = Telemetry::get(name_to_module);
+    return true;
+  });
+}
+
+void ClimateSampler::sample() {
+  m_shtc3.read();
+  if (m_shtc3.ok()) {
+    m_readings.set(m_shtc3.temperature(), m_shtc3.humidity(), millis());
+    for (const auto& fn : m_listeners) {
+      fn(*this);
+    }
+  }
+  if (m_telemetry) {
+    m_telemetry->mqttSend(m_vg);
+  } else {
+    m_app->mqttSend(m_vg);
+  }
+}
+
+}  // namespace og3
@@ -0,0 +1,57 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <og3/ha_app.h>
+#include <og3/shtc3.h>
+#include <og3/tasks.h>
+#include <og3/variable.h>
+
+#include <functional>
+#include <vector>
+
+#include "climate_readings.h"
+#include "telemetry.h"
+
+namespace og3 {
+
+// ClimateSampler owns the SHTC3 temperature/humidity sensor and reads it on a schedule
+//  from the main loop.  Everything else uses the cached readings, so web handlers never
+//  start I2C transactions from the network task.
+class ClimateSampler : public Module {
+ public:
+  static const char kName[];
+
+  // Functions called from the main loop after each good reading.
+  using Listener = std::function<void(const ClimateSampler&)>;
+
+  ClimateSampler(const char* vg_name, unsigned long period_msec, HAApp* app);
+
+  static ClimateSampler* get(const NameToModule& n2m) {
+    return GetModule<ClimateSampler>(n2m, kName);
+  }
+
+  void addListener(const Listener& fn) { m_listeners.push_back(fn); }
+
+  // The latest good readings.
+  const ClimateReadings& readings() const { return m_readings; }
+  bool ok() const { return m_readings.ok(); }
+  float temperature() const { return m_readings.temperature(); }
+  float humidity() const { return m_readings.humidity(); }
+
+  const VariableGroup& variables() const { return m_vg; }
+
+ private:
+  void sample();
+
+  HAApp* const m_app;
+  VariableGroup m_vg;
+  Shtc3 m_shtc3;
+  PeriodicTaskScheduler m_scheduler;
+  std::vector<Listener> m_listeners;
+  Telemetry* m_telemetry = nullptr;
+  ClimateReadings m_readings;
+};
+
+}  // namespace og3
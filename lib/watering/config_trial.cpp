@@ -0,0 +1,44 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "config_trial.h"
+
+#include "uptime.h"
+
+namespace og3 {
+
+void ConfigTrial::begin(unsigned long now_msec, uint32_t connects) {
+  m_start_msec = now_msec;
+  m_start_connects = connects;
+  m_status = Status::kApplying;
+}
+
+ConfigTrial::Status ConfigTrial::update(unsigned long now_msec, uint32_t connects) {
+  if (m_status != Status::kApplying) {
+    return m_status;
+  }
+  if (connects != m_start_connects) {
+    m_status = Status::kApplied;
+    return m_status;
+  }
+  if (elapsedMsec(now_msec, m_start_msec) >= m_timeout_msec) {
+    m_status = Status::kRolledBack;
+  }
+  return m_status;
+}
+
+const char* ConfigTrial::statusName(Status status) {
+  switch (status) {
+    case Status::kIdle:
+      return "idle";
+    case Status::kApplying:
+      return "applying";
+    case Status::kApplied:
+      return "applied";
+    case Status::kRolledBack:
+      return "rolled back";
+  }
+  return "?";
+}
+
+}  // namespace og3
@@ -0,0 +1,43 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <cstdint>
+
+namespace og3 {
+
+// ConfigTrial decides whether new network settings are kept, when they are applied without
+//  a reboot.  The settings are kept if the connection they are for is made again before a
+//  deadline, and are rolled back otherwise.
+// Connections are counted as they are made, so a reconnect which is over between two checks
+//  still counts, and a connection from before the new settings were applied doesn't.
+class ConfigTrial {
+ public:
+  enum class Status { kIdle, kApplying, kApplied, kRolledBack };
+
+  explicit ConfigTrial(unsigned long timeout_msec) : m_timeout_msec(timeout_msec) {}
+
+  // Start a trial, with the number of connections made before the connection is restarted
+  //  with the new settings.
+  void begin(unsigned long now_msec, uint32_t connects);
+  // Note settings which were kept without a trial, because there was no connection to lose.
+  void applied() { m_status = Status::kApplied; }
+  // Check the number of connections made during a trial.  Returns the status, which changes
+  //  once from kApplying to kApplied or kRolledBack.
+  Status update(unsigned long now_msec, uint32_t connects);
+
+  Status status() const { return m_status; }
+  bool applying() const { return m_status == Status::kApplying; }
+  unsigned long timeoutMsec() const { return m_timeout_msec; }
+
+  static const char* statusName(Status status);
+
+ private:
+  const unsigned long m_timeout_msec;
+  unsigned long m_start_msec = 0;
+  uint32_t m_start_connects = 0;
+  Status m_status = Status::kIdle;
+};
+
+}  // namespace og3
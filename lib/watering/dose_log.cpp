@@ -8,6 +8,7 @@
 
 #include <algorithm>
 
+#include "uptime.h"
 #include "watering.h"
 #include "watering_constants.h"
 
@@ -30,6 +31,8 @@ DoseLog::DoseLog(VariableGroup& vg, VariableGroup& cfg_vg, ModuleSystem* module_
                          "doses this cycle", 0, vg),
       m_dose_count(varname("doses_today", vg, &m_str_doses_today), 0, "", "doses in the past day",
                    0, vg),
+      m_pump_secs(varname("pump_secs_today", vg, &m_str_pump_secs_today), 0.0f, units::kSeconds,
+                  "pump time in the past day", 0, 1, vg),
       m_module_system(module_system),
       m_watering(watering) {}
 
@@ -50,6 +53,11 @@ void DoseLog::addHADiscovery(HADiscovery* had) {
     HADiscovery::Entry entry(m_dose_count, ha::device_type::kSensor, nullptr);
     return addEntry(entry, had, json);
   });
+  had->addDiscoveryCallback([this, addEntry](HADiscovery* had, JsonDocument* json) {
+    HADiscovery::Entry entry(m_pump_secs, ha::device_type::kSensor,
+                             ha::device_class::sensor::kDuration);
+    return addEntry(entry, had, json);
+  });
 }
 
 bool DoseLog::shouldPauseWatering() const {
@@ -62,36 +70,55 @@ bool DoseLog::shouldPauseWatering() const {
   return false;
 }
 
+DoseLog::Bucket& DoseLog::advance() {
+  constexpr int64_t kBucketSecs = kWateringPauseSec / kNumBuckets;
+  const int64_t hour = uptimeUsec() / kUsecInSec / kBucketSecs;
+  if (hour - m_hour >= static_cast<int64_t>(kNumBuckets)) {
+    // Everything in the window has expired.
+    for (auto& bucket : m_buckets) {
+      bucket = {};
+    }
+    m_dose_count = 0;
+    m_pump_secs = 0.0f;
+  } else {
+    // At most kNumBuckets buckets expire, however long it has been since the last call.
+    for (int64_t h = m_hour + 1; h <= hour; h++) {
+      Bucket& bucket = m_buckets[h % kNumBuckets];
+      m_dose_count = std::max(0, static_cast<int>(m_dose_count.value()) - bucket.doses);
+      m_pump_secs = std::max(0.0f, m_pump_secs.value() - bucket.pump_secs);
+      bucket = {};
+    }
+  }
+  m_hour = std::max(m_hour, hour);
+  return m_buckets[m_hour % kNumBuckets];
+}
+
 void DoseLog::addDose() {
-  m_dose_record.back().dose_count += 1;
+  advance().doses += 1;
   m_dose_count = m_dose_count.value() + 1;
   m_doses_this_cycle = m_doses_this_cycle.value() + 1;
 }
 
+void DoseLog::addPumpMsec(float msec) {
+  const float secs = 1e-3f * msec;
+  advance().pump_secs += secs;
+  m_pump_secs = m_pump_secs.value() + secs;
+}
+
+void DoseLog::dosesByHour(JsonArray out) const {
+  for (unsigned i = 1; i <= kNumBuckets; i++) {
+    out.add(m_buckets[(m_hour + i) % kNumBuckets].doses);
+  }
+}
+
 void DoseLog::update(bool is_watering) {
   if (m_is_watering != is_watering) {
-    if (is_watering) {
-      m_dose_record.pushBack({});
-    } else {
+    if (!is_watering) {
       m_doses_this_cycle = 0;
     }
     m_is_watering = is_watering;
   }
-
-  if (!m_is_watering && !m_dose_record.empty()) {
-    const int64_t now_secs = esp_timer_get_time() / kUsecInSec;
-    const int64_t one_day_ago = std::max(static_cast<int64_t>(0), now_secs - kWateringPauseSec);
-    while (!m_dose_record.empty()) {
-      const auto front = m_dose_record.front();
-      if (front.secs > one_day_ago) {
-        break;  // While dose record is not yet a day old, don't remove it.
-      }
-      log()->logf("Popping dose record (%zu left): %lld sec > %lld.", m_dose_record.size() - 1,
-                  front.secs, one_day_ago);
-      m_dose_count = std::max(0, static_cast<int>(m_dose_count.value()) - front.dose_count);
-      m_dose_record.popFront();
-    }
-  }
+  advance();
 }
 
 }  // namespace og3
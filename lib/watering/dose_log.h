@@ -3,9 +3,9 @@
 
 #pragma once
 
+#include <ArduinoJson.h>
 #include <og3/constants.h>
 #include <og3/module_system.h>
-#include <og3/ring_buffer.h>
 #include <og3/util.h>
 #include <og3/variable.h>
 
@@ -18,24 +18,36 @@ class Watering;
 // Track the total number of watering doses in a day.
 // This is done to avoid over-watering in case something goes wrong such as problems
 //  reading the moisture level of the soil.
+// Doses and pump time are counted in kNumBuckets hourly buckets covering the last day, with
+//  running totals, so adding, expiring and querying doses take constant time.
+// The window is the current hour and the 23 before it, so a dose is counted for 23 to 24
+//  hours, depending on when in its hour it was added.
 class DoseLog {
  public:
   DoseLog(VariableGroup& vg, VariableGroup& cfg_vg, ModuleSystem* module_system,
           Watering* watering);
 
-  // Return the total number of doses in the last 24 hours.
+  static constexpr unsigned kNumBuckets = 24;
+
+  // Return the total number of doses in the window, covering the last 23-24 hours.
   unsigned doseCount() const { return m_dose_count.value(); }
+  // Return the total seconds the pump ran in the window.
+  float pumpSecs() const { return m_pump_secs.value(); }
+  // Return the number of doses in each hour of the last day, oldest first.
+  void dosesByHour(JsonArray out) const;
 
   // When the pump has run m_max_doses in either a watering cycle or
   //  a 24 hour period is reached, pause watering for 12 hours.
   bool shouldPauseWatering() const;
 
-  // Call this each time the watering state machine is updated to add a watering-dose
-  //  entry when watering starts, and to expire watering doses after 24 hours.
+  // Call this each time the watering state machine is updated to track watering cycles,
+  //  and to expire watering doses after 24 hours.
   void update(bool is_watering);
   // Call this is increment the count of pump doses in the current watering cycle.
   // This should only be called if is_watering.
   void addDose();
+  // Call this at the end of a dose to add the time the pump ran.
+  void addPumpMsec(float msec);
 
   // This registers callbacks for Home Assistant MQTT auto-discovery of variables.
   void addHADiscovery(class HADiscovery* had);
@@ -49,6 +61,7 @@ class DoseLog {
 
   std::string m_str_doses_this_cycle;
   std::string m_str_doses_today;
+  std::string m_str_pump_secs_today;
 
   // The maximum number of doses to allow in a cycle/day before watering should be paused.
   Variable<unsigned> m_max_doses_per_cycle;
@@ -56,16 +69,20 @@ class DoseLog {
   Variable<unsigned> m_doses_this_cycle;
   // Number of doses in the last 24 hours.
   Variable<unsigned> m_dose_count;
+  // Seconds the pump ran in the last 24 hours.
+  FloatVariable m_pump_secs;
   bool m_is_watering = false;
 
-  // Doses in watering cycles in the last 24 hours.
-  struct Dose {
-    Dose() { this->secs = esp_timer_get_time() / kUsecInSec; }
-    uint64_t secs = 0;
-    int doses_this_cycle = 0;
-    int dose_count = 0;
+  // Doses in each hour of the last day, indexed by hour modulo kNumBuckets.
+  struct Bucket {
+    uint16_t doses = 0;
+    float pump_secs = 0.0f;
   };
-  RingQueue<Dose, 16> m_dose_record;
+  Bucket m_buckets[kNumBuckets];
+  // Hours since boot of the newest bucket.
+  int64_t m_hour = 0;
+  // Expire buckets older than a day, and return the bucket for the current hour.
+  Bucket& advance();
   ModuleSystem* m_module_system;  // Used to access the logger.
   Watering* m_watering;
 };
@@ -0,0 +1,126 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "drying_forecast.h"
+
+#include <og3/constants.h>
+#include <og3/units.h>
+
+#include "watering_constants.h"
+
+namespace og3 {
+
+namespace {
+// The climate regressors are relative to these values and scaled to be near 1.
+constexpr float kReferenceTempC = 20.0f;
+constexpr float kReferenceHumidity = 50.0f;
+constexpr float kClimateScale = 0.1f;
+// Initial variance of the coefficients, which is large because nothing is known yet.
+constexpr float kInitialVariance = 100.0f;
+}  // namespace
+
+DryingForecast::DryingForecast(const char* rate_name, const char* next_name, VariableGroup& vg)
+    : m_rate(rate_name, 0.0f, "%/h", "soil drying rate", 0, 2, vg),
+      m_next_watering_sec(next_name, 0.0f, units::kSeconds, "predicted time until watering", 0, 0,
+                          vg) {
+  for (unsigned i = 0; i < kN; i++) {
+    for (unsigned j = 0; j < kN; j++) {
+      m_p[i][j] = i == j ? kInitialVariance : 0.0f;
+    }
+  }
+  m_rate.setFailed();
+  m_next_watering_sec.setFailed();
+}
+
+void DryingForecast::setClimate(float tempC, float humidity) {
+  m_tempC = tempC;
+  m_humidity = humidity;
+  m_have_climate = true;
+}
+
+void DryingForecast::features(float x[kN]) const {
+  x[0] = 1.0f;
+  x[1] = m_have_climate ? kClimateScale * (m_tempC - kReferenceTempC) : 0.0f;
+  x[2] = m_have_climate ? kClimateScale * (m_humidity - kReferenceHumidity) : 0.0f;
+}
+
+void DryingForecast::addSample(float secs, float moisture) {
+  if (!m_have_anchor || secs < m_anchor_secs) {
+    m_have_anchor = true;
+    m_anchor_secs = secs;
+    m_anchor_moisture = moisture;
+    return;
+  }
+  const float dsecs = secs - m_anchor_secs;
+  if (dsecs < kForecastRateSec) {
+    return;
+  }
+  addRate((moisture - m_anchor_moisture) * kSecInHour / dsecs);
+  m_anchor_secs = secs;
+  m_anchor_moisture = moisture;
+}
+
+void DryingForecast::addRate(float rate_per_hour) {
+  float x[kN];
+  features(x);
+  // Recursive least squares update with forgetting factor kForecastForgetting.
+  float px[kN];
+  float xpx = 0.0f;
+  for (unsigned i = 0; i < kN; i++) {
+    px[i] = 0.0f;
+    for (unsigned j = 0; j < kN; j++) {
+      px[i] += m_p[i][j] * x[j];
+    }
+    xpx += x[i] * px[i];
+  }
+  const float denom = kForecastForgetting + xpx;
+  float err = rate_per_hour;
+  for (unsigned i = 0; i < kN; i++) {
+    err -= m_theta[i] * x[i];
+  }
+  for (unsigned i = 0; i < kN; i++) {
+    m_theta[i] += px[i] / denom * err;
+  }
+  // P is symmetric, so x'P == (Px)'.
+  for (unsigned i = 0; i < kN; i++) {
+    for (unsigned j = 0; j < kN; j++) {
+      m_p[i][j] = (m_p[i][j] - px[i] * px[j] / denom) / kForecastForgetting;
+    }
+  }
+  m_num_rates += 1;
+}
+
+float DryingForecast::ratePerHour() const {
+  float x[kN];
+  features(x);
+  float rate = 0.0f;
+  for (unsigned i = 0; i < kN; i++) {
+    rate += m_theta[i] * x[i];
+  }
+  return rate;
+}
+
+float DryingForecast::update(float moisture, float min_target) {
+  if (!valid()) {
+    return -1.0f;
+  }
+  const float rate = ratePerHour();
+  m_rate = rate;
+  m_rate.setFailed(false);
+  if (moisture <= min_target) {
+    m_next_watering_sec = 0.0f;
+    m_next_watering_sec.setFailed(false);
+    return 0.0f;
+  }
+  if (rate > -kForecastMinDryingPerHour) {
+    // The soil is not measurably drying, so there is no useful prediction.
+    m_next_watering_sec.setFailed();
+    return -1.0f;
+  }
+  const float secs = (moisture - min_target) / -rate * kSecInHour;
+  m_next_watering_sec = secs;
+  m_next_watering_sec.setFailed(false);
+  return secs;
+}
+
+}  // namespace og3
@@ -0,0 +1,64 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <og3/variable.h>
+
+namespace og3 {
+
+// DryingForecast estimates how fast the soil of a plant dries between waterings, and
+//  predicts when the moisture level will fall to the minimum target.
+// The drying rate is fit online by recursive least squares with exponential forgetting,
+//  using the air temperature and humidity as regressors when they are known, so the
+//  estimate follows the seasons and changes in the weather.
+class DryingForecast {
+ public:
+  DryingForecast(const char* rate_name, const char* next_name, VariableGroup& vg);
+
+  // Set the current air temperature and relative humidity.
+  void setClimate(float tempC, float humidity);
+
+  // Add a filtered moisture reading taken while waiting for the soil to dry.
+  void addSample(float secs, float moisture);
+  // Forget the last reading, such as after watering, so the next rate starts fresh.
+  void restart() { m_have_anchor = false; }
+
+  // Update the forecast from the current moisture level, and return the predicted seconds
+  //  until it falls to min_target, or a negative number if there is no forecast yet.
+  float update(float moisture, float min_target);
+
+  // Estimated drying rate in % moisture per hour under the current climate (negative drying).
+  float ratePerHour() const;
+  bool valid() const { return m_num_rates >= kMinRates; }
+
+  const FloatVariable& rateVariable() const { return m_rate; }
+  const FloatVariable& nextWateringVariable() const { return m_next_watering_sec; }
+
+ private:
+  static constexpr unsigned kN = 3;
+  static constexpr unsigned kMinRates = 3;
+
+  // The regressors for the current climate.
+  void features(float x[kN]) const;
+  void addRate(float rate_per_hour);
+
+  float m_tempC = 0.0f;
+  float m_humidity = 0.0f;
+  bool m_have_climate = false;
+
+  // The reading which the next drying rate is measured from.
+  bool m_have_anchor = false;
+  float m_anchor_secs = 0.0f;
+  float m_anchor_moisture = 0.0f;
+
+  // Model coefficients and their scaled covariance.
+  float m_theta[kN] = {0.0f, 0.0f, 0.0f};
+  float m_p[kN][kN];
+  unsigned m_num_rates = 0;
+
+  FloatVariable m_rate;
+  FloatVariable m_next_watering_sec;
+};
+
+}  // namespace og3
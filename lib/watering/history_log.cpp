@@ -0,0 +1,636 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "history_log.h"
+
+#ifndef NATIVE
+#include <LittleFS.h>
+#endif
+#include <og3/constants.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <ctime>
+#include <memory>
+#include <string>
+
+#include "watering_constants.h"
+
+namespace og3 {
+
+namespace {
+
+// History segments are stored in this directory as files named by sequence number.
+constexpr char kDir[] = "/history";
+// Each file in the history starts with this magic, a version byte and a spare byte,
+//  followed by the 32-bit little-endian time of the segment.
+// Segments start with a time base record, and may be appended to after a reboot.  Segments
+//  of other versions are skipped.
+constexpr uint8_t kMagic0 = 'P';
+constexpr uint8_t kMagic1 = 'H';
+constexpr uint8_t kVersion = 2;
+constexpr size_t kHeaderBytes = 8;
+// Largest encoding of one record: tag, time delta and two zigzag varints.
+constexpr size_t kMaxRecordBytes = 1 + 3 * 5;
+// Room for a record and the time base record which may come before it.
+constexpr size_t kMaxRecordsBytes = 2 * kMaxRecordBytes;
+// Times before this (2020-01-01) are taken to be uptime rather than epoch time.
+constexpr uint32_t kMinEpochSecs = 1577836800;
+constexpr unsigned kMaxChannels = 16;
+// Most records read for each chunk of a /api/history response, so a request which filters
+//  out most records doesn't read through the whole history in one web server callback.
+constexpr unsigned kMaxRecordsPerFill = 64;
+
+void segmentPath(uint32_t segment, char* path, size_t len) {
+  snprintf(path, len, "%s/%08lu.bin", kDir, static_cast<unsigned long>(segment));
+}
+
+int32_t scaled(float val) { return static_cast<int32_t>(lroundf(val * 10.0f)); }
+
+uint32_t zigzag(int32_t val) {
+  return (static_cast<uint32_t>(val) << 1) ^ static_cast<uint32_t>(val >> 31);
+}
+int32_t unzigzag(uint32_t val) {
+  return static_cast<int32_t>(val >> 1) ^ -static_cast<int32_t>(val & 1);
+}
+
+#ifndef NATIVE
+// HistoryReader decodes records from the history segments, oldest first, reading
+//  the files a byte at a time so that only one record is held in memory.
+class HistoryReader {
+ public:
+  HistoryReader(uint32_t first_segment, uint32_t last_segment)
+      : m_segment(first_segment), m_last_segment(last_segment) {}
+  ~HistoryReader() {
+    if (m_file) {
+      m_file.close();
+    }
+  }
+
+  bool next(HistoryLog::Record* rec) {
+    while (true) {
+      if (!m_file && !openNext()) {
+        return false;
+      }
+      if (readRecord(rec)) {
+        return true;
+      }
+      // End of this segment (or a record truncated by a power cut).
+      m_file.close();
+    }
+  }
+
+  // Whether the last segment read ended after a complete record, so that records can be
+  //  appended to it.
+  bool endedCleanly() const { return m_clean_end; }
+
+ private:
+  bool openNext() {
+    char path[40];
+    while (m_segment <= m_last_segment) {
+      segmentPath(m_segment++, path, sizeof(path));
+      if (!LittleFS.exists(path)) {
+        continue;
+      }
+      m_file = LittleFS.open(path, "r");
+      if (!m_file) {
+        continue;
+      }
+      uint8_t header[kHeaderBytes];
+      if (m_file.read(header, sizeof(header)) != sizeof(header) || header[0] != kMagic0 ||
+          header[1] != kMagic1 || header[2] != kVersion) {
+        m_file.close();
+        continue;
+      }
+      m_secs = header[4] | (header[5] << 8) | (header[6] << 16) |
+               (static_cast<uint32_t>(header[7]) << 24);
+      resetDeltas();
+      return true;
+    }
+    return false;
+  }
+
+  void resetDeltas() {
+    for (unsigned i = 0; i < kMaxChannels; i++) {
+      m_moisture[i] = 0;
+      m_raw[i] = 0;
+    }
+    m_temp = 0;
+    m_humidity = 0;
+  }
+
+  bool getVarint(uint32_t* val) {
+    *val = 0;
+    for (unsigned shift = 0; shift < 35; shift += 7) {
+      const int byte = m_file.read();
+      if (byte < 0) {
+        return false;
+      }
+      *val |= static_cast<uint32_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+  bool getSigned(int32_t* val) {
+    uint32_t uval = 0;
+    if (!getVarint(&uval)) {
+      return false;
+    }
+    *val = unzigzag(uval);
+    return true;
+  }
+
+  bool readRecord(HistoryLog::Record* rec) {
+    const int tag = m_file.read();
+    m_clean_end = tag < 0;
+    // A time base record has the time of the record, and others the time since the last.
+    const bool time_base = tag >= 0 && (tag >> 4) == HistoryLog::kKindTimeBase;
+    uint32_t secs = 0;
+    if (tag < 0 || !getVarint(&secs)) {
+      return false;
+    }
+    if (time_base) {
+      m_secs = secs;
+      resetDeltas();
+    } else {
+      m_secs += secs;
+    }
+    rec->secs = m_secs;
+    rec->uptime = m_secs < kMinEpochSecs;
+    rec->kind = static_cast<HistoryLog::Kind>(tag >> 4);
+    rec->channel = tag & 0x0f;
+    rec->a = 0.0f;
+    rec->b = 0.0f;
+    switch (rec->kind) {
+      case HistoryLog::kKindMoisture: {
+        int32_t dm = 0;
+        int32_t dr = 0;
+        if (!getSigned(&dm) || !getSigned(&dr)) {
+          return false;
+        }
+        m_moisture[rec->channel] += dm;
+        m_raw[rec->channel] += dr;
+        rec->a = 0.1f * m_moisture[rec->channel];
+        rec->b = m_raw[rec->channel];
+        return true;
+      }
+      case HistoryLog::kKindDose: {
+        uint32_t msec = 0;
+        if (!getVarint(&msec)) {
+          return false;
+        }
+        rec->a = msec;
+        return true;
+      }
+      case HistoryLog::kKindReservoir:
+        // The float state is stored in the channel bits of the tag.
+        rec->a = rec->channel;
+        rec->channel = 0;
+        return true;
+      case HistoryLog::kKindClimate: {
+        int32_t dtemp = 0;
+        int32_t dh = 0;
+        if (!getSigned(&dtemp) || !getSigned(&dh)) {
+          return false;
+        }
+        m_temp += dtemp;
+        m_humidity += dh;
+        rec->a = 0.1f * m_temp;
+        rec->b = 0.1f * m_humidity;
+        return true;
+      }
+      case HistoryLog::kKindTimeBase:
+        // Whether this is the first record after a boot is stored in the channel bits.
+        rec->a = rec->channel;
+        rec->channel = 0;
+        return true;
+    }
+    return false;  // Unknown record kind: the rest of the segment can't be decoded.
+  }
+
+  uint32_t m_segment;
+  const uint32_t m_last_segment;
+  File m_file;
+  uint32_t m_secs = 0;
+  int32_t m_moisture[kMaxChannels] = {};
+  int32_t m_raw[kMaxChannels] = {};
+  int32_t m_temp = 0;
+  int32_t m_humidity = 0;
+  bool m_clean_end = false;
+};
+
+// HistoryStream formats a range of the history as JSON for a chunked web response.
+// When step is non-zero, moisture and climate readings are averaged over step seconds.
+// Records are stamped "t" with seconds since the epoch, or "uptime" with seconds since boot
+//  if they were logged before the clock was set.  A time range selects records stamped "t".
+class HistoryStream {
+ public:
+  HistoryStream(uint32_t first_segment, uint32_t last_segment, int plant, bool have_range,
+                uint32_t from, uint32_t to, uint32_t step)
+      : m_reader(first_segment, last_segment), m_plant(plant), m_have_range(have_range),
+        m_from(from), m_to(to), m_step(step) {}
+
+  // Fill buffer with up to max_len bytes of the response, returning 0 at the end.
+  // At most kMaxRecordsPerFill records are read per call.  If none of them is in the
+  //  response, this returns RESPONSE_TRY_AGAIN so the web server calls it again later.
+  size_t fill(uint8_t* buffer, size_t max_len) {
+    for (unsigned i = 0; i < kMaxRecordsPerFill && m_pending.size() - m_offset < max_len && !m_done;
+         i++) {
+      produce();
+    }
+    if (m_pending.size() == m_offset && !m_done) {
+      return RESPONSE_TRY_AGAIN;
+    }
+    const size_t len = std::min(max_len, m_pending.size() - m_offset);
+    memcpy(buffer, m_pending.data() + m_offset, len);
+    m_offset += len;
+    if (m_offset == m_pending.size()) {
+      m_pending.clear();
+      m_offset = 0;
+    }
+    return len;
+  }
+
+ private:
+  struct Bucket {
+    uint32_t start = 0;
+    unsigned count = 0;
+    float a = 0.0f;
+    float b = 0.0f;
+  };
+
+  void emit(const char* fmt, ...) {
+    char line[96];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (m_count++ > 0) {
+      m_pending += ",\n";
+    }
+    m_pending += line;
+  }
+
+  static const char* timeKey(uint32_t secs) { return secs < kMinEpochSecs ? "uptime" : "t"; }
+
+  bool inRange(uint32_t secs) const {
+    if (secs < kMinEpochSecs) {
+      return !m_have_range;
+    }
+    return secs >= m_from && secs <= m_to;
+  }
+
+  void emitMoisture(unsigned channel, uint32_t secs, float a, float b) {
+    emit("{\"%s\":%lu,\"plant\":%u,\"moisture\":%.1f,\"raw\":%.0f}", timeKey(secs),
+         static_cast<unsigned long>(secs), channel + 1, a, b);
+  }
+  void emitClimate(uint32_t secs, float a, float b) {
+    emit("{\"%s\":%lu,\"temperature\":%.1f,\"humidity\":%.1f}", timeKey(secs),
+         static_cast<unsigned long>(secs), a, b);
+  }
+
+  // Add a reading to a bucket, emitting the previous bucket if the reading is in a new one.
+  template <typename EmitFn>
+  void addToBucket(Bucket* bucket, const HistoryLog::Record& rec, const EmitFn& emit_fn) {
+    const uint32_t start = rec.secs - rec.secs % m_step;
+    if (bucket->count > 0 && bucket->start != start) {
+      emit_fn(bucket->start, bucket->a / bucket->count, bucket->b / bucket->count);
+      bucket->count = 0;
+    }
+    if (bucket->count == 0) {
+      bucket->start = start;
+      bucket->a = 0.0f;
+      bucket->b = 0.0f;
+    }
+    bucket->count += 1;
+    bucket->a += rec.a;
+    bucket->b += rec.b;
+  }
+
+  void produce() {
+    if (!m_started) {
+      m_started = true;
+      m_pending += "[\n";
+      return;
+    }
+    HistoryLog::Record rec;
+    if (!m_reader.next(&rec)) {
+      // Flush any partially filled buckets and close the array.
+      for (unsigned i = 0; i < kMaxChannels; i++) {
+        if (m_moisture[i].count > 0) {
+          emitMoisture(i, m_moisture[i].start, m_moisture[i].a / m_moisture[i].count,
+                       m_moisture[i].b / m_moisture[i].count);
+        }
+      }
+      if (m_climate.count > 0) {
+        emitClimate(m_climate.start, m_climate.a / m_climate.count,
+                    m_climate.b / m_climate.count);
+      }
+      m_pending += "\n]\n";
+      m_done = true;
+      return;
+    }
+    if (!inRange(rec.secs)) {
+      return;
+    }
+    const bool is_plant_record =
+        rec.kind == HistoryLog::kKindMoisture || rec.kind == HistoryLog::kKindDose;
+    if (m_plant >= 0 && is_plant_record && rec.channel != m_plant) {
+      return;
+    }
+    switch (rec.kind) {
+      case HistoryLog::kKindMoisture:
+        if (m_step == 0) {
+          emitMoisture(rec.channel, rec.secs, rec.a, rec.b);
+        } else {
+          const unsigned channel = rec.channel;
+          addToBucket(&m_moisture[channel], rec, [this, channel](uint32_t t, float a, float b) {
+            emitMoisture(channel, t, a, b);
+          });
+        }
+        break;
+      case HistoryLog::kKindDose:
+        emit("{\"%s\":%lu,\"plant\":%u,\"doseMsec\":%.0f}", timeKey(rec.secs),
+             static_cast<unsigned long>(rec.secs), rec.channel + 1, rec.a);
+        break;
+      case HistoryLog::kKindReservoir:
+        emit("{\"%s\":%lu,\"waterLevel\":%s}", timeKey(rec.secs),
+             static_cast<unsigned long>(rec.secs), rec.a > 0.5f ? "true" : "false");
+        break;
+      case HistoryLog::kKindTimeBase:
+        if (rec.a > 0.5f) {
+          emit("{\"%s\":%lu,\"boot\":true}", timeKey(rec.secs),
+               static_cast<unsigned long>(rec.secs));
+        }
+        break;
+      case HistoryLog::kKindClimate:
+        if (m_step == 0) {
+          emitClimate(rec.secs, rec.a, rec.b);
+        } else {
+          addToBucket(&m_climate, rec,
+                      [this](uint32_t t, float a, float b) { emitClimate(t, a, b); });
+        }
+        break;
+    }
+  }
+
+  HistoryReader m_reader;
+  const int m_plant;  // 0-based plant index, or -1 for all plants.
+  const bool m_have_range;
+  const uint32_t m_from;
+  const uint32_t m_to;
+  const uint32_t m_step;
+  Bucket m_moisture[kMaxChannels];
+  Bucket m_climate;
+  std::string m_pending;
+  size_t m_offset = 0;
+  unsigned m_count = 0;
+  bool m_started = false;
+  bool m_done = false;
+};
+#endif
+
+}  // namespace
+
+const char HistoryLog::kName[] = "history";
+
+HistoryLog::HistoryLog(HAApp* app) : Module(kName, &app->module_system()), m_app(app) {
+  add_init_fn([this]() {
+#ifndef NATIVE
+    if (!LittleFS.exists(kDir) && !LittleFS.mkdir(kDir)) {
+      log()->logf("history: failed to create %s.", kDir);
+      return;
+    }
+    // Find the most recent segment.
+    File dir = LittleFS.open(kDir);
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+      const char* slash = strrchr(file.name(), '/');
+      const uint32_t segment = strtoul(slash ? slash + 1 : file.name(), nullptr, 10);
+      m_segment = std::max(m_segment, segment);
+    }
+    dir.close();
+    m_ok = true;
+    resumeSegment();
+    m_app->web_server().on("/api/history", HTTP_GET, [this](AsyncWebServerRequest* request) {
+      handleHistoryRequest(request);
+    });
+#endif
+  });
+  add_update_fn([this]() {
+    if (m_buffer_len > 0 && millis() - m_last_flush_msec >= kHistoryFlushMsec) {
+      flush();
+    }
+  });
+}
+
+// static
+uint32_t HistoryLog::nowSecs() {
+  const time_t now = time(nullptr);
+  if (now >= static_cast<time_t>(kMinEpochSecs)) {
+    return static_cast<uint32_t>(now);
+  }
+  return static_cast<uint32_t>(millis() / kMsecInSec);
+}
+
+void HistoryLog::putVarint(uint32_t val) {
+  while (val >= 0x80) {
+    m_buffer[m_buffer_len++] = static_cast<uint8_t>(val | 0x80);
+    val >>= 7;
+  }
+  m_buffer[m_buffer_len++] = static_cast<uint8_t>(val);
+}
+
+void HistoryLog::putSigned(int32_t val) { putVarint(zigzag(val)); }
+
+void HistoryLog::resumeSegment() {
+#ifndef NATIVE
+  // Append to the last segment if it has room, and ends with a complete record.
+  if (m_segment == 0) {
+    return;
+  }
+  char path[40];
+  segmentPath(m_segment, path, sizeof(path));
+  if (!LittleFS.exists(path)) {
+    return;
+  }
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    return;
+  }
+  uint8_t header[kHeaderBytes];
+  const bool have_header = file.read(header, sizeof(header)) == sizeof(header) &&
+                           header[0] == kMagic0 && header[1] == kMagic1 &&
+                           header[2] == kVersion;
+  const size_t bytes = file.size();
+  file.close();
+  if (!have_header || bytes + kMaxRecordsBytes > kHistorySegmentBytes) {
+    return;
+  }
+  HistoryReader reader(m_segment, m_segment);
+  Record rec;
+  while (reader.next(&rec)) {
+  }
+  if (!reader.endedCleanly()) {
+    return;
+  }
+  m_have_segment = true;
+  m_segment_bytes = bytes;
+#endif
+}
+
+void HistoryLog::startSegment(uint32_t secs) {
+  flush();
+  m_segment += 1;
+  m_have_segment = true;
+  m_have_time_base = false;
+#ifndef NATIVE
+  // Delete the segment which falls out of the flash budget.
+  if (m_ok && m_segment >= kHistoryMaxSegments) {
+    char path[40];
+    segmentPath(m_segment - kHistoryMaxSegments, path, sizeof(path));
+    if (LittleFS.exists(path)) {
+      LittleFS.remove(path);
+    }
+  }
+#endif
+  m_buffer[0] = kMagic0;
+  m_buffer[1] = kMagic1;
+  m_buffer[2] = kVersion;
+  m_buffer[3] = 0;
+  for (unsigned i = 0; i < 4; i++) {
+    m_buffer[4 + i] = static_cast<uint8_t>(secs >> (8 * i));
+  }
+  m_buffer_len = kHeaderBytes;
+  m_segment_bytes = 0;
+}
+
+void HistoryLog::putTimeBase(uint32_t secs) {
+  m_buffer[m_buffer_len++] = static_cast<uint8_t>((kKindTimeBase << 4) | (m_booted ? 0 : 1));
+  putVarint(secs);
+  m_booted = true;
+  m_have_time_base = true;
+  m_last_secs = secs;
+  for (unsigned i = 0; i < kMaxChannels; i++) {
+    m_last_moisture[i] = 0;
+    m_last_raw[i] = 0;
+  }
+  m_last_temp = 0;
+  m_last_humidity = 0;
+}
+
+void HistoryLog::beginRecord(Kind kind, uint8_t channel, uint32_t secs) {
+  // Start a new segment after boot if the last one can't be appended to, or when the segment
+  //  is full.
+  if (!m_have_segment ||
+      m_segment_bytes + m_buffer_len + kMaxRecordsBytes > kHistorySegmentBytes) {
+    startSegment(secs);
+  }
+  if (m_buffer_len + kMaxRecordsBytes > sizeof(m_buffer)) {
+    flush();
+  }
+  // Restart the times after boot, at the start of a segment, when the clock is set (changing
+  //  from seconds since boot to since the epoch), or if the clock went backwards.
+  const bool uptime = secs < kMinEpochSecs;
+  if (!m_have_time_base || secs < m_last_secs || uptime != (m_last_secs < kMinEpochSecs)) {
+    putTimeBase(secs);
+  }
+  m_buffer[m_buffer_len++] = static_cast<uint8_t>((kind << 4) | (channel & 0x0f));
+  putVarint(secs - m_last_secs);
+  m_last_secs = secs;
+}
+
+void HistoryLog::flush() {
+  m_last_flush_msec = millis();
+  if (m_buffer_len == 0) {
+    return;
+  }
+#ifndef NATIVE
+  if (m_ok) {
+    char path[40];
+    segmentPath(m_segment, path, sizeof(path));
+    File file = LittleFS.open(path, "a");
+    if (!file || file.write(m_buffer, m_buffer_len) != m_buffer_len) {
+      log()->logf("history: failed to append to %s.", path);
+    }
+    if (file) {
+      file.close();
+    }
+  }
+#endif
+  m_segment_bytes += m_buffer_len;
+  m_buffer_len = 0;
+}
+
+void HistoryLog::addMoisture(unsigned plant, float filtered_percent, unsigned raw_counts) {
+  if (plant >= kMaxChannels) {
+    return;
+  }
+  const uint32_t secs = nowSecs();
+  if (m_moisture_logged[plant] && secs >= m_moisture_logged_secs[plant] &&
+      secs - m_moisture_logged_secs[plant] < kHistoryMoistureIntervalSec) {
+    return;
+  }
+  m_moisture_logged[plant] = true;
+  m_moisture_logged_secs[plant] = secs;
+  beginRecord(kKindMoisture, plant, secs);
+  const int32_t moisture = scaled(filtered_percent);
+  const int32_t raw = static_cast<int32_t>(raw_counts);
+  putSigned(moisture - m_last_moisture[plant]);
+  putSigned(raw - m_last_raw[plant]);
+  m_last_moisture[plant] = moisture;
+  m_last_raw[plant] = raw;
+}
+
+void HistoryLog::addDose(unsigned plant, unsigned pump_msec) {
+  if (plant >= kMaxChannels) {
+    return;
+  }
+  beginRecord(kKindDose, plant, nowSecs());
+  putVarint(pump_msec);
+}
+
+void HistoryLog::addReservoir(bool have_water) {
+  beginRecord(kKindReservoir, have_water ? 1 : 0, nowSecs());
+}
+
+void HistoryLog::addClimate(float temp_c, float humidity) {
+  beginRecord(kKindClimate, 0, nowSecs());
+  const int32_t temp = scaled(temp_c);
+  const int32_t hum = scaled(humidity);
+  putSigned(temp - m_last_temp);
+  putSigned(hum - m_last_humidity);
+  m_last_temp = temp;
+  m_last_humidity = hum;
+}
+
+void HistoryLog::handleHistoryRequest(AsyncWebServerRequest* request) {
+#ifndef NATIVE
+  if (m_limiter && !m_limiter->admit(RateLimiter::kApiRead, request)) {
+    return;
+  }
+  auto param = [request](const char* name, uint32_t default_val) -> uint32_t {
+    if (!request->hasParam(name)) {
+      return default_val;
+    }
+    return strtoul(request->getParam(name)->value().c_str(), nullptr, 10);
+  };
+  // Plants are numbered from 1 in the web API.
+  const int plant = static_cast<int>(param("plant", 0)) - 1;
+  const uint32_t first =
+      m_segment >= kHistoryMaxSegments ? m_segment - kHistoryMaxSegments + 1 : 0;
+  const bool have_range = request->hasParam("from") || request->hasParam("to");
+  auto stream =
+      std::make_shared<HistoryStream>(first, m_segment, plant, have_range, param("from", 0),
+                                      param("to", UINT32_MAX), param("step", 0));
+  AsyncWebServerResponse* response = request->beginChunkedResponse(
+      "application/json", [stream](uint8_t* buffer, size_t max_len, size_t index) -> size_t {
+        return stream->fill(buffer, max_len);
+      });
+  request->send(response);
+#endif
+}
+
+}  // namespace og3
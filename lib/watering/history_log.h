@@ -0,0 +1,109 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <og3/ha_app.h>
+#include <og3/module.h>
+
+#include <cstdint>
+
+#include "rate_limiter.h"
+
+namespace og3 {
+
+// HistoryLog keeps a persistent time-series log of moisture readings, pump doses,
+//  reservoir float changes and climate readings in LittleFS.
+// Records are delta/varint encoded and appended to a small number of fixed-size segment
+//  files.  When the flash budget is used, the oldest segment is deleted.  After a reboot,
+//  records are appended to the last segment if it has room, so reboots don't use up segments.
+// Records are buffered in RAM and appended to flash in batches to limit flash wear.
+// Records are stamped with seconds since the epoch once the clock has been set, and with
+//  seconds since boot before then.  Each record is marked with which it uses.
+class HistoryLog : public Module {
+ public:
+  // The kinds of records stored in the log.
+  enum Kind : uint8_t {
+    kKindMoisture = 1,   // channel=plant index, a=filtered moisture %, b=raw ADC counts.
+    kKindDose = 2,       // channel=plant index, a=pump-on msec.
+    kKindReservoir = 3,  // a=1 if the float is floating, 0 if water is low.
+    kKindClimate = 4,    // a=temperature C, b=humidity %.
+    // Restarts delta encoding from the time of the record, after boot (a=1), or when the
+    //  clock is set or goes backwards (a=0).
+    kKindTimeBase = 5,
+  };
+
+  // A decoded history record.
+  struct Record {
+    uint32_t secs = 0;
+    // Whether secs is seconds since boot rather than seconds since the epoch.
+    bool uptime = false;
+    Kind kind = kKindMoisture;
+    uint8_t channel = 0;
+    float a = 0.0f;
+    float b = 0.0f;
+  };
+
+  static const char kName[];
+
+  explicit HistoryLog(HAApp* app);
+
+  static HistoryLog* get(const NameToModule& n2m) { return GetModule<HistoryLog>(n2m, kName); }
+
+  // Log a moisture reading for a plant.  Readings are decimated so that at most one
+  //  reading per plant is stored every kHistoryMoistureIntervalSec.
+  void addMoisture(unsigned plant, float filtered_percent, unsigned raw_counts);
+  // Log a pump dose for a plant.
+  void addDose(unsigned plant, unsigned pump_msec);
+  // Log a change of the reservoir float state.
+  void addReservoir(bool have_water);
+  // Log a climate reading.
+  void addClimate(float temp_c, float humidity);
+
+  // Append any buffered records to flash.
+  void flush();
+  // Admit /api/history requests through limiter, as they read through flash.
+  void setLimiter(RateLimiter* limiter) { m_limiter = limiter; }
+
+  // The time used to stamp records: seconds since the epoch if the clock has been set,
+  //  or seconds since boot otherwise.
+  static uint32_t nowSecs();
+
+ private:
+  void beginRecord(Kind kind, uint8_t channel, uint32_t secs);
+  void putVarint(uint32_t val);
+  void putSigned(int32_t val);
+  void putTimeBase(uint32_t secs);
+  void resumeSegment();
+  void startSegment(uint32_t secs);
+  void handleHistoryRequest(AsyncWebServerRequest* request);
+
+  HAApp* const m_app;
+  RateLimiter* m_limiter = nullptr;
+  bool m_ok = false;
+
+  // Sequence number of the segment currently being written.
+  uint32_t m_segment = 0;
+  // Bytes flushed to the current segment.
+  size_t m_segment_bytes = 0;
+  bool m_have_segment = false;
+
+  // Delta-encoding state for the current segment, which a time base record restarts.
+  bool m_have_time_base = false;
+  bool m_booted = false;
+  uint32_t m_last_secs = 0;
+  int32_t m_last_moisture[16] = {};
+  int32_t m_last_raw[16] = {};
+  int32_t m_last_temp = 0;
+  int32_t m_last_humidity = 0;
+
+  // Time of the last stored moisture reading per plant, for decimation.
+  uint32_t m_moisture_logged_secs[16] = {};
+  bool m_moisture_logged[16] = {};
+
+  uint8_t m_buffer[512];
+  size_t m_buffer_len = 0;
+  unsigned long m_last_flush_msec = 0;
+};
+
+}  // namespace og3
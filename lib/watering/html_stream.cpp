@@ -0,0 +1,252 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "html_stream.h"
+
+#include <ArduinoJson.h>
+#include <og3/web_server.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace og3 {
+
+namespace {
+
+const char kPageHead[] PROGMEM =
+    "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\">"
+    "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
+    "<title>{board}: {title}</title>\n"
+    "<style>body{font-family:sans-serif;margin:1em}"
+    "table{border-collapse:collapse;margin-bottom:1em}"
+    "td{padding:2px 8px;border-bottom:1px solid #ddd}</style>\n"
+    "</head><body>\n<h2>{board}</h2>\n<h3>{title}</h3>\n";
+const char kPageFoot[] PROGMEM = "</body></html>\n";
+
+// Static text is copied into the response this many bytes at a time.
+constexpr size_t kTextStep = 256;
+
+void appendEscaped(String* out, const char* text) {
+  for (const char* c = text; *c; c++) {
+    switch (*c) {
+      case '&':
+        *out += "&amp;";
+        break;
+      case '<':
+        *out += "&lt;";
+        break;
+      case '>':
+        *out += "&gt;";
+        break;
+      case '"':
+        *out += "&quot;";
+        break;
+      default:
+        *out += *c;
+    }
+  }
+}
+
+}  // namespace
+
+HtmlStream::HtmlStream(const char* board, const char* title) : m_board(board), m_title(title) {
+  text(kPageHead);
+}
+
+HtmlStream& HtmlStream::text(const char* text) {
+  Part part(Part::kText);
+  part.text = text;
+  m_parts.push_back(part);
+  return *this;
+}
+
+HtmlStream& HtmlStream::table(const VariableGroup& vg) {
+  Part part(Part::kTable);
+  part.vg = &vg;
+  m_parts.push_back(part);
+  return *this;
+}
+
+HtmlStream& HtmlStream::formTable(const VariableGroup& vg) {
+  Part part(Part::kFormTable);
+  part.vg = &vg;
+  m_parts.push_back(part);
+  return *this;
+}
+
+HtmlStream& HtmlStream::snippet(const SnippetFn& fn) {
+  Part part(Part::kSnippet);
+  part.fn = fn;
+  m_parts.push_back(part);
+  return *this;
+}
+
+HtmlStream& HtmlStream::button(const char* title, const char* url) {
+  return snippet([title, url](String* out) {
+    *out += "<p><button onclick=\"location.href='";
+    *out += url;
+    *out += "'\" type=\"button\">";
+    *out += title;
+    *out += "</button></p>\n";
+  });
+}
+
+// static
+bool HtmlStream::readForm(AsyncWebServerRequest* request, VariableGroup* vg) {
+  JsonDocument before;
+  JsonDocument after;
+  vg->toJson(before.to<JsonObject>(), VariableBase::Flags::kConfig);
+  ::og3::read(*request, *vg);
+  vg->toJson(after.to<JsonObject>(), VariableBase::Flags::kConfig);
+  String before_json;
+  String after_json;
+  serializeJson(before, before_json);
+  serializeJson(after, after_json);
+  return before_json != after_json;
+}
+
+// static
+void HtmlStream::send(const std::shared_ptr<HtmlStream>& page, AsyncWebServerRequest* request) {
+  page->text(kPageFoot);
+  AsyncWebServerResponse* response = request->beginChunkedResponse(
+      "text/html", [page](uint8_t* buffer, size_t max_len, size_t index) -> size_t {
+        return page->fill(buffer, max_len);
+      });
+  request->send(response);
+}
+
+size_t HtmlStream::fill(uint8_t* buffer, size_t max_len) {
+  while (m_pending.length() - m_offset < max_len && produce()) {
+  }
+  const size_t len = std::min(max_len, m_pending.length() - m_offset);
+  memcpy(buffer, m_pending.c_str() + m_offset, len);
+  m_offset += len;
+  if (m_offset == m_pending.length()) {
+    m_pending = "";
+    m_offset = 0;
+  }
+  return len;
+}
+
+bool HtmlStream::produce() {
+  if (m_part >= m_parts.size()) {
+    return false;
+  }
+  const Part& part = m_parts[m_part];
+  switch (part.kind) {
+    case Part::kText:
+      produceText(part.text);
+      break;
+    case Part::kTable:
+    case Part::kFormTable:
+      produceRow(part);
+      break;
+    case Part::kSnippet:
+      part.fn(&m_pending);
+      m_part += 1;
+      break;
+  }
+  return true;
+}
+
+void HtmlStream::produceText(const char* text) {
+  const char* start = text + m_pos;
+  const char* pos = start;
+  while (*pos && pos - start < static_cast<int>(kTextStep)) {
+    if (*pos == '{') {
+      const String* value = nullptr;
+      size_t len = 0;
+      if (0 == strncmp(pos, "{board}", 7)) {
+        value = &m_board;
+        len = 7;
+      } else if (0 == strncmp(pos, "{title}", 7)) {
+        value = &m_title;
+        len = 7;
+      }
+      if (value) {
+        m_pending.concat(start, pos - start);
+        appendEscaped(&m_pending, value->c_str());
+        pos += len;
+        start = pos;
+        continue;
+      }
+    }
+    pos++;
+  }
+  m_pending.concat(start, pos - start);
+  m_pos = pos - text;
+  if (!*pos) {
+    m_part += 1;
+    m_pos = 0;
+  }
+}
+
+void HtmlStream::produceRow(const Part& part) {
+  const bool is_form = part.kind == Part::kFormTable;
+  const auto& vars = part.vg->variables();
+  // Position 0 opens the table, positions 1..N are variables, and N+1 closes the table.
+  if (m_pos == 0) {
+    m_pending += is_form ? "<form method=\"get\"><table>\n" : "<table>\n";
+  } else if (m_pos <= vars.size()) {
+    const VariableBase* var = vars[m_pos - 1];
+    if (!is_form || (var->flags() & VariableBase::Flags::kSettable)) {
+      m_pending += "<tr><td>";
+      appendEscaped(&m_pending, var->description() ? var->description() : var->name());
+      m_pending += "</td><td>";
+      if (is_form) {
+        produceInput(*var);
+      } else {
+        appendEscaped(&m_pending, var->string().c_str());
+      }
+      m_pending += "</td><td>";
+      if (var->units()) {
+        appendEscaped(&m_pending, var->units());
+      }
+      m_pending += "</td></tr>\n";
+    }
+  } else {
+    m_pending += is_form ? "</table><input type=\"submit\" value=\"Save\"></form>\n" : "</table>\n";
+    m_part += 1;
+    m_pos = 0;
+    return;
+  }
+  m_pos += 1;
+}
+
+void HtmlStream::produceInput(const VariableBase& var) {
+  const String value = var.string();
+  auto attributes = [this, &var, &value](bool with_value) {
+    m_pending += " name=\"";
+    appendEscaped(&m_pending, var.name());
+    m_pending += "\"";
+    if (with_value) {
+      m_pending += " value=\"";
+      appendEscaped(&m_pending, value.c_str());
+      m_pending += "\"";
+    }
+  };
+  // The type of the variable is the type of its JSON value.
+  JsonDocument doc;
+  var.toJson(&doc);
+  const JsonVariantConst json = doc[var.name()];
+  if (json.is<bool>()) {
+    // An unchecked box isn't submitted, so a hidden field after it submits false instead.
+    // The request parameter of the checkbox comes first, and is the one which is read.
+    m_pending += "<input type=\"checkbox\" value=\"true\"";
+    attributes(false);
+    m_pending += json.as<bool>() ? " checked>" : ">";
+    m_pending += "<input type=\"hidden\" value=\"false\"";
+    attributes(false);
+    m_pending += ">";
+  } else if (json.is<float>()) {
+    m_pending += "<input type=\"number\" step=\"any\"";
+    attributes(true);
+    m_pending += ">";
+  } else {
+    m_pending += "<input type=\"text\"";
+    attributes(true);
+    m_pending += ">";
+  }
+}
+
+}  // namespace og3
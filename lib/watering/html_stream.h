@@ -0,0 +1,79 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+#include <og3/variable.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace og3 {
+
+// HtmlStream renders a web page in chunks as the web server sends it, rather than
+//  building the whole page in a String first.
+// A page is a list of parts: static text (which stays in flash), tables of the variables
+//  in a VariableGroup rendered a row at a time, and small snippets such as buttons.
+// Static text may contain {board} and {title}, which are replaced as the page is sent.
+// Variable groups are referenced, not copied, so they must outlive the response.
+class HtmlStream {
+ public:
+  using SnippetFn = std::function<void(String*)>;
+
+  static std::shared_ptr<HtmlStream> create(const char* board, const char* title) {
+    return std::make_shared<HtmlStream>(board, title);
+  }
+
+  HtmlStream(const char* board, const char* title);
+
+  // Add static text, which is not copied.
+  HtmlStream& text(const char* text);
+  // Add a table showing the values of the variables in vg.
+  HtmlStream& table(const VariableGroup& vg);
+  // Add a form for editing the settable variables in vg.  Each is edited by its type: a
+  //  checkbox for a bool, a number field for a number, and a text field otherwise.
+  HtmlStream& formTable(const VariableGroup& vg);
+  // Add a small piece of html generated by fn when it is reached.
+  HtmlStream& snippet(const SnippetFn& fn);
+  // Add a button which links to url.
+  HtmlStream& button(const char* title, const char* url);
+
+  // Set the variables in vg from the values submitted by a form from formTable(), returning
+  //  whether any changed, so settings are only saved when they were edited.
+  static bool readForm(AsyncWebServerRequest* request, VariableGroup* vg);
+
+  // Send the page, wrapped in the standard page header and footer, as a chunked response.
+  static void send(const std::shared_ptr<HtmlStream>& page, AsyncWebServerRequest* request);
+
+  // Fill buffer with up to max_len bytes of the page, returning 0 at the end.
+  size_t fill(uint8_t* buffer, size_t max_len);
+
+ private:
+  struct Part {
+    enum Kind { kText, kTable, kFormTable, kSnippet };
+    explicit Part(Kind kind_) : kind(kind_) {}
+    Kind kind;
+    const char* text = nullptr;
+    const VariableGroup* vg = nullptr;
+    SnippetFn fn;
+  };
+
+  // Append the next piece of the page to m_pending, returning false at the end of the page.
+  bool produce();
+  void produceText(const char* text);
+  void produceRow(const Part& part);
+  void produceInput(const VariableBase& var);
+
+  const String m_board;
+  const String m_title;
+  std::vector<Part> m_parts;
+  // The part being rendered, and the text offset or row within it.
+  size_t m_part = 0;
+  size_t m_pos = 0;
+  String m_pending;
+  size_t m_offset = 0;
+};
+
+}  // namespace og3
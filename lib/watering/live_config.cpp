@@ -0,0 +1,257 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "live_config.h"
+
+#ifndef NATIVE
+#include <WiFi.h>
+#include <esp_wifi.h>
+#endif
+
+#include <cstring>
+
+namespace og3 {
+
+namespace {
+// Reconnecting waits this long so the response to the request is sent first.
+constexpr unsigned long kReconnectDelayMsec = 500;
+// How long the connection has to come back up with new settings before they are rolled back.
+constexpr unsigned long kWifiTrialMsec = 30000;
+constexpr unsigned long kMqttTrialMsec = 20000;
+// The MQTT broker port if the MQTT settings don't have one.
+constexpr uint16_t kDefaultMqttPort = 1883;
+constexpr char kPasswordError[] = "password must have 8-63 characters, or none";
+const char* const kWifiKeys[] = {"essid", "password", "board", nullptr};
+const char* const kMqttKeys[] = {"host", "port", "user", "password", nullptr};
+
+// The broker port in the MQTT settings.
+uint16_t brokerPort(const VariableGroup& variables) {
+  JsonDocument jsondoc;
+  variables.toJson(jsondoc.to<JsonObject>());
+  return jsondoc["port"] | kDefaultMqttPort;
+}
+
+// Check an optional string setting.  Returns error if it is set to something else, or its
+//  length is outside min_len to max_len.
+const char* checkString(JsonObjectConst json, const char* key, size_t min_len, size_t max_len,
+                        const char* error) {
+  JsonVariantConst val = json[key];
+  if (val.isNull()) {
+    return nullptr;
+  }
+  if (!val.is<const char*>()) {
+    return error;
+  }
+  const size_t len = strlen(val.as<const char*>());
+  return (len < min_len || len > max_len) ? error : nullptr;
+}
+}  // namespace
+
+const char LiveConfig::kName[] = "live_config";
+
+LiveConfig::LiveConfig(HAApp* app)
+    : Module(kName, &app->module_system()),
+      m_app(app),
+      m_wifi("wifi", kWifiTrialMsec, kWifiKeys),
+      m_mqtt("mqtt", kMqttTrialMsec, kMqttKeys) {
+  m_wifi.variables = [this]() -> VariableGroup& { return m_app->wifi_manager().variables(); };
+  m_wifi.settings = [this](JsonObject json) {
+    json["essid"] = m_app->wifi_manager().essid();
+    json["password"] = m_app->wifi_manager().password();
+  };
+  m_mqtt.variables = [this]() -> VariableGroup& { return m_app->mqtt_manager().variables(); };
+  m_mqtt.settings = [this](JsonObject json) {
+    json["host"] = m_app->mqtt_manager().host();
+    json["port"] = brokerPort(m_app->mqtt_manager().variables());
+    json["user"] = m_app->mqtt_manager().auth_user();
+    json["password"] = m_app->mqtt_manager().auth_password();
+  };
+  m_mqtt.isConnected = [this]() { return m_app->mqtt_manager().isConnected(); };
+#ifndef NATIVE
+  m_wifi.isConnected = []() { return WiFi.status() == WL_CONNECTED; };
+  // The settings are given to the WiFi driver and the MQTT client, and the connection is
+  //  dropped, so the connection is made again by the usual reconnect logic of the WiFi and
+  //  MQTT managers rather than alongside it.
+  m_wifi.reconnect = [this]() {
+    wifi_config_t config = {};
+    esp_wifi_get_config(WIFI_IF_STA, &config);
+    strncpy(reinterpret_cast<char*>(config.sta.ssid), m_app->wifi_manager().essid().c_str(),
+            sizeof(config.sta.ssid));
+    strncpy(reinterpret_cast<char*>(config.sta.password),
+            m_app->wifi_manager().password().c_str(), sizeof(config.sta.password));
+    esp_wifi_set_config(WIFI_IF_STA, &config);
+    WiFi.reconnect();
+  };
+  m_mqtt.reconnect = [this]() {
+    const auto& mqtt = m_app->mqtt_manager();
+    m_mqtt_host = mqtt.host();
+    m_mqtt_user = mqtt.auth_user();
+    m_mqtt_password = mqtt.auth_password();
+    auto& client = m_app->mqtt_manager().client();
+    client.setServer(m_mqtt_host.c_str(), brokerPort(mqtt.variables()));
+    client.setCredentials(m_mqtt_user.length() ? m_mqtt_user.c_str() : nullptr,
+                          m_mqtt_password.length() ? m_mqtt_password.c_str() : nullptr);
+    client.disconnect();
+  };
+  add_init_fn([this]() {
+    // Count connections as they are made, from the tasks which make them.
+    WiFi.onEvent([this](arduino_event_id_t, arduino_event_info_t) { m_wifi.connects += 1; },
+                 ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    m_app->mqtt_manager().client().onConnect([this](bool) { m_mqtt.connects += 1; });
+  });
+#else
+  m_wifi.isConnected = []() { return false; };
+  m_wifi.reconnect = []() {};
+  m_mqtt.reconnect = []() {};
+#endif
+  add_update_fn([this]() {
+    for (Link* link : {&m_wifi, &m_mqtt}) {
+      if (link->pending.load()) {
+        apply(link);
+        link->pending = false;
+      }
+      check(link);
+      link->status = link->trial.status();
+    }
+  });
+}
+
+const char* LiveConfig::checkWifi(JsonObjectConst json) {
+  if (const char* error = checkString(json, "essid", 1, 32, "essid must have 1-32 characters")) {
+    return error;
+  }
+  if (const char* error = checkString(json, "password", 0, 63, kPasswordError)) {
+    return error;
+  }
+  // WPA2 passphrases have at least 8 characters, and open networks have none.
+  const char* password = json["password"].as<const char*>();
+  if (password && strlen(password) > 0 && strlen(password) < 8) {
+    return kPasswordError;
+  }
+  return checkString(json, "board", 1, 32, "board must have 1-32 characters");
+}
+
+const char* LiveConfig::checkMqtt(JsonObjectConst json) {
+  if (const char* error = checkString(json, "host", 1, 64, "host must have 1-64 characters")) {
+    return error;
+  }
+  if (json["host"].is<const char*>() && strchr(json["host"].as<const char*>(), ' ')) {
+    return "host must not have spaces";
+  }
+  JsonVariantConst port = json["port"];
+  if (!port.isNull() && (!port.is<int>() || port.as<int>() < 1 || port.as<int>() > 65535)) {
+    return "port must be 1-65535";
+  }
+  if (const char* error = checkString(json, "user", 0, 64, "user is too long")) {
+    return error;
+  }
+  return checkString(json, "password", 0, 64, "password is too long");
+}
+
+LiveConfig::Reply LiveConfig::applyWifi(JsonObject json) {
+  if (const char* error = checkWifi(json)) {
+    return {-1, 400, error};
+  }
+  return request(&m_wifi, json);
+}
+
+LiveConfig::Reply LiveConfig::applyMqtt(JsonObject json) {
+  if (const char* error = checkMqtt(json)) {
+    return {-1, 400, error};
+  }
+  return request(&m_mqtt, json);
+}
+
+LiveConfig::Reply LiveConfig::request(Link* link, JsonObjectConst json) {
+  if (link->pending.load() || link->status.load() == ConfigTrial::Status::kApplying) {
+    return {-1, 409, "settings are being applied"};
+  }
+  int updated = 0;
+  for (const char* const* key = link->keys; *key; key++) {
+    updated += json[*key].isNull() ? 0 : 1;
+  }
+  if (updated == 0) {
+    return {0, 500, "no values updated"};
+  }
+  // The loop doesn't read the request until pending is set.
+  link->request = "";
+  serializeJson(json, link->request);
+  link->pending = true;
+  return {updated, 202, "applying"};
+}
+
+void LiveConfig::apply(Link* link) {
+  JsonDocument json;
+  if (deserializeJson(json, link->request.c_str())) {
+    return;
+  }
+  JsonDocument before;
+  link->settings(before.to<JsonObject>());
+  if (link->variables().updateFromJson(json.as<JsonObject>()) == 0) {
+    return;
+  }
+  JsonDocument after;
+  link->settings(after.to<JsonObject>());
+  String previous;
+  String current;
+  serializeJson(before, previous);
+  serializeJson(after, current);
+  if (previous == current) {
+    // Nothing which the connection uses has changed.
+    m_app->config().write_config(link->variables());
+    return;
+  }
+  if (!link->isConnected()) {
+    m_app->config().write_config(link->variables());
+    link->trial.applied();
+    m_app->tasks().runIn(kReconnectDelayMsec, [link]() { link->reconnect(); });
+    log()->logf("%s: applied new settings.", link->name);
+    return;
+  }
+  link->previous = previous;
+  link->trial.begin(millis(), link->connects.load());
+  link->reconnecting = true;
+  m_app->tasks().runIn(kReconnectDelayMsec, [link]() {
+    // The trial counts the connections made from when the connection is restarted.
+    link->trial.begin(millis(), link->connects.load());
+    link->reconnecting = false;
+    link->reconnect();
+  });
+  log()->logf("%s: trying new settings for %lus.", link->name, link->trial.timeoutMsec() / 1000);
+}
+
+void LiveConfig::check(Link* link) {
+  if (!link->trial.applying() || link->reconnecting) {
+    return;
+  }
+  switch (link->trial.update(millis(), link->connects.load())) {
+    case ConfigTrial::Status::kApplied:
+      m_app->config().write_config(link->variables());
+      log()->logf("%s: connected with new settings.", link->name);
+      break;
+    case ConfigTrial::Status::kRolledBack: {
+      JsonDocument jsondoc;
+      deserializeJson(jsondoc, link->previous.c_str());
+      link->variables().updateFromJson(jsondoc.as<JsonObject>());
+      link->reconnect();
+      log()->logf("%s: no connection with new settings, rolled back.", link->name);
+      break;
+    }
+    default:
+      break;
+  }
+  if (!link->trial.applying()) {
+    link->previous = "";
+  }
+}
+
+uint16_t LiveConfig::mqttPort() const {
+  return brokerPort(m_app->mqtt_manager().variables());
+}
+
+void LiveConfig::toJson(JsonObject json) const {
+  json["wifi"] = ConfigTrial::statusName(m_wifi.status.load());
+  json["mqtt"] = ConfigTrial::statusName(m_mqtt.status.load());
+}
+
+}  // namespace og3
@@ -0,0 +1,101 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <og3/ha_app.h>
+#include <og3/module.h>
+
+#include <atomic>
+#include <functional>
+
+#include "config_trial.h"
+
+namespace og3 {
+
+// LiveConfig applies WiFi and MQTT settings from the web API without a reboot, so watering
+//  carries on with its moisture filters and state machines as they were.
+// New settings are checked, and the WiFi station or MQTT client reconnects with them.  They
+//  are only written to flash once the connection comes back up (see ConfigTrial).  If it
+//  doesn't within a timeout, the previous settings are restored and reconnected, so a typo
+//  can't take the device off the network.  A reboot during a trial also restores them,
+//  because they are still in flash.
+// Settings are kept without a trial if there was no connection before the change, such as
+//  when setting up WiFi from the access point.
+// The trial passes when the connection is made again, which is counted from the WiFi and
+//  MQTT connect events.
+// Requests arrive on the web server task, so they are checked there and handed to the
+//  application loop, which applies them and runs the trial.  The status of the latest change
+//  of each kind of settings is reported by toJson().
+class LiveConfig : public Module {
+ public:
+  static const char kName[];
+
+  explicit LiveConfig(HAApp* app);
+
+  static LiveConfig* get(const NameToModule& n2m) { return GetModule<LiveConfig>(n2m, kName); }
+
+  // The response to a request to change settings.
+  struct Reply {
+    // The number of settings updated, or -1 if the settings were rejected.
+    int updated;
+    int http_status;
+    const char* message;
+  };
+  // Apply settings from a PUT /api/wifi or PUT /api/mqtt request, from the web server task.
+  // The settings are applied by the application loop, so updated is the number of settings
+  //  in the request.
+  Reply applyWifi(JsonObject json);
+  Reply applyMqtt(JsonObject json);
+  // The MQTT broker port from the MQTT settings.
+  uint16_t mqttPort() const;
+
+  // Check new settings, returning an error message or nullptr if they are ok.
+  static const char* checkWifi(JsonObjectConst json);
+  static const char* checkMqtt(JsonObjectConst json);
+
+  // Add the status of the latest change of each kind of settings to json.
+  void toJson(JsonObject json) const;
+
+ private:
+  // The settings for one connection, and how to restart it.
+  struct Link {
+    Link(const char* name_, unsigned long timeout_msec, const char* const* keys_)
+        : name(name_), keys(keys_), trial(timeout_msec) {}
+    const char* const name;
+    // The names of the settings, ending with nullptr.
+    const char* const* const keys;
+    // A request from the web server task, as JSON, which is waiting for the loop while
+    //  pending is set.
+    String request;
+    std::atomic<bool> pending{false};
+    // The trial is only used by the loop, which copies its status here for the web server.
+    ConfigTrial trial;
+    // Whether the trial waits for the connection to be restarted.
+    bool reconnecting = false;
+    // The number of connections made, counted from the task which makes them.
+    std::atomic<uint32_t> connects{0};
+    std::atomic<ConfigTrial::Status> status{ConfigTrial::Status::kIdle};
+    // The settings before the trial, as JSON.
+    String previous;
+    std::function<VariableGroup&()> variables;
+    std::function<void(JsonObject)> settings;
+    std::function<bool()> isConnected;
+    std::function<void()> reconnect;
+  };
+
+  Reply request(Link* link, JsonObjectConst json);
+  void apply(Link* link);
+  void check(Link* link);
+
+  HAApp* const m_app;
+  Link m_wifi;
+  Link m_mqtt;
+  // The MQTT client keeps pointers to the strings it connects with.
+  String m_mqtt_host;
+  String m_mqtt_user;
+  String m_mqtt_password;
+};
+
+}  // namespace og3
@@ -0,0 +1,107 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "moisture_kalman.h"
+
+#include <cmath>
+
+#include "watering_constants.h"
+
+namespace og3 {
+
+namespace {
+// Uncertainty of the rate of change before it is measured, in %/hour.
+constexpr float kInitialRateStddev = 1.0f;
+}  // namespace
+
+void MoistureKalman::reset() {
+  m_valid = false;
+  m_secs = 0.0f;
+  m_soaking_ml = 0.0f;
+  for (unsigned i = 0; i < kN; i++) {
+    m_x[i] = 0.0f;
+    for (unsigned j = 0; j < kN; j++) {
+      m_p[i][j] = 0.0f;
+    }
+  }
+}
+
+void MoistureKalman::addDose(float ml) {
+  m_soaking_ml += ml;
+  // The soil may take up water differently than it did for the last dose.
+  m_p[kRise][kRise] += kKalmanRiseVarPerDose;
+}
+
+void MoistureKalman::addReading(float secs, float moisture) {
+  if (!m_valid) {
+    m_valid = true;
+    m_secs = secs;
+    m_x[kLevel] = moisture;
+    m_x[kRate] = 0.0f;
+    m_x[kRise] = kKalmanInitialRisePerMl;
+    m_p[kLevel][kLevel] = kKalmanReadingVar;
+    m_p[kRate][kRate] = kInitialRateStddev * kInitialRateStddev;
+    m_p[kRise][kRise] = kKalmanInitialRisePerMl * kKalmanInitialRisePerMl;
+    return;
+  }
+  if (secs > m_secs) {
+    predict((secs - m_secs) / kSecInHour);
+    m_secs = secs;
+  }
+  update(moisture);
+}
+
+void MoistureKalman::predict(float hours) {
+  // The part of the soaking water which reaches the probe in this time.
+  const float ml = m_soaking_ml * (1.0f - std::exp(-hours * kSecInHour / kKalmanSoakSec));
+  m_soaking_ml -= ml;
+
+  // x = F x, where the level changes by the rate over the time and by the rise per ml.
+  const float f[kN][kN] = {{1.0f, hours, ml}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+  m_x[kLevel] += hours * m_x[kRate] + ml * m_x[kRise];
+
+  // P = F P F' + Q
+  float fp[kN][kN];
+  for (unsigned i = 0; i < kN; i++) {
+    for (unsigned j = 0; j < kN; j++) {
+      fp[i][j] = 0.0f;
+      for (unsigned k = 0; k < kN; k++) {
+        fp[i][j] += f[i][k] * m_p[k][j];
+      }
+    }
+  }
+  for (unsigned i = 0; i < kN; i++) {
+    for (unsigned j = 0; j < kN; j++) {
+      m_p[i][j] = 0.0f;
+      for (unsigned k = 0; k < kN; k++) {
+        m_p[i][j] += fp[i][k] * f[j][k];
+      }
+    }
+  }
+  m_p[kLevel][kLevel] += kKalmanLevelVarPerHour * hours;
+  m_p[kRate][kRate] += kKalmanRateVarPerHour * hours;
+}
+
+void MoistureKalman::update(float moisture) {
+  // The reading measures the level: H = [1 0 0].
+  const float s = m_p[kLevel][kLevel] + kKalmanReadingVar;
+  const float innovation = moisture - m_x[kLevel];
+  float gain[kN];
+  float p_level[kN];
+  for (unsigned i = 0; i < kN; i++) {
+    gain[i] = m_p[i][kLevel] / s;
+    p_level[i] = m_p[kLevel][i];
+  }
+  for (unsigned i = 0; i < kN; i++) {
+    m_x[i] += gain[i] * innovation;
+    for (unsigned j = 0; j < kN; j++) {
+      m_p[i][j] -= gain[i] * p_level[j];
+    }
+  }
+  // Water never dries the soil.
+  if (m_x[kRise] < 0.0f) {
+    m_x[kRise] = 0.0f;
+  }
+}
+
+}  // namespace og3
@@ -0,0 +1,51 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+namespace og3 {
+
+// MoistureKalman estimates the soil moisture level of a plant with a Kalman filter.
+// Its state is the moisture level (%), the rate it changes between doses (%/hour) and the
+//  rise in moisture from each ml of water (%/ml).  Each dose is a control input to the
+//  prediction, so the estimate rises with a dose instead of lagging behind it like a
+//  smoothing filter, and the rise per ml is learned from the readings after each dose.
+// Water soaks down to the probe over a few minutes, so a dose is added to the predicted
+//  level gradually, with time constant kKalmanSoakSec.
+class MoistureKalman {
+ public:
+  MoistureKalman() { reset(); }
+
+  // Forget everything, such as after the probe is moved.
+  void reset();
+
+  // Add a dose of ml of water.
+  void addDose(float ml);
+  // Add a moisture reading at secs, which must not go backwards.
+  void addReading(float secs, float moisture);
+
+  bool valid() const { return m_valid; }
+  // The estimated moisture level at the latest reading.
+  float value() const { return m_x[kLevel]; }
+  // The estimated change in moisture level per hour without watering (negative drying).
+  float ratePerHour() const { return m_x[kRate]; }
+  // The estimated rise in moisture level per ml of water.
+  float riseFromMl() const { return m_x[kRise]; }
+  // The variance of the moisture level estimate.
+  float levelVariance() const { return m_p[kLevel][kLevel]; }
+
+ private:
+  enum { kLevel, kRate, kRise, kN };
+
+  void predict(float hours);
+  void update(float moisture);
+
+  bool m_valid;
+  float m_secs;
+  // Water from doses which has not yet reached the probe.
+  float m_soaking_ml;
+  float m_x[kN];
+  float m_p[kN][kN];
+};
+
+}  // namespace og3
@@ -6,6 +6,10 @@
 #include <og3/constants.h>
 #include <og3/units.h>
 
+#include <algorithm>
+#include <cmath>
+
+#include "adc_linearization.h"
 #include "watering_constants.h"
 
 namespace og3 {
@@ -52,15 +56,52 @@ MoistureSensor::MoistureSensor(const char* name, uint8_t pin, const char* raw_de
       m_delta_percent_per_degC(m_delta_percent_name.c_str(), 0.075, "", "moisture per degC",
                                VariableBase::kSettable | VariableBase::kConfig, 3, cfg_vg) {}
 
-void MoistureSensor::read(long nowMsec) {
-  const float val = m_mapped_adc.read();  // TODO(chrishl): check is reasonable value
+void MoistureSensor::updateLinearization() {
+  m_linear_in_min = m_mapped_adc.in_min();
+  m_linear_in_max = m_mapped_adc.in_max();
+  m_mv_at_in_min = adc::millivolts<adc::Fit11db>(m_linear_in_min);
+  const float span_mv = adc::millivolts<adc::Fit11db>(m_linear_in_max) - m_mv_at_in_min;
+  m_out_per_mv =
+      span_mv == 0.0f ? 0.0f : (m_mapped_adc.out_max() - m_mapped_adc.out_min()) / span_mv;
+}
+
+float MoistureSensor::percentAt(unsigned counts) const {
+  return m_mapped_adc.out_min() +
+         (adc::millivolts<adc::Fit11db>(counts) - m_mv_at_in_min) * m_out_per_mv;
+}
+
+float MoistureSensor::linearize(unsigned counts) const {
+  const float lo = std::min(m_mapped_adc.out_min(), m_mapped_adc.out_max());
+  const float hi = std::max(m_mapped_adc.out_min(), m_mapped_adc.out_max());
+  return std::min(hi, std::max(lo, percentAt(counts)));
+}
+
+void MoistureSensor::read(int64_t uptimeMsec) {
+  // The MappedAnalogSensor reads the raw counts and checks them against the valid range.
+  const float mapped = m_mapped_adc.read();
+  m_failed = m_mapped_adc.readingIsFailed() || !std::isfinite(mapped);
+  if (m_mapped_adc.in_min() != m_linear_in_min || m_mapped_adc.in_max() != m_linear_in_max) {
+    updateLinearization();
+  }
+  const unsigned counts = m_mapped_adc.raw_counts();
+  // The health checks see readings outside of the calibrated range, such as far above 100%
+  //  from a disconnected probe.
+  m_health.add(counts, percentAt(counts), m_failed);
+  if (m_failed) {
+    // Keep the moisture level from the last good reading.
+    return;
+  }
+  const float val = linearize(counts);
+  m_value = val;
   // We noticed that the moisture sensor reading is dependent on temperature, so try to compensate
   //  here.
   const float delta_temp = m_reference_tempC - m_tempC;
   const float delta_moisture = m_delta_percent_per_degC.value() * delta_temp;
   const float adjustedValue = val + delta_moisture;
-  const float secs = 1e-3 * nowMsec;
+  const float secs = 1e-3 * uptimeMsec;
   m_filter.addSample(secs, adjustedValue);
+  m_kalman.addReading(secs, adjustedValue);
+  m_rollup.add(static_cast<uint32_t>(uptimeMsec / kMsecInSec), adjustedValue);
 }
 
 }  // namespace og3
@@ -5,10 +5,21 @@
 #include <og3/mapped_analog_sensor.h>
 #include <og3/variable.h>
 
+#include "moisture_kalman.h"
+#include "rollup.h"
+#include "sensor_health.h"
+
 namespace og3 {
 
 // A wrapper for the capacitative moisture sensor.
-// A kernel-based filter is used to smooth noise in the readings.
+// A kernel-based filter is used to smooth noise in the readings, or optionally a Kalman
+//  filter which knows about doses of water (see MoistureKalman).  Both are kept up to date,
+//  so they can be compared.
+// Raw ADC counts are corrected for the nonlinear response of the ESP32 ADC (see
+//  adc_linearization.h) before they are mapped to percent between the calibration counts,
+//  so readings away from the calibration points are more accurate.  The "<name>" variable
+//  of the MappedAnalogSensor stays the uncorrected linear mapping.
+// Each reading is also checked for the health of the probe (see SensorHealth).
 // There is a minor experimental correction for temperature, because
 //  the moisture sensor reads higher when temperature increases
 class MoistureSensor {
@@ -26,27 +37,49 @@ class MoistureSensor {
   void setDeltaPercentPerDegC(float delta) { m_delta_percent_per_degC = delta; }
 
   // Read the current temperature, and add the reading to the kernel filter using the
-  //  current uptime value.
-  void read(long nowMsec);
+  //  current uptime value, which should not wrap like millis().
+  void read(int64_t uptimeMsec);
 
   // Set the sigmal value for the moisture reading filter.
   // This value is in seconds.
   void setSigma(float sigma) { m_filter.setSigma(sigma); }
 
+  // Whether filteredValue() is the Kalman estimate instead of the kernel filter.
+  void setUseKalman(bool use) { m_use_kalman = use; }
+  bool useKalman() const { return m_use_kalman; }
+  // Add a dose of ml of water to the Kalman estimate.
+  void addDose(float ml) { m_kalman.addDose(ml); }
+
   // Raw ADC counts of the latest moisture sensor reading.
   unsigned rawCounts() const { return m_mapped_adc.raw_counts(); }
-  // Latest moisture sensor reading.
-  float unfilteredValue() const { return m_mapped_adc.value(); }
+  // Latest moisture sensor reading, corrected for the ADC response, within 0-100%.
+  float unfilteredValue() const { return m_value; }
   // Value of the moisture level filter after the latest reading.
-  float filteredValue() const { return m_filter.value(); }
-  // Whether the latest moisture level reading failed.
-  bool readingIsFailed() const { return m_mapped_adc.readingIsFailed(); }
+  float filteredValue() const {
+    return m_use_kalman && m_kalman.valid() ? m_kalman.value() : m_filter.value();
+  }
+  // Whether the latest moisture level reading failed.  The filters and unfilteredValue() are
+  //  not updated by a failed reading.
+  bool readingIsFailed() const { return m_failed; }
+  // Whether the probe looks disconnected, out of soil, stuck or noisy.
+  const SensorHealth& health() const { return m_health; }
+
+  // Min/mean/max summaries of recent moisture readings.
+  const Rollup& rollup() const { return m_rollup; }
 
   const KernelFilter& filter() const { return m_filter; }
+  const MoistureKalman& kalman() const { return m_kalman; }
   const MappedAnalogSensor& adc() const { return m_mapped_adc; }
   MappedAnalogSensor& adc() { return m_mapped_adc; }
 
  private:
+  // Map the corrected millivolts at the calibration counts of the ADC to the output range.
+  void updateLinearization();
+  // The moisture percent at counts, which may be outside of the output range.
+  float percentAt(unsigned counts) const;
+  // The moisture percent at counts, clamped to the output range (0-100%).
+  float linearize(unsigned counts) const;
+
   MappedAnalogSensor m_mapped_adc;
   String m_filtered_name;
   KernelFilter m_filter;
@@ -54,6 +87,17 @@ class MoistureSensor {
   FloatVariable m_delta_percent_per_degC;
   float m_tempC = 20.0f;
   float m_reference_tempC = 20.0f;
+  Rollup m_rollup{{0.0f, 0.5f}};
+  MoistureKalman m_kalman;
+  bool m_use_kalman = false;
+  SensorHealth m_health;
+  float m_value = 0.0f;
+  bool m_failed = false;
+  // The calibration counts for which the mapping below was computed.
+  int m_linear_in_min = -1;
+  int m_linear_in_max = -1;
+  float m_mv_at_in_min = 0.0f;
+  float m_out_per_mv = 0.0f;
 };
 
 }  // namespace og3
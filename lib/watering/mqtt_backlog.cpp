@@ -0,0 +1,138 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "mqtt_backlog.h"
+
+#include <utility>
+
+namespace og3 {
+
+namespace {
+
+// Each message in the overflow file is: topic length (uint8), payload length (uint16,
+//  little-endian), topic, payload.
+constexpr size_t kFileHeaderBytes = 3;
+constexpr size_t kMaxTopicBytes = 0xff;
+constexpr size_t kMaxPayloadBytes = 0xffff;
+
+}  // namespace
+
+MqttBacklog::MqttBacklog(size_t max_ram_bytes, const char* file_path, size_t max_file_bytes)
+    : m_max_ram_bytes(max_ram_bytes),
+      m_file_path(file_path ? file_path : ""),
+      m_max_file_bytes(file_path ? max_file_bytes : 0) {}
+
+MqttBacklog::~MqttBacklog() { clear(); }
+
+void MqttBacklog::push(const char* topic, const char* payload, size_t len) {
+  Message msg{topic, std::string(payload, len)};
+  if (bytes(msg) > m_max_ram_bytes) {
+    m_dropped += 1;
+    return;
+  }
+  m_ram_bytes += bytes(msg);
+  m_ram.push_back(std::move(msg));
+  while (m_ram_bytes > m_max_ram_bytes) {
+    spill(m_ram.front());
+    m_ram_bytes -= bytes(m_ram.front());
+    m_ram.pop_front();
+  }
+}
+
+void MqttBacklog::spill(const Message& msg) {
+  const size_t len = kFileHeaderBytes + bytes(msg);
+  if (m_max_file_bytes == 0 || msg.topic.size() > kMaxTopicBytes ||
+      msg.payload.size() > kMaxPayloadBytes ||
+      static_cast<size_t>(m_write_pos) + len > m_max_file_bytes) {
+    m_dropped += 1;
+    return;
+  }
+  if (!m_file) {
+    // This replaces any file left from before a reboot.
+    m_file = fopen(m_file_path.c_str(), "w+b");
+    m_read_pos = m_write_pos = 0;
+    if (!m_file) {
+      m_dropped += 1;
+      return;
+    }
+  }
+  const uint8_t header[kFileHeaderBytes] = {
+      static_cast<uint8_t>(msg.topic.size()), static_cast<uint8_t>(msg.payload.size() & 0xff),
+      static_cast<uint8_t>(msg.payload.size() >> 8)};
+  if (fseek(m_file, m_write_pos, SEEK_SET) != 0 ||
+      fwrite(header, 1, sizeof(header), m_file) != sizeof(header) ||
+      fwrite(msg.topic.data(), 1, msg.topic.size(), m_file) != msg.topic.size() ||
+      fwrite(msg.payload.data(), 1, msg.payload.size(), m_file) != msg.payload.size()) {
+    m_dropped += 1;
+    return;
+  }
+  m_write_pos += len;
+  m_file_count += 1;
+}
+
+bool MqttBacklog::readFile(Message* msg) {
+  uint8_t header[kFileHeaderBytes];
+  if (fseek(m_file, m_read_pos, SEEK_SET) != 0 ||
+      fread(header, 1, sizeof(header), m_file) != sizeof(header)) {
+    return false;
+  }
+  msg->topic.resize(header[0]);
+  msg->payload.resize(header[1] | (header[2] << 8));
+  return fread(&msg->topic[0], 1, msg->topic.size(), m_file) == msg->topic.size() &&
+         fread(&msg->payload[0], 1, msg->payload.size(), m_file) == msg->payload.size();
+}
+
+const MqttBacklog::Message* MqttBacklog::front() {
+  if (m_file_count > 0) {
+    if (!m_have_file_front) {
+      if (!readFile(&m_file_front)) {
+        // The rest of the file is unreadable.
+        m_dropped += m_file_count;
+        m_file_count = 0;
+        fclose(m_file);
+        m_file = nullptr;
+        remove(m_file_path.c_str());
+        return front();
+      }
+      m_have_file_front = true;
+    }
+    return &m_file_front;
+  }
+  return m_ram.empty() ? nullptr : &m_ram.front();
+}
+
+void MqttBacklog::pop() {
+  if (m_file_count > 0) {
+    if (!m_have_file_front && !front()) {
+      return;
+    }
+    m_read_pos += kFileHeaderBytes + bytes(m_file_front);
+    m_have_file_front = false;
+    m_file_count -= 1;
+    if (m_file_count == 0) {
+      // Start the file again from the beginning the next time it is needed.
+      fclose(m_file);
+      m_file = nullptr;
+      remove(m_file_path.c_str());
+    }
+    return;
+  }
+  if (!m_ram.empty()) {
+    m_ram_bytes -= bytes(m_ram.front());
+    m_ram.pop_front();
+  }
+}
+
+void MqttBacklog::clear() {
+  m_ram.clear();
+  m_ram_bytes = 0;
+  if (m_file) {
+    fclose(m_file);
+    m_file = nullptr;
+    remove(m_file_path.c_str());
+  }
+  m_file_count = 0;
+  m_have_file_front = false;
+}
+
+}  // namespace og3
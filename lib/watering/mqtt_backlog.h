@@ -0,0 +1,73 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+
+namespace og3 {
+
+// MqttBacklog holds MQTT messages which could not be sent while the broker was unreachable,
+//  so they can be sent after reconnecting, oldest first.
+// The newest messages are kept in RAM, up to max_ram_bytes.  When RAM is full, the oldest
+//  are moved to an overflow file (if given) of up to max_file_bytes, which starts again
+//  when all of its messages have been sent.  When both are full, messages from the middle
+//  of the outage are dropped, which keeps its start and the most recent messages.
+// The overflow file is read and written with stdio, so on the device it should be under
+//  the LittleFS mount point, such as /littlefs/mqtt_backlog.bin.
+class MqttBacklog {
+ public:
+  struct Message {
+    std::string topic;
+    std::string payload;
+  };
+
+  explicit MqttBacklog(size_t max_ram_bytes, const char* file_path = nullptr,
+                       size_t max_file_bytes = 0);
+  ~MqttBacklog();
+  MqttBacklog(const MqttBacklog&) = delete;
+  MqttBacklog& operator=(const MqttBacklog&) = delete;
+
+  void push(const char* topic, const char* payload, size_t len);
+
+  bool empty() const { return m_file_count == 0 && m_ram.empty(); }
+  // The number of messages held.
+  size_t size() const { return m_file_count + m_ram.size(); }
+  // Messages dropped because the backlog was full.
+  size_t dropped() const { return m_dropped; }
+
+  // The oldest message, or nullptr if there is none.  It stays valid until pop().
+  const Message* front();
+  // Remove the message returned by front().
+  void pop();
+
+  // Drop every message and remove the overflow file.
+  void clear();
+
+ private:
+  static size_t bytes(const Message& msg) { return msg.topic.size() + msg.payload.size(); }
+  void spill(const Message& msg);
+  bool readFile(Message* msg);
+
+  const size_t m_max_ram_bytes;
+  const std::string m_file_path;
+  const size_t m_max_file_bytes;
+
+  std::deque<Message> m_ram;
+  size_t m_ram_bytes = 0;
+  // The overflow file, with messages from m_read_pos to m_write_pos.
+  FILE* m_file = nullptr;
+  long m_read_pos = 0;
+  long m_write_pos = 0;
+  size_t m_file_count = 0;
+  // The message at the front, read from the file.
+  Message m_file_front;
+  bool m_have_file_front = false;
+  size_t m_dropped = 0;
+};
+
+}  // namespace og3
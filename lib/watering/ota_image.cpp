@@ -0,0 +1,308 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "ota_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace og3 {
+
+namespace ota_image {
+
+namespace {
+
+constexpr uint8_t kMagic[4] = {'P', '1', '3', 'Z'};
+constexpr size_t kWindowMask = kWindowBytes - 1;
+
+// CRC-32 of each value of 4 bits.
+constexpr uint32_t kCrcTable[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4,
+    0x4db26158, 0x5005713c, 0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+};
+
+// The compressor finds matches through chains of earlier positions with the same hash of
+//  their first kMinMatch bytes, following at most kMaxChain links.
+constexpr unsigned kHashBits = 15;
+constexpr unsigned kMaxChain = 256;
+
+void putU32(uint32_t value, std::vector<uint8_t>* out) {
+  for (unsigned i = 0; i < 4; i++) {
+    out->push_back((value >> (8 * i)) & 0xff);
+  }
+}
+
+uint32_t getU32(const uint8_t* data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+}  // namespace
+
+uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ kCrcTable[crc & 0xf];
+    crc = (crc >> 4) ^ kCrcTable[crc & 0xf];
+  }
+  return ~crc;
+}
+
+void compress(const uint8_t* image, size_t len, std::vector<uint8_t>* out) {
+  out->clear();
+  out->reserve(kHeaderBytes + len);
+  for (uint8_t byte : kMagic) {
+    out->push_back(byte);
+  }
+  putU32(len, out);
+  putU32(crc32(0, image, len), out);
+
+  std::vector<int32_t> head(1 << kHashBits, -1);
+  std::vector<int32_t> prev(kWindowBytes, -1);
+  auto hash = [image](size_t i) -> unsigned {
+    return ((image[i] << 10) ^ (image[i + 1] << 5) ^ image[i + 2]) & ((1 << kHashBits) - 1);
+  };
+  auto insert = [&](size_t i) {
+    if (i + kMinMatch <= len) {
+      const unsigned h = hash(i);
+      prev[i & kWindowMask] = head[h];
+      head[h] = i;
+    }
+  };
+  // The length of the longest match for position i, or 0 if none is long enough.
+  auto longest = [&](size_t i, unsigned* distance) -> unsigned {
+    if (i + kMinMatch > len) {
+      return 0;
+    }
+    const unsigned max = std::min<size_t>(kMaxMatch, len - i);
+    unsigned best = 0;
+    int32_t j = head[hash(i)];
+    for (unsigned n = 0; j >= 0 && i - j <= kWindowBytes && n < kMaxChain; n++) {
+      unsigned length = 0;
+      while (length < max && image[j + length] == image[i + length]) {
+        length += 1;
+      }
+      if (length > best) {
+        best = length;
+        *distance = i - j;
+        if (length == max) {
+          break;
+        }
+      }
+      // Links older than the window may have been replaced by newer positions.
+      const int32_t next = prev[j & kWindowMask];
+      if (next >= j) {
+        break;
+      }
+      j = next;
+    }
+    return best >= kMinMatch ? best : 0;
+  };
+
+  size_t control = 0;
+  unsigned items = 8;
+  auto addItem = [&](bool match) {
+    if (items == 8) {
+      control = out->size();
+      out->push_back(0);
+      items = 0;
+    }
+    if (match) {
+      (*out)[control] |= 1 << items;
+    }
+    items += 1;
+  };
+
+  for (size_t i = 0; i < len;) {
+    unsigned distance = 0;
+    unsigned length = longest(i, &distance);
+    insert(i);
+    // Send a literal instead if the match from the next byte is longer.
+    unsigned next_distance = 0;
+    if (length > 0 && longest(i + 1, &next_distance) > length) {
+      length = 0;
+    }
+    if (length == 0) {
+      addItem(false);
+      out->push_back(image[i]);
+      i += 1;
+      continue;
+    }
+    addItem(true);
+    const unsigned code = std::min(length - kMinMatch, kExtendedCode);
+    const unsigned token = (code << kWindowBits) | (distance - 1);
+    out->push_back(token & 0xff);
+    out->push_back(token >> 8);
+    if (code == kExtendedCode) {
+      out->push_back(length - kMinMatch - kExtendedCode);
+    }
+    for (size_t k = i + 1; k < i + length; k++) {
+      insert(k);
+    }
+    i += length;
+  }
+}
+
+}  // namespace ota_image
+
+using ota_image::kWindowBytes;
+
+OtaDecoder::OtaDecoder(Sink sink)
+    : m_sink(std::move(sink)), m_window(new uint8_t[kWindowBytes]) {}
+
+// static
+const char* OtaDecoder::statusName(Status status) {
+  switch (status) {
+    case Status::kOk:
+      return "ok";
+    case Status::kBadHeader:
+      return "not a compressed firmware image";
+    case Status::kCorrupt:
+      return "corrupt image";
+    case Status::kSinkFailed:
+      return "failed to write firmware";
+    case Status::kTruncated:
+      return "image is incomplete";
+    case Status::kBadCrc:
+      return "firmware CRC mismatch";
+  }
+  return "?";
+}
+
+bool OtaDecoder::fail(Status status) {
+  m_status = status;
+  return false;
+}
+
+bool OtaDecoder::readHeader() {
+  if (memcmp(m_header, ota_image::kMagic, sizeof(ota_image::kMagic)) != 0) {
+    return fail(Status::kBadHeader);
+  }
+  m_image_size = ota_image::getU32(m_header + 4);
+  m_image_crc = ota_image::getU32(m_header + 8);
+  if (m_image_size == 0) {
+    return fail(Status::kBadHeader);
+  }
+  m_state = State::kControl;
+  return true;
+}
+
+bool OtaDecoder::flush() {
+  if (m_pos > m_flushed) {
+    m_crc = ota_image::crc32(m_crc, m_window.get() + m_flushed, m_pos - m_flushed);
+    if (!m_sink(m_window.get() + m_flushed, m_pos - m_flushed)) {
+      return fail(Status::kSinkFailed);
+    }
+    m_flushed = m_pos;
+  }
+  return true;
+}
+
+bool OtaDecoder::emit(uint8_t byte) {
+  if (m_image_bytes >= m_image_size) {
+    return fail(Status::kCorrupt);
+  }
+  m_window[m_pos++] = byte;
+  m_image_bytes += 1;
+  if (m_pos == kWindowBytes) {
+    if (!flush()) {
+      return false;
+    }
+    m_pos = 0;
+    m_flushed = 0;
+  }
+  return true;
+}
+
+bool OtaDecoder::copyMatch(unsigned distance, unsigned length) {
+  if (distance > m_image_bytes) {
+    return fail(Status::kCorrupt);
+  }
+  for (unsigned i = 0; i < length; i++) {
+    if (!emit(m_window[(m_pos + kWindowBytes - distance) & ota_image::kWindowMask])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool OtaDecoder::write(const uint8_t* data, size_t len) {
+  if (m_status != Status::kOk) {
+    return false;
+  }
+  // Move to the next item of a group, or to the next control byte after the last one.
+  auto nextItem = [this]() {
+    m_control >>= 1;
+    m_state = m_control == 1 ? State::kControl : State::kItem;
+  };
+  for (size_t i = 0; i < len; i++) {
+    const uint8_t byte = data[i];
+    switch (m_state) {
+      case State::kHeader:
+        m_header[m_header_bytes++] = byte;
+        if (m_header_bytes == ota_image::kHeaderBytes && !readHeader()) {
+          return false;
+        }
+        break;
+      case State::kControl:
+        m_control = byte | 0x100;
+        m_state = State::kItem;
+        break;
+      case State::kItem:
+        if (m_control & 1) {
+          m_match_low = byte;
+          m_state = State::kMatchHigh;
+          break;
+        }
+        if (!emit(byte)) {
+          return false;
+        }
+        nextItem();
+        break;
+      case State::kMatchHigh: {
+        const unsigned token = m_match_low | (byte << 8);
+        const unsigned code = token >> ota_image::kWindowBits;
+        m_match_distance = (token & ota_image::kWindowMask) + 1;
+        if (code == ota_image::kExtendedCode) {
+          m_state = State::kMatchExtra;
+          break;
+        }
+        if (!copyMatch(m_match_distance, code + ota_image::kMinMatch)) {
+          return false;
+        }
+        nextItem();
+        break;
+      }
+      case State::kMatchExtra:
+        if (!copyMatch(m_match_distance,
+                       ota_image::kMinMatch + ota_image::kExtendedCode + byte)) {
+          return false;
+        }
+        nextItem();
+        break;
+    }
+  }
+  return flush();
+}
+
+OtaDecoder::Status OtaDecoder::finish() {
+  if (m_status != Status::kOk) {
+    return m_status;
+  }
+  if (!haveHeader() || m_state == State::kMatchHigh || m_state == State::kMatchExtra ||
+      m_image_bytes < m_image_size) {
+    fail(Status::kTruncated);
+    return m_status;
+  }
+  if (!flush()) {
+    return m_status;
+  }
+  if (m_crc != m_image_crc) {
+    fail(Status::kBadCrc);
+  }
+  return m_status;
+}
+
+}  // namespace og3
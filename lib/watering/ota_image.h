@@ -0,0 +1,92 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace og3 {
+
+// Compressed firmware images, for OTA updates over weak WiFi (see OtaUpload).
+// An image is a 12-byte header: "P13Z", the size of the firmware and its CRC-32 (both
+//  little-endian), followed by the firmware compressed with LZSS.  The compressed data is
+//  groups of up to 8 items, each group led by a control byte whose bits, from the lowest,
+//  say whether each item is a literal byte (0) or a 2-byte match (1) of the form
+//  (length code << 13 | distance - 1).  The length is the code + 3, or for code 7,
+//  10 plus a third byte.  Matches refer back up to 8 KB, so that is all the RAM which
+//  decompression needs.
+namespace ota_image {
+
+constexpr size_t kHeaderBytes = 12;
+constexpr unsigned kWindowBits = 13;
+constexpr size_t kWindowBytes = 1 << kWindowBits;
+constexpr unsigned kMinMatch = 3;
+constexpr unsigned kExtendedCode = 7;
+constexpr unsigned kMaxMatch = kMinMatch + kExtendedCode + 255;
+
+// Update a CRC-32 (as used by zlib) with len bytes of data.
+uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len);
+
+// Compress a firmware image, with its header, into *out.  This is for the host tool which
+//  makes images (src/ota_pack), and for tests.
+void compress(const uint8_t* image, size_t len, std::vector<uint8_t>* out);
+
+}  // namespace ota_image
+
+// OtaDecoder decompresses an image as it arrives in chunks of any size, passing the
+//  firmware to a sink in pieces of at most ota_image::kWindowBytes.
+class OtaDecoder {
+ public:
+  enum class Status { kOk, kBadHeader, kCorrupt, kSinkFailed, kTruncated, kBadCrc };
+  // Returns false to stop decompression.
+  using Sink = std::function<bool(const uint8_t* data, size_t len)>;
+
+  explicit OtaDecoder(Sink sink);
+
+  // Decompress the next len bytes of the image, returning false after any error.
+  bool write(const uint8_t* data, size_t len);
+  // Check that the whole firmware arrived intact, after the last write().
+  Status finish();
+
+  Status status() const { return m_status; }
+  static const char* statusName(Status status);
+  // Whether the header has been read, after which imageSize() is known.
+  bool haveHeader() const { return m_state != State::kHeader; }
+  uint32_t imageSize() const { return m_image_size; }
+  // The number of firmware bytes decompressed so far.
+  uint32_t imageBytes() const { return m_image_bytes; }
+
+ private:
+  enum class State : uint8_t { kHeader, kControl, kItem, kMatchHigh, kMatchExtra };
+
+  bool fail(Status status);
+  bool readHeader();
+  bool emit(uint8_t byte);
+  bool copyMatch(unsigned distance, unsigned length);
+  // Pass the bytes decompressed since the last flush to the sink.
+  bool flush();
+
+  Sink m_sink;
+  Status m_status = Status::kOk;
+  State m_state = State::kHeader;
+  uint8_t m_header[ota_image::kHeaderBytes];
+  unsigned m_header_bytes = 0;
+  // Bits of the control byte for the rest of the group, above a 1 which marks its end.
+  unsigned m_control = 0;
+  uint8_t m_match_low = 0;
+  unsigned m_match_distance = 0;
+  uint32_t m_image_size = 0;
+  uint32_t m_image_crc = 0;
+  uint32_t m_image_bytes = 0;
+  uint32_t m_crc = 0;
+  // The latest kWindowBytes of firmware, in a ring, and where the next byte goes in it.
+  std::unique_ptr<uint8_t[]> m_window;
+  size_t m_pos = 0;
+  size_t m_flushed = 0;
+};
+
+}  // namespace og3
@@ -0,0 +1,107 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "ota_upload.h"
+
+#ifndef NATIVE
+#include <ESPAsyncWebServer.h>
+#include <Update.h>
+#endif
+
+namespace og3 {
+
+namespace {
+constexpr char kUser[] = "admin";
+}  // namespace
+
+const char OtaUpload::kName[] = "ota_upload";
+
+OtaUpload::OtaUpload(HAApp* app, const char* password)
+    : Module(kName, &app->module_system()), m_app(app), m_password(password) {
+#ifndef NATIVE
+  app->web_server().on(
+      "/api/ota", HTTP_POST, [this](AsyncWebServerRequest* request) { onRequest(request); },
+      nullptr,
+      [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index,
+             size_t total) { onBody(request, data, len, index); });
+#endif
+}
+
+#ifndef NATIVE
+void OtaUpload::onBody(AsyncWebServerRequest* request, const uint8_t* data, size_t len,
+                       size_t index) {
+  if (index == 0) {
+    // onRequest() answers requests which are not authorized, or which arrive during another
+    //  upload.
+    if (m_request || !request->authenticate(kUser, m_password)) {
+      return;
+    }
+    m_request = request;
+    m_began = false;
+    m_decoder.reset(new OtaDecoder(
+        [this](const uint8_t* firmware, size_t size) { return writeFirmware(firmware, size); }));
+    request->onDisconnect([this, request]() {
+      if (m_request == request) {
+        log()->log("ota: upload disconnected.");
+        abort();
+      }
+    });
+    log()->log("ota: upload started.");
+  }
+  if (m_request == request && m_decoder) {
+    m_decoder->write(data, len);
+  }
+}
+
+bool OtaUpload::writeFirmware(const uint8_t* data, size_t len) {
+  if (!m_began) {
+    if (!Update.begin(m_decoder->imageSize())) {
+      log()->logf("ota: %s.", Update.errorString());
+      return false;
+    }
+    m_began = true;
+  }
+  return Update.write(const_cast<uint8_t*>(data), len) == len;
+}
+
+void OtaUpload::onRequest(AsyncWebServerRequest* request) {
+  if (!request->authenticate(kUser, m_password)) {
+    request->requestAuthentication();
+    return;
+  }
+  if (m_request != request) {
+    request->send(409, "text/plain", "another update is in progress");
+    return;
+  }
+  const OtaDecoder::Status status = m_decoder->finish();
+  if (status != OtaDecoder::Status::kOk) {
+    log()->logf("ota: %s.", OtaDecoder::statusName(status));
+    request->send(400, "text/plain", OtaDecoder::statusName(status));
+    abort();
+    return;
+  }
+  // Update.end() checks the image and makes it the boot partition.
+  if (!Update.end()) {
+    log()->logf("ota: %s.", Update.errorString());
+    request->send(500, "text/plain", Update.errorString());
+    abort();
+    return;
+  }
+  log()->logf("ota: updated %u bytes, restarting.", static_cast<unsigned>(m_decoder->imageSize()));
+  m_request = nullptr;
+  m_decoder.reset();
+  request->send(200, "text/plain", "updated, restarting");
+  m_app->tasks().runIn(1000, []() { ESP.restart(); });
+}
+
+void OtaUpload::abort() {
+  if (m_began) {
+    Update.abort();
+    m_began = false;
+  }
+  m_request = nullptr;
+  m_decoder.reset();
+}
+#endif
+
+}  // namespace og3
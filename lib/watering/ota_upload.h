@@ -0,0 +1,50 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <og3/ha_app.h>
+#include <og3/module.h>
+
+#include <memory>
+
+#include "ota_image.h"
+
+class AsyncWebServerRequest;
+
+namespace og3 {
+
+// OtaUpload takes firmware updates as compressed images (see ota_image.h) at POST /api/ota,
+//  with HTTP authentication as user "admin" and the OTA password.  Images are decompressed
+//  into the OTA partition as they arrive, using only the window of the decoder for RAM.
+//  The device only boots the new firmware if its size and CRC-32 match the header, and
+//  restarts after a successful update.
+// An upload takes less time than with ArduinoOTA because the image is smaller, and web
+//  handlers run in their own task, so the watchdog stays on for the main loop.
+class OtaUpload : public Module {
+ public:
+  static const char kName[];
+
+  OtaUpload(HAApp* app, const char* password);
+
+  static OtaUpload* get(const NameToModule& n2m) { return GetModule<OtaUpload>(n2m, kName); }
+
+  bool inProgress() const { return m_request != nullptr; }
+
+ private:
+#ifndef NATIVE
+  void onBody(AsyncWebServerRequest* request, const uint8_t* data, size_t len, size_t index);
+  void onRequest(AsyncWebServerRequest* request);
+  bool writeFirmware(const uint8_t* data, size_t len);
+  void abort();
+#endif
+
+  HAApp* const m_app;
+  const char* const m_password;
+  // The request which is uploading an image, and the decoder for it.
+  AsyncWebServerRequest* m_request = nullptr;
+  std::unique_ptr<OtaDecoder> m_decoder;
+  bool m_began = false;
+};
+
+}  // namespace og3
@@ -0,0 +1,205 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "plant_router.h"
+
+#ifndef NATIVE
+#include <ESPAsyncWebServer.h>
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace og3 {
+
+namespace {
+
+constexpr char kApiPrefix[] = "/api/plants/";
+constexpr char kPagePrefix[] = "/plant";
+constexpr const char* kPageNames[PlantRouter::kNumPages] = {"status", "config", "pump"};
+
+// Parse a plant number from 1 to kMaxPlants at *str, and move *str past it.
+bool parsePlantNumber(const char** str, unsigned* number) {
+  const char* p = *str;
+  if (*p < '1' || *p > '9') {
+    return false;
+  }
+  unsigned n = 0;
+  while (*p >= '0' && *p <= '9') {
+    n = 10 * n + (*p++ - '0');
+    if (n > PlantRouter::kMaxPlants) {
+      return false;
+    }
+  }
+  *str = p;
+  *number = n;
+  return true;
+}
+
+}  // namespace
+
+const char PlantRouter::kName[] = "plant_router";
+
+#ifndef NATIVE
+// The web server handler.  canHandle() keeps the parsed route with the request, along with
+//  the body of API requests, in the request's _tempObject, which the request frees.
+class PlantRouter::Handler : public AsyncWebHandler {
+ public:
+  explicit Handler(PlantRouter* router) : m_router(router) {}
+
+  bool canHandle(AsyncWebServerRequest* request) const override {
+    Route route;
+    if (!parse(request->url().c_str(), &route) || !m_router->handles(route)) {
+      return false;
+    }
+    if (route.action == kApiPut && request->method() != HTTP_PUT) {
+      return false;
+    }
+    auto* state = static_cast<RequestState*>(malloc(sizeof(RequestState)));
+    if (!state) {
+      return false;
+    }
+    state->route = route;
+    state->len = 0;
+    request->_tempObject = state;
+    return true;
+  }
+
+  void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index,
+                  size_t total) override {
+    auto* state = static_cast<RequestState*>(request->_tempObject);
+    if (!state || state->route.action != kApiPut || total > kMaxBodyBytes) {
+      return;
+    }
+    if (index == 0) {
+      state = static_cast<RequestState*>(realloc(state, sizeof(RequestState) + total));
+      if (!state) {
+        free(request->_tempObject);
+        request->_tempObject = nullptr;
+        return;
+      }
+      request->_tempObject = state;
+    }
+    if (index + len <= total) {
+      memcpy(state->body + index, data, len);
+      state->len = index + len;
+    }
+  }
+
+  void handleRequest(AsyncWebServerRequest* request) override {
+    const auto* state = static_cast<const RequestState*>(request->_tempObject);
+    if (!state) {
+      request->send(500, "text/plain", "out of memory");
+      return;
+    }
+    if (state->route.action == kApiPut && request->contentLength() > kMaxBodyBytes) {
+      request->send(413, "text/plain", "body too large");
+      return;
+    }
+    m_router->dispatch(state->route, request, state->body, state->len);
+  }
+
+  bool isRequestHandlerTrivial() const override { return false; }
+
+ private:
+  struct RequestState {
+    Route route;
+    size_t len;
+    // Extended by realloc() to hold the body.
+    char body[1];
+  };
+
+  PlantRouter* const m_router;
+};
+#endif
+
+PlantRouter::PlantRouter(HAApp* app) : Module(kName, &app->module_system()) {
+#ifndef NATIVE
+  // Add the handler before any others, so per-plant requests don't walk the list.
+  app->web_server().addHandler(new Handler(this));
+#endif
+}
+
+// static
+bool PlantRouter::parse(const char* url, Route* route) {
+  unsigned number = 0;
+  if (strncmp(url, kApiPrefix, sizeof(kApiPrefix) - 1) == 0) {
+    url += sizeof(kApiPrefix) - 1;
+    if (!parsePlantNumber(&url, &number) || *url != '\0') {
+      return false;
+    }
+    route->action = kApiPut;
+    route->plant = number - 1;
+    return true;
+  }
+  if (strncmp(url, kPagePrefix, sizeof(kPagePrefix) - 1) != 0) {
+    return false;
+  }
+  url += sizeof(kPagePrefix) - 1;
+  if (!parsePlantNumber(&url, &number) || *url++ != '/') {
+    return false;
+  }
+  for (unsigned i = 0; i < kNumPages; i++) {
+    if (strcmp(url, kPageNames[i]) == 0) {
+      route->action = static_cast<Action>(i);
+      route->plant = number - 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+// static
+RateLimiter::Endpoint PlantRouter::endpoint(Action action) {
+  switch (action) {
+    case kPumpPage:
+      return RateLimiter::kPumpTest;
+    case kConfigPage:
+    case kApiPut:
+      return RateLimiter::kPlantSettings;
+    case kStatusPage:
+      break;
+  }
+  return RateLimiter::kRootPage;
+}
+
+void PlantRouter::setPage(unsigned plant, Action action, PageFn fn) {
+  if (plant >= kMaxPlants || action >= kNumPages) {
+    return;
+  }
+  if (plant >= m_pages.size()) {
+    m_pages.resize(plant + 1);
+  }
+  m_pages[plant][action] = std::move(fn);
+}
+
+bool PlantRouter::handles(const Route& route) const {
+  if (route.action == kApiPut) {
+    return static_cast<bool>(m_api);
+  }
+  return route.plant < m_pages.size() && m_pages[route.plant][route.action];
+}
+
+void PlantRouter::dispatch(const Route& route, AsyncWebServerRequest* request,
+                           [[maybe_unused]] const char* body, [[maybe_unused]] size_t len) {
+#ifndef NATIVE
+  if (m_limiter && !m_limiter->admit(endpoint(route.action), request)) {
+    return;
+  }
+#endif
+  if (route.action != kApiPut) {
+    m_pages[route.plant][route.action](request);
+    return;
+  }
+#ifndef NATIVE
+  JsonDocument jsondoc;
+  if (deserializeJson(jsondoc, body, len)) {
+    request->send(400, "text/plain", "bad json");
+    return;
+  }
+  m_api(route.plant, request, jsondoc.as<JsonVariant>());
+#endif
+}
+
+}  // namespace og3
@@ -0,0 +1,80 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <og3/ha_app.h>
+#include <og3/module.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "rate_limiter.h"
+#include "watering_constants.h"
+
+class AsyncWebServerRequest;
+
+namespace og3 {
+
+// PlantRouter is one web server handler for the URLs of every plant:
+//   /plant<N>/status, /plant<N>/config, /plant<N>/pump: the web pages of plant N.
+//   PUT /api/plants/<N>: update the settings of plant N from a JSON object.
+// ESPAsyncWebServer tries its handlers one after another, so registering these for each
+//  plant made every request walk a list which grew with the number of plants.  PlantRouter
+//  parses the plant number and action from the URL once, and calls the function for them
+//  from a table.  Plant N in a URL is the plant with index N-1.
+// With a RateLimiter, each request is admitted as endpoint(action) before it is dispatched.
+class PlantRouter : public Module {
+ public:
+  static const char kName[];
+
+  enum Action : uint8_t { kStatusPage, kConfigPage, kPumpPage, kApiPut };
+  static constexpr unsigned kNumPages = kPumpPage + 1;
+  struct Route {
+    Action action;
+    // The index of the plant, from 0.
+    uint8_t plant;
+  };
+  using PageFn = std::function<void(AsyncWebServerRequest*)>;
+  using ApiFn = std::function<void(unsigned plant, AsyncWebServerRequest*, JsonVariant json)>;
+
+  static constexpr unsigned kMaxPlants = ::og3::kMaxPlants;
+  // Larger JSON bodies are refused.
+  static constexpr size_t kMaxBodyBytes = 4096;
+
+  explicit PlantRouter(HAApp* app);
+
+  static PlantRouter* get(const NameToModule& n2m) {
+    return GetModule<PlantRouter>(n2m, kName);
+  }
+
+  // Parse a per-plant URL, returning false for any other URL.
+  static bool parse(const char* url, Route* route);
+
+  // Set the function for a web page of a plant.
+  void setPage(unsigned plant, Action action, PageFn fn);
+  // Set the function for PUT /api/plants/<N>, for all plants.
+  void setApi(ApiFn fn) { m_api = std::move(fn); }
+  void setLimiter(RateLimiter* limiter) { m_limiter = limiter; }
+
+  // The rate limiter endpoint for requests of an action: pump tests run the pump, config
+  //  pages and the API write settings to flash, and status pages are built on request.
+  static RateLimiter::Endpoint endpoint(Action action);
+
+  // Whether there is a function for the route.
+  bool handles(const Route& route) const;
+  void dispatch(const Route& route, AsyncWebServerRequest* request, const char* body,
+                size_t len);
+
+ private:
+  class Handler;
+
+  std::vector<std::array<PageFn, kNumPages>> m_pages;
+  ApiFn m_api;
+  RateLimiter* m_limiter = nullptr;
+};
+
+}  // namespace og3
@@ -0,0 +1,103 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "pump_timer.h"
+
+#include <og3/units.h>
+
+#include <cmath>
+
+#include "uptime.h"
+
+namespace og3 {
+
+PumpTimer::PumpTimer(uint8_t pump_pin, bool on_high, const char* actual_name,
+                     const char* mean_error_name, const char* max_error_name, VariableGroup& vg)
+    : m_pump_pin(pump_pin),
+      m_on_high(on_high),
+      m_actual_msec(actual_name, 0.0f, units::kMilliseconds, "measured pump on time", 0, 1, vg),
+      m_mean_error_msec(mean_error_name, 0.0f, units::kMilliseconds, "mean pump on time error",
+                        0, 2, vg),
+      m_max_error_msec(max_error_name, 0.0f, units::kMilliseconds, "max pump on time error", 0,
+                       2, vg) {
+#ifndef NATIVE
+  const esp_timer_create_args_t args = {
+      .callback = &PumpTimer::onTimer,
+      .arg = this,
+      // The callback runs in the esp_timer task, where it is safe to write a GPIO.
+      .dispatch_method = ESP_TIMER_TASK,
+      .name = "pump",
+      .skip_unhandled_events = false,
+  };
+  esp_timer_create(&args, &m_timer);
+#endif
+}
+
+PumpTimer::~PumpTimer() {
+#ifndef NATIVE
+  if (m_timer) {
+    esp_timer_stop(m_timer);
+    esp_timer_delete(m_timer);
+  }
+#endif
+}
+
+// static
+void PumpTimer::onTimer(void* arg) {
+  auto* timer = static_cast<PumpTimer*>(arg);
+  digitalWrite(timer->m_pump_pin, timer->m_on_high ? LOW : HIGH);
+  timer->m_stop_usec = uptimeUsec();
+  timer->m_fired.store(true, std::memory_order_release);
+}
+
+void PumpTimer::start(unsigned msec) {
+  cancel();
+  m_requested_msec = msec;
+  m_fired.store(false, std::memory_order_relaxed);
+  m_fired_seen = false;
+  m_start_usec = uptimeUsec();
+#ifndef NATIVE
+  m_running = true;
+  if (!m_timer || ESP_OK != esp_timer_start_once(m_timer, static_cast<uint64_t>(msec) * 1000)) {
+    // Without the timer the dose ends when the state machine turns off the pump.
+    m_running = false;
+  }
+#endif
+}
+
+bool PumpTimer::fired() {
+  if (!m_running || m_fired_seen || !m_fired.load(std::memory_order_acquire)) {
+    return false;
+  }
+  m_fired_seen = true;
+  return true;
+}
+
+float PumpTimer::finish() {
+  const bool fired = m_running && m_fired.load(std::memory_order_acquire);
+  cancel();
+  // If the timer did not fire, the pump was turned off by the caller just now.
+  const int64_t stop_usec = fired ? m_stop_usec : uptimeUsec();
+  const float actual_msec = (stop_usec - m_start_usec) * 1e-3f;
+  const float error_msec = actual_msec - static_cast<float>(m_requested_msec);
+
+  m_num_doses += 1;
+  m_actual_msec = actual_msec;
+  m_mean_error_msec = m_mean_error_msec.value() + (error_msec - m_mean_error_msec.value()) /
+                                                      static_cast<float>(m_num_doses);
+  if (std::fabs(error_msec) > std::fabs(m_max_error_msec.value())) {
+    m_max_error_msec = error_msec;
+  }
+  return actual_msec;
+}
+
+void PumpTimer::cancel() {
+#ifndef NATIVE
+  if (m_running && m_timer) {
+    esp_timer_stop(m_timer);
+  }
+#endif
+  m_running = false;
+}
+
+}  // namespace og3
@@ -0,0 +1,66 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <Arduino.h>
+#ifndef NATIVE
+#include <esp_timer.h>
+#endif
+#include <og3/variable.h>
+
+#include <atomic>
+
+namespace og3 {
+
+// PumpTimer ends a pump dose at its deadline from an esp_timer callback, so that the
+//  time the pump runs does not depend on how long the main loop takes to come around.
+// The callback only drives the pump pin off, as the relay state is not safe to change from
+//  the timer task.  The watering loop checks fired() on each pass and calls Relay::turnOff()
+//  to update the relay state, so the pump only shows as on for a loop pass after it stops.
+//  At the end of the dose, the state machine calls finish() to get the measured on-time.
+// Under NATIVE there is no timer, and the dose ends when the state machine turns off the
+//  pump, as it did before.
+// Statistics of the difference between measured and requested on-times are kept in vg, as
+//  variables with the given names.
+class PumpTimer {
+ public:
+  PumpTimer(uint8_t pump_pin, bool on_high, const char* actual_name, const char* mean_error_name,
+            const char* max_error_name, VariableGroup& vg);
+  ~PumpTimer();
+
+  // Call this just after turning the pump on, to turn it off msec later.
+  void start(unsigned msec);
+  // Call this after the dose deadline to get the measured on-time of the dose in msec.
+  // The jitter statistics are updated with the result.
+  float finish();
+  // Stop the timer without recording the dose, such as when the pump is turned off early.
+  void cancel();
+
+  bool isRunning() const { return m_running; }
+  // Returns true once after the timer turned the pump off during a dose.
+  bool fired();
+
+ private:
+  static void onTimer(void* arg);
+
+  const uint8_t m_pump_pin;
+  const bool m_on_high;
+#ifndef NATIVE
+  esp_timer_handle_t m_timer = nullptr;
+#endif
+  bool m_running = false;
+  unsigned m_requested_msec = 0;
+  int64_t m_start_usec = 0;
+  // Written by the timer task, read by the main loop after m_fired is set.
+  int64_t m_stop_usec = 0;
+  std::atomic<bool> m_fired{false};
+  bool m_fired_seen = false;
+
+  unsigned m_num_doses = 0;
+  FloatVariable m_actual_msec;
+  FloatVariable m_mean_error_msec;
+  FloatVariable m_max_error_msec;
+};
+
+}  // namespace og3
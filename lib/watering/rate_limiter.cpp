@@ -0,0 +1,114 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "rate_limiter.h"
+
+#ifndef NATIVE
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#endif
+
+#include <cmath>
+
+namespace og3 {
+
+namespace {
+
+// Pump tests and settings are clicked by hand, so these allow a few quick clicks and then
+//  about one every 10 seconds for pumps and settings of plants, or 30 seconds for the
+//  network settings which are rarely changed.  The web dashboard polls the API every few
+//  seconds, which leaves room for several open tabs.
+constexpr RateLimiter::Limit kLimits[RateLimiter::kNumEndpoints] = {
+    {"pumpTest", 2, 6}, {"plants", 4, 6}, {"wifi", 2, 2},
+    {"mqtt", 2, 2},     {"root", 3, 12},  {"api", 10, 120},
+};
+
+constexpr float kMsecPerMin = 60 * 1000;
+
+}  // namespace
+
+TokenBucket::TokenBucket(float burst, float per_minute)
+    : m_burst(burst), m_per_msec(per_minute / kMsecPerMin), m_tokens(burst) {}
+
+void TokenBucket::refill(uint32_t now_msec) {
+  // Unsigned subtraction handles millis() wrapping around.
+  m_tokens += (now_msec - m_last_msec) * m_per_msec;
+  if (m_tokens > m_burst) {
+    m_tokens = m_burst;
+  }
+  m_last_msec = now_msec;
+}
+
+bool TokenBucket::take(uint32_t now_msec) {
+  refill(now_msec);
+  if (m_tokens < 1.0f) {
+    return false;
+  }
+  m_tokens -= 1.0f;
+  return true;
+}
+
+uint32_t TokenBucket::retryAfterSec(uint32_t now_msec) {
+  refill(now_msec);
+  const float secs = std::ceil((1.0f - m_tokens) / m_per_msec / 1000.0f);
+  return secs < 1.0f ? 1 : static_cast<uint32_t>(secs);
+}
+
+RateLimiter::RateLimiter()
+    : m_buckets{{kLimits[0].burst, kLimits[0].per_minute},
+                {kLimits[1].burst, kLimits[1].per_minute},
+                {kLimits[2].burst, kLimits[2].per_minute},
+                {kLimits[3].burst, kLimits[3].per_minute},
+                {kLimits[4].burst, kLimits[4].per_minute},
+                {kLimits[5].burst, kLimits[5].per_minute}} {
+  static_assert(kNumEndpoints == 6, "add a bucket for each endpoint");
+}
+
+// static
+const RateLimiter::Limit& RateLimiter::limit(Endpoint endpoint) { return kLimits[endpoint]; }
+
+uint32_t RateLimiter::admit(Endpoint endpoint, uint32_t now_msec) {
+  if (m_in_flight >= kMaxInFlight) {
+    m_rejected_busy += 1;
+    return 1;
+  }
+  TokenBucket& bucket = m_buckets[endpoint];
+  if (!bucket.take(now_msec)) {
+    m_rejected[endpoint] += 1;
+    return bucket.retryAfterSec(now_msec);
+  }
+  m_in_flight += 1;
+  return 0;
+}
+
+void RateLimiter::release() {
+  if (m_in_flight > 0) {
+    m_in_flight -= 1;
+  }
+}
+
+#ifndef NATIVE
+bool RateLimiter::admit(Endpoint endpoint, AsyncWebServerRequest* request) {
+  const uint32_t retry_sec = admit(endpoint, millis());
+  if (retry_sec == 0) {
+    request->onDisconnect([this]() { release(); });
+    return true;
+  }
+  AsyncWebServerResponse* response =
+      request->beginResponse(429, "text/plain", "too many requests");
+  response->addHeader("Retry-After", String(retry_sec));
+  request->send(response);
+  return false;
+}
+#endif
+
+void RateLimiter::toJson(JsonObject json) const {
+  json["inFlight"] = m_in_flight;
+  JsonObject rejected = json["rejected"].to<JsonObject>();
+  for (unsigned i = 0; i < kNumEndpoints; i++) {
+    rejected[kLimits[i].name] = m_rejected[i];
+  }
+  rejected["busy"] = m_rejected_busy;
+}
+
+}  // namespace og3
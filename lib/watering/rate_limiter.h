@@ -0,0 +1,87 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <ArduinoJson.h>
+
+#include <cstdint>
+
+class AsyncWebServerRequest;
+
+namespace og3 {
+
+// TokenBucket allows bursts of up to `burst` events, refilled at `per_minute`.
+class TokenBucket {
+ public:
+  TokenBucket(float burst, float per_minute);
+
+  // Take a token at now_msec, returning false if there is none.
+  bool take(uint32_t now_msec);
+  // Seconds from now_msec until a token is available, at least 1.
+  uint32_t retryAfterSec(uint32_t now_msec);
+
+ private:
+  void refill(uint32_t now_msec);
+
+  const float m_burst;
+  const float m_per_msec;
+  float m_tokens;
+  uint32_t m_last_msec = 0;
+};
+
+// RateLimiter is admission control for web requests which move pumps, write flash or build
+//  large responses, so a stuck browser tab or a runaway automation can't starve the
+//  watering loop or wear out flash.  Each endpoint has a TokenBucket, and at most
+//  kMaxInFlight admitted requests may be sending responses at once.
+// Requests which are not admitted get "429 Too Many Requests" with a Retry-After header,
+//  and are counted for diagnostics.
+class RateLimiter {
+ public:
+  enum Endpoint {
+    kPumpTest,       // POST /test/pump, /plant<N>/pump
+    kPlantSettings,  // PUT /api/plants/<N>, PATCH /api/plants, /plant<N>/config, /config
+    kWifiSettings,   // PUT /api/wifi
+    kMqttSettings,   // PUT /api/mqtt
+    kRootPage,       // /root, /plant<N>/status
+    kApiRead,        // GET /api/..., including /api/history and /api/trace
+    kNumEndpoints
+  };
+  struct Limit {
+    const char* name;
+    float burst;
+    float per_minute;
+  };
+  static constexpr unsigned kMaxInFlight = 4;
+
+  RateLimiter();
+
+  static const Limit& limit(Endpoint endpoint);
+
+  // Admit a request to endpoint at now_msec, returning 0 if admitted, or else the seconds
+  //  the client should wait before retrying.  Each admitted request must be released.
+  uint32_t admit(Endpoint endpoint, uint32_t now_msec);
+  void release();
+
+#ifndef NATIVE
+  // Admit a request, or send it a 429 response and return false.  An admitted request is
+  //  released when its connection closes.
+  bool admit(Endpoint endpoint, AsyncWebServerRequest* request);
+#endif
+
+  unsigned inFlight() const { return m_in_flight; }
+  uint32_t rejected(Endpoint endpoint) const { return m_rejected[endpoint]; }
+  // Requests refused because kMaxInFlight requests were already in flight.
+  uint32_t rejectedBusy() const { return m_rejected_busy; }
+
+  // Write {"inFlight": n, "rejected": {"<endpoint>": n, ..., "busy": n}}.
+  void toJson(JsonObject json) const;
+
+ private:
+  TokenBucket m_buckets[kNumEndpoints];
+  uint32_t m_rejected[kNumEndpoints] = {};
+  uint32_t m_rejected_busy = 0;
+  unsigned m_in_flight = 0;
+};
+
+}  // namespace og3
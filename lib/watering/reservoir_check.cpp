@@ -4,8 +4,11 @@
 #include "reservoir_check.h"
 
 #include <og3/ha_discovery.h>
-#include <og3/html_table.h>
 
+#include <cmath>
+
+#include "html_stream.h"
+#include "uptime.h"
 #include "watering_constants.h"
 
 namespace og3 {
@@ -25,10 +28,21 @@ ReservoirCheck::ReservoirCheck(uint8_t pin, HAApp* app_)
       m_pump_seconds_after_low("pump_after_low", kLowWaterSecsRemaining, units::kSeconds,
                                "pump seconds after low water", kCfgSet, 0, m_cfg_vg),
       m_pump_seconds_remaining("pump_sec_left", kLowWaterSecsRemaining, units::kSeconds,
-                               "reservoir seconds left", 0, 0, m_vg) {
+                               "reservoir seconds left", 0, 0, m_vg),
+      m_capacity_ml("capacity_ml", kReservoirCapacityMl, "ml", "reservoir volume when full",
+                    kCfgSet, 0, m_cfg_vg),
+      m_low_ml("low_ml", kLowWaterSecsRemaining * kPumpFlowMlPerSec, "ml",
+               "reservoir volume at low float level", kCfgSet, 0, m_cfg_vg),
+      m_flow_correction("flow_correction", 1.0f, "", "pump flow correction from float level",
+                        VariableBase::Flags::kConfig, 3, m_cfg_vg),
+      m_liters("water_liters", 0.0f, "L", "estimated water in reservoir", 0, 2, m_vg),
+      m_days_left("water_days_left", 0.0f, "d", "days until reservoir is empty", 0, 1, m_vg) {
   setDependencies(&m_deps);
   add_link_fn([this](og3::NameToModule& name_to_module) -> bool {
     m_config = ConfigInterface::get(name_to_module);
+    m_history = HistoryLog::get(name_to_module);
+    m_trace = TraceLog::get(name_to_module);
+    m_telemetry = Telemetry::get(name_to_module);
     return true;
   });
   add_init_fn([this]() {
@@ -41,6 +55,13 @@ ReservoirCheck::ReservoirCheck(uint8_t pin, HAApp* app_)
         return had->addMeas(json, m_pump_seconds_remaining, ha::device_type::kSensor,
                             ha::device_class::sensor::kDuration);
       });
+      m_deps.ha_discovery()->addDiscoveryCallback([this](HADiscovery* had, JsonDocument* json) {
+        return had->addMeas(json, m_liters, ha::device_type::kSensor,
+                            ha::device_class::sensor::kVolumeStorage);
+      });
+      m_deps.ha_discovery()->addDiscoveryCallback([this](HADiscovery* had, JsonDocument* json) {
+        return had->addMeas(json, m_days_left, ha::device_type::kSensor, nullptr);
+      });
     }
     m_app->web_server().on(
         "/config", [this](AsyncWebServerRequest* request) { this->handleConfigRequest(request); });
@@ -51,23 +72,92 @@ void ReservoirCheck::read() {
   m_din.read();
   if (floatIsFloating()) {
     m_pump_seconds_remaining = m_pump_seconds_after_low.value();
+    m_budget.stop();
+  } else if (!m_budget.active()) {
+    m_budget.start(secondsRemaining());
+  }
+  const int is_floating = floatIsFloating() ? 1 : 0;
+  if (m_history && m_history_float != is_floating) {
+    m_history->addReservoir(is_floating);
+    m_history_float = is_floating;
+  }
+  if (m_last_float != is_floating) {
+    if (m_trace) {
+      m_trace->addFloat(is_floating);
+    }
+    onFloatChange(is_floating);
+    m_last_float = is_floating;
+  }
+  decayUsage();
+  // Days until empty at the recent rate of use.
+  const float ml_per_day = m_recent_use_ml * kSecInDay / kReservoirUsageTauSec;
+  m_days_left = ml_per_day > 0.0f ? 1e3f * m_liters.value() / ml_per_day : 0.0f;
+}
+
+void ReservoirCheck::onFloatChange(bool is_floating) {
+  if (is_floating) {
+    // Assume that the reservoir was filled up, including when the device boots.
+    m_liters = 1e-3f * m_capacity_ml.value();
+    m_pumped_since_refill_ml = 0.0f;
+    m_saw_refill = m_last_float >= 0;
+    return;
+  }
+  if (m_saw_refill && m_pumped_since_refill_ml > 0.0f) {
+    // The water from full to the low float level is now known, so correct the flow calibration
+    //  by how far the estimate was off.  Smooth the correction in case of a partial refill.
+    const float actual_ml = m_capacity_ml.value() - m_low_ml.value();
+    const float ratio = actual_ml / m_pumped_since_refill_ml;
+    if (actual_ml > 0.0f && ratio > 0.25f && ratio < 4.0f) {
+      m_flow_correction = std::sqrt(m_flow_correction.value() * ratio);
+      if (m_config) {
+        m_config->write_config(m_cfg_vg);
+      }
+    }
   }
+  m_liters = 1e-3f * m_low_ml.value();
+  m_saw_refill = false;
+}
+
+void ReservoirCheck::decayUsage() {
+  const unsigned long now_msec = millis();
+  const float dsecs = 1e-3f * elapsedMsec(now_msec, m_usage_msec);
+  m_usage_msec = now_msec;
+  m_recent_use_ml *= std::exp(-dsecs / kReservoirUsageTauSec);
 }
-void ReservoirCheck::pumpRanForMsec(float msecs) {
+
+void ReservoirCheck::pumpRanForMsec(unsigned plant, float msecs, float ml) {
+  m_budget.addUsedSec(plant, 1.0e-3f * msecs);
   if (!floatIsFloating()) {
     const float remaining = m_pump_seconds_remaining.value() - 1.0e-3 * msecs;
     m_pump_seconds_remaining = remaining > 0.0f ? remaining : 0.0f;
   }
+  const float corrected_ml = ml * m_flow_correction.value();
+  // The estimate uses the uncorrected volume to measure the correction at the next low level.
+  m_pumped_since_refill_ml += ml;
+  const float liters = m_liters.value() - 1e-3f * corrected_ml;
+  m_liters = liters > 0.0f ? liters : 0.0f;
+  decayUsage();
+  m_recent_use_ml += corrected_ml;
+}
+
+void ReservoirCheck::mqttUpdate() {
+  if (m_telemetry) {
+    m_telemetry->mqttSend(m_vg);
+  } else {
+    m_app->mqttSend(m_vg);
+  }
 }
 
 void ReservoirCheck::handleConfigRequest(AsyncWebServerRequest* request) {
 #ifndef NATIVE
-  ::og3::read(*request, m_cfg_vg);
-  m_html.clear();
-  html::writeFormTableInto(&m_html, m_cfg_vg);
-  add_html_button(&m_html, "Back", "/");
-  sendWrappedHTML(request, m_app->board_cname(), this->name(), m_html.c_str());
-  if (m_config) {
+  if (m_limiter && !m_limiter->admit(RateLimiter::kPlantSettings, request)) {
+    return;
+  }
+  const bool changed = HtmlStream::readForm(request, &m_cfg_vg);
+  auto page = HtmlStream::create(m_app->board_cname(), this->name());
+  page->formTable(m_cfg_vg).button("Back", "/");
+  HtmlStream::send(page, request);
+  if (changed && m_config) {
     m_config->write_config(m_cfg_vg);
   }
 #endif
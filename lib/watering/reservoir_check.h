@@ -7,10 +7,21 @@
 #include <og3/ha_dependencies.h>
 #include <og3/oled_display_ring.h>
 
+#include "history_log.h"
+#include "rate_limiter.h"
+#include "telemetry.h"
+#include "trace_log.h"
+#include "water_budget.h"
+
 namespace og3 {
 
 // This module tracks the state of the reservoir level with a float-sensor.
 // The float sensor is checked with a digital input pin.
+// It also estimates the volume of water in the reservoir by subtracting the water pumped in
+//  each dose.  The estimate is reset when the float shows the reservoir was refilled or
+//  dropped to the low level, and the drop is used to correct the pump flow calibration.
+// The recent rate of water use gives a prediction of days until the reservoir is empty.
+// After the float drops, the pump time left is shared among plants by need (WaterBudget).
 class ReservoirCheck : public Module {
  public:
   ReservoirCheck(uint8_t pin, HAApp* app_);
@@ -19,9 +30,30 @@ class ReservoirCheck : public Module {
   bool floatIsFloating() const { return m_din.isHigh(); }
   float secondsRemaining() const { return m_pump_seconds_remaining.value(); }
   bool haveWater() const { return floatIsFloating() || secondsRemaining() > 0.0f; }
-  void pumpRanForMsec(float secs);
+  // Call this after each dose of a plant with the measured pump time and the calibrated
+  //  volume pumped.
+  void pumpRanForMsec(unsigned plant, float msecs, float ml);
+
+  // -- Sharing the pump time left after the float drops.
+  // Set the need of a plant for water: its priority times how far its moisture is below its
+  //  minimum target, or 0.
+  void setWaterNeed(unsigned plant, float need) { m_budget.setNeed(plant, need); }
+  // Whether the pump time left is being shared, because the float dropped.
+  bool rationing() const { return m_budget.active(); }
+  // Pump seconds which a plant may still use from what is left.
+  float pumpSecondsFor(unsigned plant) const {
+    return m_budget.allowanceSec(plant, secondsRemaining());
+  }
+  const WaterBudget& waterBudget() const { return m_budget; }
+
+  // Estimated water in the reservoir, in liters.
+  float liters() const { return m_liters.value(); }
+  // Predicted days until the reservoir is empty at the recent rate of use, or 0 if unknown.
+  float daysLeft() const { return m_days_left.value(); }
   const VariableGroup& variables() const { return m_vg; }
   const VariableGroup& configVariables() const { return m_cfg_vg; }
+  // Apply configuration values such as those written by configVariables().toJson().
+  int updateConfig(JsonObject json) { return m_cfg_vg.updateFromJson(json); }
 
   static const char kName[];
   static const char kConfigUrl[];
@@ -30,22 +62,47 @@ class ReservoirCheck : public Module {
     return GetModule<ReservoirCheck>(n2m, kName);
   }
 
-  void mqttUpdate() { m_app->mqttSend(m_vg); }
+  void mqttUpdate();
   void add_html_status_button(String* body) const { add_html_button(body, name(), "/config"); }
+  // Admit /config requests through limiter, as saving settings writes flash.
+  void setLimiter(RateLimiter* limiter) { m_limiter = limiter; }
 
  private:
   void handleConfigRequest(AsyncWebServerRequest* request);
+  // Reset the volume estimate when the float changes state.
+  void onFloatChange(bool is_floating);
+  // Decay the recent water use to the current time.
+  void decayUsage();
 
   HAApp* const m_app;
+  RateLimiter* m_limiter = nullptr;
   HADependenciesArray<2> m_deps;
   VariableGroup m_cfg_vg;
   VariableGroup m_vg;
   DIn m_din;
   FloatVariable m_pump_seconds_after_low;
   FloatVariable m_pump_seconds_remaining;
+  FloatVariable m_capacity_ml;
+  FloatVariable m_low_ml;
+  FloatVariable m_flow_correction;
+  FloatVariable m_liters;
+  FloatVariable m_days_left;
+  WaterBudget m_budget;
+  // Calibrated ml pumped since the reservoir was last seen to be refilled.
+  float m_pumped_since_refill_ml = 0.0f;
+  bool m_saw_refill = false;
+  // The float state at the last read, or -1 before the first read.
+  int m_last_float = -1;
+  // Exponentially-decayed sum of water used, with time constant kReservoirUsageTauSec.
+  float m_recent_use_ml = 0.0f;
+  unsigned long m_usage_msec = 0;
   ConfigInterface* m_config = nullptr;
+  HistoryLog* m_history = nullptr;
+  TraceLog* m_trace = nullptr;
+  Telemetry* m_telemetry = nullptr;
+  // The float state last written to the history, or -1 if none has been written.
+  int m_history_float = -1;
   OledDisplayRing* m_oled = nullptr;
-  String m_html;
 };
 
 }  // namespace og3
@@ -0,0 +1,80 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "rollup.h"
+
+#include <cstdio>
+
+namespace og3 {
+
+void Rollup::add(uint32_t secs, float value) {
+  m_minute.add(secs, value, m_encoding);
+  m_quarter_hour.add(secs, value, m_encoding);
+  m_hour.add(secs, value, m_encoding);
+}
+
+// static
+uint32_t Rollup::intervalSec(Resolution res) {
+  switch (res) {
+    case kMinute:
+      return 60;
+    case kQuarterHour:
+      return 15 * 60;
+    case kHour:
+      return 60 * 60;
+  }
+  return 60;
+}
+
+// static
+Rollup::Resolution Rollup::resolutionForSec(uint32_t secs) {
+  if (secs >= intervalSec(kHour)) {
+    return kHour;
+  }
+  if (secs >= intervalSec(kQuarterHour)) {
+    return kQuarterHour;
+  }
+  return kMinute;
+}
+
+template <size_t N>
+void Rollup::writeRingJson(const RollupRing<N>& ring, String* out) const {
+  const char* names[] = {"min", "mean", "max"};
+  for (unsigned field = 0; field < 3; field++) {
+    *out += field == 0 ? "{\"" : "],\"";
+    *out += names[field];
+    *out += "\":[";
+    bool first = true;
+    ring.forEach(m_encoding, [out, field, &first](uint32_t, float min, float mean, float max,
+                                                  bool have_data) {
+      if (!first) {
+        *out += ",";
+      }
+      first = false;
+      if (!have_data) {
+        *out += "null";
+        return;
+      }
+      char buf[16];
+      snprintf(buf, sizeof(buf), "%.1f", field == 0 ? min : field == 1 ? mean : max);
+      *out += buf;
+    });
+  }
+  *out += "]}";
+}
+
+void Rollup::writeJson(Resolution res, String* out) const {
+  switch (res) {
+    case kMinute:
+      writeRingJson(m_minute, out);
+      break;
+    case kQuarterHour:
+      writeRingJson(m_quarter_hour, out);
+      break;
+    case kHour:
+      writeRingJson(m_hour, out);
+      break;
+  }
+}
+
+}  // namespace og3
@@ -0,0 +1,153 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#include "uptime.h"
+
+namespace og3 {
+
+// How rollup values are packed into a byte: value = offset + step * code.
+// Code 255 is reserved to mark buckets with no samples.
+struct RollupEncoding {
+  float offset;
+  float step;
+};
+
+// RollupRing keeps min/mean/max summaries of the last N intervals of a series of samples.
+// The summary of the current interval is accumulated as samples are added, and is packed
+//  into the ring when a sample arrives in a later interval.
+template <size_t N>
+class RollupRing {
+ public:
+  static constexpr uint8_t kEmpty = 0xff;
+
+  explicit RollupRing(uint32_t interval_sec) : m_interval_sec(interval_sec) {
+    for (auto& entry : m_entries) {
+      entry = {kEmpty, kEmpty, kEmpty};
+    }
+  }
+
+  uint32_t intervalSec() const { return m_interval_sec; }
+
+  void add(uint32_t secs, float value, const RollupEncoding& enc) {
+    const uint32_t bucket = secs / m_interval_sec;
+    if (m_count > 0 && bucket != m_bucket) {
+      close(enc);
+      // Mark any intervals skipped without samples as empty (at most the whole ring).
+      // If the clock wrapped, the whole ring is out of date.
+      const uint32_t gap = bucket > m_bucket ? bucket - m_bucket - 1 : N;
+      for (uint32_t i = 1; i <= gap && i <= N; i++) {
+        m_entries[(m_bucket + i) % N] = {kEmpty, kEmpty, kEmpty};
+      }
+    }
+    if (m_count == 0 || bucket != m_bucket) {
+      m_bucket = bucket;
+      m_count = 0;
+      m_min = value;
+      m_max = value;
+      m_sum = 0.0f;
+    }
+    m_count += 1;
+    m_sum += value;
+    m_min = value < m_min ? value : m_min;
+    m_max = value > m_max ? value : m_max;
+  }
+
+  // Call fn(start_secs, min, mean, max, have_data) for each interval, oldest first,
+  //  ending with the interval currently being accumulated.
+  template <typename Fn>
+  void forEach(const RollupEncoding& enc, const Fn& fn) const {
+    for (uint32_t k = N; k-- > 0;) {
+      if (m_count == 0 || k > m_bucket) {
+        fn(0, 0.0f, 0.0f, 0.0f, false);
+        continue;
+      }
+      const uint32_t bucket = m_bucket - k;
+      const uint32_t start = bucket * m_interval_sec;
+      if (k == 0) {
+        fn(start, m_min, m_sum / m_count, m_max, true);
+        continue;
+      }
+      const Entry& entry = m_entries[bucket % N];
+      if (entry.mean == kEmpty) {
+        fn(start, 0.0f, 0.0f, 0.0f, false);
+      } else {
+        fn(start, decode(entry.min, enc), decode(entry.mean, enc), decode(entry.max, enc), true);
+      }
+    }
+  }
+
+ private:
+  struct Entry {
+    uint8_t min;
+    uint8_t mean;
+    uint8_t max;
+  };
+
+  static uint8_t encode(float value, const RollupEncoding& enc) {
+    const float code = (value - enc.offset) / enc.step + 0.5f;
+    return code < 0.0f ? 0 : code > kEmpty - 1 ? kEmpty - 1 : static_cast<uint8_t>(code);
+  }
+  static float decode(uint8_t code, const RollupEncoding& enc) {
+    return enc.offset + enc.step * code;
+  }
+
+  void close(const RollupEncoding& enc) {
+    m_entries[m_bucket % N] = {encode(m_min, enc), encode(m_sum / m_count, enc),
+                               encode(m_max, enc)};
+  }
+
+  Entry m_entries[N];
+  const uint32_t m_interval_sec;
+  // The interval being accumulated, counted in units of m_interval_sec since boot.
+  uint32_t m_bucket = 0;
+  uint16_t m_count = 0;
+  float m_min = 0.0f;
+  float m_max = 0.0f;
+  float m_sum = 0.0f;
+};
+
+// Rollup keeps min/mean/max summaries of a series of samples at 1-minute resolution
+//  for the last hour, 15-minute resolution for the last 12 hours, and 1-hour resolution
+//  for the last 2 days, using a bit over 500 bytes per series.
+// Adding a sample updates each resolution in constant time.
+class Rollup {
+ public:
+  enum Resolution {
+    kMinute,
+    kQuarterHour,
+    kHour,
+  };
+
+  explicit Rollup(const RollupEncoding& encoding) : m_encoding(encoding) {}
+
+  // Add a sample, using secs since boot as the time of the sample.
+  void add(uint32_t secs, float value);
+
+  // Append {"min":[...],"mean":[...],"max":[...]} to out for the given resolution.
+  // Intervals are listed oldest first, and intervals without samples are null.
+  void writeJson(Resolution res, String* out) const;
+
+  // Return the interval of the given resolution in seconds.
+  static uint32_t intervalSec(Resolution res);
+  // Return the resolution for a request for an interval, rounding down to a supported one.
+  static Resolution resolutionForSec(uint32_t secs);
+  // The time used to stamp rollup samples.
+  static uint32_t nowSecs() { return static_cast<uint32_t>(uptimeUsec() / 1000000); }
+
+ private:
+  template <size_t N>
+  void writeRingJson(const RollupRing<N>& ring, String* out) const;
+
+  const RollupEncoding m_encoding;
+  RollupRing<60> m_minute{60};
+  RollupRing<48> m_quarter_hour{15 * 60};
+  RollupRing<48> m_hour{60 * 60};
+};
+
+}  // namespace og3
@@ -0,0 +1,79 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "sensor_health.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "watering_constants.h"
+
+namespace og3 {
+
+const char* const SensorHealth::s_status_names[] = {
+    "ok",            // kOk
+    "noisy",         // kNoisy
+    "stuck",         // kStuck
+    "out of soil",   // kOutOfSoil
+    "disconnected",  // kDisconnected
+};
+
+void SensorHealth::Tracker::add(float x) {
+  const int8_t dir = x > value ? 1 : (x < value ? -1 : 0);
+  if (dir == 0) {
+    return;
+  }
+  // Speed up while the values are all on one side, and slow down when they cross.
+  step = dir == direction ? std::min(1.5f * step, kSensorMaxStep)
+                          : std::max(0.5f * step, kSensorMinStep);
+  direction = dir;
+  value += dir * std::min(step, std::fabs(x - value));
+}
+
+void SensorHealth::add(unsigned counts, float percent, bool failed) {
+  m_failed = failed;
+  if (!failed) {
+    if (m_readings == 0) {
+      m_median.value = percent;
+    } else {
+      // Differences are clipped, so that a change of level such as from a dose adds little.
+      const float clip = kSensorDiffClip * noise() + kSensorMinDiffClip;
+      const float diff = std::min(std::fabs(percent - m_last_percent), clip);
+      m_diff_var += kSensorNoiseAlpha * (diff * diff - m_diff_var);
+      m_same_counts = counts == m_last_counts ? m_same_counts + 1 : 0;
+    }
+    m_median.add(percent);
+    m_mad.add(std::fabs(percent - m_median.value));
+    m_last_percent = percent;
+    m_last_counts = counts;
+    m_readings += 1;
+    // Stop calling the probe noisy a little below the threshold, so it doesn't flap.
+    const float sd = noise();
+    m_noisy = sd > kSensorNoisyPercent || (m_noisy && sd > 0.8f * kSensorNoisyPercent);
+  }
+  m_status = classify();
+}
+
+float SensorHealth::noise() const {
+  // The difference of two readings with independent noise has twice its variance.
+  return std::sqrt(0.5f * m_diff_var);
+}
+
+SensorHealth::Status SensorHealth::classify() const {
+  if (m_failed || (m_readings > 0 && m_median.value > kMaxPlausibleMoisture)) {
+    return Status::kDisconnected;
+  }
+  // The latest reading is checked as well as the median, which takes several readings to
+  //  follow a probe pulled out of the soil, while the smoothed moisture may already be low
+  //  enough to water.
+  if (m_readings > 0 &&
+      (m_median.value < kMinPlausibleMoisture || m_last_percent < kMinPlausibleMoisture)) {
+    return Status::kOutOfSoil;
+  }
+  if (m_same_counts + 1 >= kSensorStuckReadings) {
+    return Status::kStuck;
+  }
+  return m_noisy ? Status::kNoisy : Status::kOk;
+}
+
+}  // namespace og3
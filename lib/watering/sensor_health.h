@@ -0,0 +1,68 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <cstdint>
+
+namespace og3 {
+
+// SensorHealth classifies a moisture probe from its stream of readings, using a few floats
+//  of state and a few operations per reading.
+// - The median and MAD (median absolute deviation) of the readings are tracked with steps
+//   which grow while readings stay on one side and halve when they cross, so they follow
+//   a change of level within about 15 readings but are barely moved by outliers.
+// - The variance of the differences between successive readings measures their noise,
+//   without counting the slow changes of the moisture level.  Differences are clipped at a
+//   few times the noise, so a step such as from a dose of water counts for little.
+// Probes are classified as, from the most serious:
+// - disconnected: the latest reading is outside the valid range of the ADC, or the median
+//   is far above 100%.
+// - out of soil: the median is below kMinPlausibleMoisture, as for a probe in air.  A single
+//   reading below it also counts, so a probe pulled out of the soil stops watering at once
+//   rather than after the median has followed it down.
+// - stuck: the ADC counts haven't changed for kSensorStuckReadings readings, which noise
+//   would change for a working probe.
+// - noisy: the noise is more than kSensorNoisyPercent, such as from a loose connection.
+class SensorHealth {
+ public:
+  enum class Status { kOk, kNoisy, kStuck, kOutOfSoil, kDisconnected };
+
+  // Add a reading of raw ADC counts, mapped to percent, and whether the ADC reading failed.
+  void add(unsigned counts, float percent, bool failed);
+
+  Status status() const { return m_status; }
+  // Whether the readings can be trusted to decide when to water.
+  bool canWater() const { return m_status == Status::kOk || m_status == Status::kNoisy; }
+  float median() const { return m_median.value; }
+  float mad() const { return m_mad.value; }
+  // The standard deviation of the noise in the readings, in percent.
+  float noise() const;
+  unsigned readings() const { return m_readings; }
+
+  static const char* const s_status_names[];
+
+ private:
+  // Tracks the median of a stream of values.
+  struct Tracker {
+    void add(float x);
+    float value = 0.0f;
+    float step = 0.0f;
+    int8_t direction = 0;
+  };
+
+  Status classify() const;
+
+  Tracker m_median;
+  Tracker m_mad;
+  float m_diff_var = 0.0f;
+  float m_last_percent = 0.0f;
+  unsigned m_last_counts = 0;
+  unsigned m_same_counts = 0;
+  unsigned m_readings = 0;
+  bool m_failed = false;
+  bool m_noisy = false;
+  Status m_status = Status::kOk;
+};
+
+}  // namespace og3
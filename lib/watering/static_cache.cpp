@@ -0,0 +1,56 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "static_cache.h"
+
+#ifndef NATIVE
+#include <ESPAsyncWebServer.h>
+#endif
+
+#include <cstring>
+
+namespace og3 {
+
+namespace {
+constexpr char kAssetPrefix[] = "/assets/";
+}  // namespace
+
+// static
+StaticCache::Policy StaticCache::policy(const char* url) {
+  if (strncmp(url, kAssetPrefix, sizeof(kAssetPrefix) - 1) == 0) {
+    return Policy::kImmutable;
+  }
+  if (strcmp(url, "/") == 0 || strcmp(url, "/index.html") == 0) {
+    return Policy::kRevalidate;
+  }
+  return Policy::kDefault;
+}
+
+// static
+const char* StaticCache::cacheControl(Policy policy) {
+  switch (policy) {
+    case Policy::kImmutable:
+      return "public, max-age=31536000, immutable";
+    case Policy::kRevalidate:
+      return "no-cache";
+    case Policy::kDefault:
+      break;
+  }
+  return nullptr;
+}
+
+#ifndef NATIVE
+// static
+void StaticCache::install(AsyncWebServer* server) {
+  server->addMiddleware([](AsyncWebServerRequest* request, ArMiddlewareNext next) {
+    next();
+    AsyncWebServerResponse* response = request->getResponse();
+    const char* cache_control = cacheControl(policy(request->url().c_str()));
+    if (response && cache_control && request->method() == HTTP_GET) {
+      response->addHeader("Cache-Control", cache_control, true);
+    }
+  });
+}
+#endif
+
+}  // namespace og3
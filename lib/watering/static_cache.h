@@ -0,0 +1,32 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+class AsyncWebServer;
+
+namespace og3 {
+
+// Cache-Control for the web interface which is built into the firmware (see
+//  build-svelte.sh).  Vite names every script, style and image under /assets/ with a hash
+//  of its contents, so browsers may keep them forever: a new build has new names.  Only the
+//  index page, which names the assets, is checked with its ETag on each visit.  Repeat
+//  visits then cost one conditional request for the index and none for assets.
+class StaticCache {
+ public:
+  enum class Policy {
+    kDefault,     // Leave the response as it is, as for the API.
+    kImmutable,   // Content-hashed assets: cache for a year without checking.
+    kRevalidate,  // The index page: cache, but check the ETag before each use.
+  };
+
+  static Policy policy(const char* url);
+  static const char* cacheControl(Policy policy);
+
+#ifndef NATIVE
+  // Set the Cache-Control header of responses from the server by policy().
+  static void install(AsyncWebServer* server);
+#endif
+};
+
+}  // namespace og3
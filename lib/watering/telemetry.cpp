@@ -0,0 +1,162 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "telemetry.h"
+
+#include <ESPAsyncWebServer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "history_log.h"
+#include "uptime.h"
+#include "watering_constants.h"
+
+namespace og3 {
+
+namespace {
+constexpr unsigned kCfgSet = VariableBase::Flags::kConfig | VariableBase::Flags::kSettable;
+
+#ifdef NATIVE
+const char* const kBacklogFile = nullptr;
+#else
+const char* const kBacklogFile = "/littlefs/mqtt_backlog.bin";
+#endif
+}  // namespace
+
+const char Telemetry::kName[] = "telemetry";
+
+Telemetry::Telemetry(uint16_t tag, HAApp* app)
+    : Module(kName, &app->module_system()),
+      m_app(app),
+      m_codec(tag),
+      m_cfg_vg(kName),
+      m_mqtt_json("mqtt_json", true, "publish JSON to MQTT", kCfgSet, m_cfg_vg),
+      m_mqtt_msgpack("mqtt_msgpack", false, "publish MessagePack to MQTT", kCfgSet, m_cfg_vg),
+      m_backlog(kMqttBacklogRamBytes, kBacklogFile, kMqttBacklogFileBytes) {
+  add_link_fn([this](og3::NameToModule& name_to_module) -> bool {
+    m_config = ConfigInterface::get(name_to_module);
+    return true;
+  });
+  add_init_fn([this]() {
+    if (m_config) {
+      m_config->read_config(m_cfg_vg);
+    }
+#ifndef NATIVE
+    m_app->web_server().on("/api/schema", HTTP_GET, [this](AsyncWebServerRequest* request) {
+      JsonDocument jsondoc;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_codec.schemaJson(jsondoc.to<JsonObject>());
+      }
+      String body;
+      serializeJson(jsondoc, body);
+      request->send(200, "application/json", body);
+    });
+#endif
+  });
+  add_update_fn([this]() { replay(); });
+}
+
+void Telemetry::mqttSend(const VariableGroup& vg, bool event) {
+  if (!m_app->mqtt_manager().isConnected()) {
+    queue(vg, event);
+    return;
+  }
+  if (m_mqtt_json.value()) {
+    m_app->mqttSend(vg);
+  }
+  if (!m_mqtt_msgpack.value()) {
+    return;
+  }
+  JsonDocument jsondoc;
+  vg.toJson(jsondoc.to<JsonObject>(), 0);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_buffer.clear();
+  m_codec.encode(jsondoc, &m_buffer);
+  char topic[96];
+  snprintf(topic, sizeof(topic), "%s/%s/mp", m_app->board_cname(), vg.name());
+  m_app->mqtt_manager().client().publish(topic, 0 /*qos*/, false /*retain*/,
+                                         reinterpret_cast<const char*>(m_buffer.data()),
+                                         m_buffer.size());
+}
+
+void Telemetry::queue(const VariableGroup& vg, bool event) {
+  const unsigned long now = millis();
+  const auto iter = m_queued_msec.find(&vg);
+  if (!event && iter != m_queued_msec.end() &&
+      now - iter->second < kMqttBacklogIntervalMsec) {
+    return;
+  }
+  m_queued_msec[&vg] = now;
+  JsonDocument jsondoc;
+  vg.toJson(jsondoc.to<JsonObject>(), 0);
+  jsondoc["t"] = HistoryLog::nowSecs();
+  String payload;
+  serializeJson(jsondoc, payload);
+  char topic[96];
+  snprintf(topic, sizeof(topic), "%s/%s/backlog", m_app->board_cname(), vg.name());
+  m_backlog.push(topic, payload.c_str(), payload.length());
+}
+
+void Telemetry::replay() {
+  const bool connected = m_app->mqtt_manager().isConnected();
+  const unsigned long now = millis();
+  if (connected && !m_was_connected) {
+    // Let discovery and the current values go out first.
+    m_next_replay_msec = now + kMqttReplayDelayMsec;
+  }
+  m_was_connected = connected;
+  if (!connected || m_backlog.empty() || msecBefore(now, m_next_replay_msec)) {
+    return;
+  }
+  m_next_replay_msec = now + kMqttReplayPeriodMsec;
+  for (unsigned i = 0; i < kMqttReplayBatch; i++) {
+    const MqttBacklog::Message* msg = m_backlog.front();
+    if (!msg) {
+      break;
+    }
+    if (m_app->mqtt_manager().client().publish(msg->topic.c_str(), 0 /*qos*/, false /*retain*/,
+                                               msg->payload.data(), msg->payload.size()) == 0) {
+      // The client's send buffer is full: try again next period.
+      break;
+    }
+    m_backlog.pop();
+  }
+  if (m_backlog.empty()) {
+    log()->logf("Sent MQTT backlog (%zu dropped).", m_backlog.dropped());
+  }
+}
+
+// static
+bool Telemetry::wantsMsgPack(AsyncWebServerRequest* request) {
+  return request->hasHeader("Accept") &&
+         request->getHeader("Accept")->value().indexOf(kMsgPackType) >= 0;
+}
+
+void Telemetry::sendMsgPack(AsyncWebServerRequest* request, JsonVariantConst json) {
+  auto body = std::make_shared<std::vector<uint8_t>>();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_codec.encode(json, body.get());
+  }
+  AsyncWebServerResponse* response = request->beginResponse(
+      kMsgPackType, body->size(), [body](uint8_t* buffer, size_t max_len, size_t index) {
+        const size_t len = std::min(max_len, body->size() - index);
+        memcpy(buffer, body->data() + index, len);
+        return len;
+      });
+  request->send(response);
+}
+
+int Telemetry::updateConfig(JsonObject json) {
+  const int count = m_cfg_vg.updateFromJson(json);
+  if (count > 0 && m_config) {
+    m_config->write_config(m_cfg_vg);
+  }
+  return count;
+}
+
+}  // namespace og3
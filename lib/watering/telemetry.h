@@ -0,0 +1,81 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <og3/config_interface.h>
+#include <og3/ha_app.h>
+#include <og3/module.h>
+#include <og3/variable.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "mqtt_backlog.h"
+#include "telemetry_codec.h"
+
+class AsyncWebServerRequest;
+
+namespace og3 {
+
+// Telemetry publishes variable groups to MQTT as JSON, as MessagePack (see TelemetryCodec),
+//  or both, as configured by the "mqtt_json" and "mqtt_msgpack" settings.
+// MessagePack messages go to the JSON topic with "/mp" appended.  Home Assistant only reads
+//  the JSON topics, so turn JSON off only when nothing uses Home Assistant.
+// The web API sends MessagePack to clients which ask for it with
+//  "Accept: application/msgpack", and GET /api/schema returns the key numbers for both.
+// While MQTT is disconnected, variable groups are queued in an MqttBacklog, and sent after
+//  reconnecting to the group topic with "/backlog" appended, with the time of each reading
+//  in "t".  Home Assistant can't take states with past times, so they don't go to the
+//  group topic.
+class Telemetry : public Module {
+ public:
+  static const char kName[];
+  static constexpr char kMsgPackType[] = "application/msgpack";
+
+  // The tag should differ between boots: see TelemetryCodec.
+  Telemetry(uint16_t tag, HAApp* app);
+
+  static Telemetry* get(const NameToModule& n2m) { return GetModule<Telemetry>(n2m, kName); }
+
+  // Publish the variables of vg in the configured encodings.  While MQTT is disconnected,
+  //  each group is queued every kMqttBacklogIntervalMsec, or immediately for an event.
+  void mqttSend(const VariableGroup& vg, bool event = false);
+
+  // The number of messages waiting to be sent after reconnecting, and the number dropped.
+  size_t backlogSize() const { return m_backlog.size(); }
+  size_t backlogDropped() const { return m_backlog.dropped(); }
+
+  // Whether the client asked for MessagePack.
+  static bool wantsMsgPack(AsyncWebServerRequest* request);
+  // Send json as a MessagePack response.
+  void sendMsgPack(AsyncWebServerRequest* request, JsonVariantConst json);
+
+  const VariableGroup& configVariables() const { return m_cfg_vg; }
+  // Apply settings such as those written by configVariables().toJson(), and save them.
+  int updateConfig(JsonObject json);
+
+ private:
+  void queue(const VariableGroup& vg, bool event);
+  void replay();
+
+  HAApp* const m_app;
+  ConfigInterface* m_config = nullptr;
+  TelemetryCodec m_codec;
+  VariableGroup m_cfg_vg;
+  BoolVariable m_mqtt_json;
+  BoolVariable m_mqtt_msgpack;
+  // The codec is used from the main loop and from web handlers.
+  std::mutex m_mutex;
+  std::vector<uint8_t> m_buffer;
+  MqttBacklog m_backlog;
+  // When each variable group was last queued.
+  std::map<const VariableGroup*, unsigned long> m_queued_msec;
+  bool m_was_connected = false;
+  unsigned long m_next_replay_msec = 0;
+};
+
+}  // namespace og3
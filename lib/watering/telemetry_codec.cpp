@@ -0,0 +1,163 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "telemetry_codec.h"
+
+#include <cstring>
+
+namespace og3 {
+
+namespace {
+
+void put8(uint8_t type, uint8_t val, std::vector<uint8_t>* out) {
+  out->push_back(type);
+  out->push_back(val);
+}
+
+void putBE(uint64_t val, unsigned bytes, std::vector<uint8_t>* out) {
+  for (int shift = 8 * (bytes - 1); shift >= 0; shift -= 8) {
+    out->push_back(static_cast<uint8_t>(val >> shift));
+  }
+}
+
+void putUint(uint64_t val, std::vector<uint8_t>* out) {
+  if (val < 0x80) {
+    out->push_back(static_cast<uint8_t>(val));  // positive fixint
+  } else if (val <= 0xff) {
+    put8(0xcc, val, out);
+  } else if (val <= 0xffff) {
+    out->push_back(0xcd);
+    putBE(val, 2, out);
+  } else if (val <= 0xffffffff) {
+    out->push_back(0xce);
+    putBE(val, 4, out);
+  } else {
+    out->push_back(0xcf);
+    putBE(val, 8, out);
+  }
+}
+
+void putInt(int64_t val, std::vector<uint8_t>* out) {
+  if (val >= 0) {
+    putUint(val, out);
+  } else if (val >= -32) {
+    out->push_back(static_cast<uint8_t>(val));  // negative fixint
+  } else if (val >= INT8_MIN) {
+    put8(0xd0, static_cast<uint8_t>(val), out);
+  } else if (val >= INT16_MIN) {
+    out->push_back(0xd1);
+    putBE(static_cast<uint16_t>(val), 2, out);
+  } else if (val >= INT32_MIN) {
+    out->push_back(0xd2);
+    putBE(static_cast<uint32_t>(val), 4, out);
+  } else {
+    out->push_back(0xd3);
+    putBE(static_cast<uint64_t>(val), 8, out);
+  }
+}
+
+void putFloat(float val, std::vector<uint8_t>* out) {
+  uint32_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+  out->push_back(0xca);
+  putBE(bits, 4, out);
+}
+
+void putStr(const char* str, std::vector<uint8_t>* out) {
+  const size_t len = strlen(str);
+  if (len < 32) {
+    out->push_back(0xa0 | len);
+  } else if (len <= 0xff) {
+    put8(0xd9, len, out);
+  } else {
+    out->push_back(0xda);
+    putBE(len, 2, out);
+  }
+  out->insert(out->end(), str, str + len);
+}
+
+// Array and map headers, with count < 2^16.
+void putHeader(uint8_t fix, uint8_t type16, size_t count, std::vector<uint8_t>* out) {
+  if (count < 16) {
+    out->push_back(fix | count);
+  } else {
+    out->push_back(type16);
+    putBE(count, 2, out);
+  }
+}
+
+}  // namespace
+
+int TelemetryCodec::keyId(const char* key) {
+  const auto it = m_ids.find(key);
+  if (it != m_ids.end()) {
+    return it->second;
+  }
+  if (m_keys.size() >= kMaxKeys) {
+    return -1;
+  }
+  const uint16_t id = m_keys.size();
+  m_keys.push_back(key);
+  m_ids.emplace(key, id);
+  return id;
+}
+
+void TelemetryCodec::encodeValue(JsonVariantConst json, std::vector<uint8_t>* out) {
+  if (json.is<JsonObjectConst>()) {
+    JsonObjectConst obj = json.as<JsonObjectConst>();
+    putHeader(0x80, 0xde, obj.size(), out);
+    for (JsonPairConst kv : obj) {
+      const int id = keyId(kv.key().c_str());
+      if (id >= 0) {
+        putUint(id, out);
+      } else {
+        putStr(kv.key().c_str(), out);
+      }
+      encodeValue(kv.value(), out);
+    }
+  } else if (json.is<JsonArrayConst>()) {
+    JsonArrayConst array = json.as<JsonArrayConst>();
+    putHeader(0x90, 0xdc, array.size(), out);
+    for (JsonVariantConst item : array) {
+      encodeValue(item, out);
+    }
+  } else if (json.is<bool>()) {
+    out->push_back(json.as<bool>() ? 0xc3 : 0xc2);
+  } else if (json.is<int64_t>()) {
+    putInt(json.as<int64_t>(), out);
+  } else if (json.is<uint64_t>()) {
+    putUint(json.as<uint64_t>(), out);
+  } else if (json.is<double>()) {
+    putFloat(json.as<float>(), out);
+  } else if (json.is<const char*>()) {
+    putStr(json.as<const char*>(), out);
+  } else {
+    out->push_back(0xc0);  // nil
+  }
+}
+
+void TelemetryCodec::encode(JsonVariantConst json, std::vector<uint8_t>* out) {
+  // The header has fixed-size fields, and is filled in after the body so that the key count
+  //  includes keys first seen in the body.
+  const size_t start = out->size();
+  out->resize(start + 7);
+  encodeValue(json, out);
+  uint8_t* header = out->data() + start;
+  header[0] = 0x93;  // fixarray of 3
+  header[1] = 0xcd;  // uint16
+  header[2] = m_tag >> 8;
+  header[3] = m_tag & 0xff;
+  header[4] = 0xcd;
+  header[5] = m_keys.size() >> 8;
+  header[6] = m_keys.size() & 0xff;
+}
+
+void TelemetryCodec::schemaJson(JsonObject json) const {
+  json["tag"] = m_tag;
+  JsonArray keys = json["keys"].to<JsonArray>();
+  for (const auto& key : m_keys) {
+    keys.add(key.c_str());
+  }
+}
+
+}  // namespace og3
@@ -0,0 +1,50 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <ArduinoJson.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace og3 {
+
+// TelemetryCodec encodes JSON telemetry as MessagePack with numbered keys, which is several
+//  times smaller than JSON with long keys like "plant1_soil_moisture_filtered".
+//
+// An encoded message is a 3-element array: [tag, key count, body].  The body is the JSON
+//  value with each object key replaced by its number, and floats sent as 32-bit floats.
+// Numbers are given to keys as they are first seen, so a key keeps its number until reboot.
+//  Each boot has a different tag.  A client decodes a message with the key list from the
+//  schema (see schemaJson()), which it fetches again when the tag changes or the key count
+//  is larger than the length of its list.
+// After kMaxKeys keys, new keys are sent as strings.
+class TelemetryCodec {
+ public:
+  static constexpr size_t kMaxKeys = 512;
+
+  explicit TelemetryCodec(uint16_t tag) : m_tag(tag) {}
+
+  // Append the encoding of json to out.
+  void encode(JsonVariantConst json, std::vector<uint8_t>* out);
+
+  // Fill json with {"tag": tag, "keys": [key 0, key 1, ...]}.
+  void schemaJson(JsonObject json) const;
+
+  uint16_t tag() const { return m_tag; }
+  size_t numKeys() const { return m_keys.size(); }
+
+ private:
+  // The number of key, or -1 if there are already kMaxKeys keys.
+  int keyId(const char* key);
+  void encodeValue(JsonVariantConst json, std::vector<uint8_t>* out);
+
+  const uint16_t m_tag;
+  std::vector<std::string> m_keys;
+  std::map<std::string, uint16_t> m_ids;
+};
+
+}  // namespace og3
@@ -0,0 +1,100 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace og3 {
+namespace trace {
+
+// A trace records the inputs to the watering state machines so that a run can be replayed
+//  through the same code on a laptop.  Shared by the device (TraceLog) and the replay test.
+//
+// A trace starts with this magic, a version byte and a spare byte, followed by fixed-size
+//  little-endian records in the order they happened.  A config record is followed by its
+//  JSON text, padded to a multiple of kRecordBytes.
+// Version 2 traces are stored in segments, each starting with a segment record, and a trace
+//  downloaded from a device is the segments of one boot which are still kept.
+constexpr uint8_t kMagic0 = 'P';
+constexpr uint8_t kMagic1 = 'T';
+constexpr uint8_t kVersion = 2;
+constexpr size_t kHeaderBytes = 4;
+constexpr size_t kRecordBytes = 8;
+
+// The kinds of records stored in a trace.
+enum Kind : uint8_t {
+  kKindTick = 1,         // channel=plant, value=raw ADC counts or kNoReading.
+  kKindFloat = 2,        // value=1 if the reservoir float is floating, 0 if water is low.
+  kKindTemperature = 3,  // value=temperature in 0.01 C, as int16.
+  kKindHumidity = 4,     // value=humidity in 0.01 %.
+  kKindEnable = 5,       // channel=plant, value=1 if watering was enabled, 0 if disabled.
+  kKindState = 6,        // channel=plant, value=the state the plant changed to.
+  kKindConfig = 7,       // value=bytes of config JSON which follow.
+  // The millis() value when the modules were created, if not 0.  Devices always boot at 0,
+  //  so only simulations write this, as the first record.
+  kKindBoot = 8,
+  // value=the number of segments before this one since boot, saturating at 0xffff.  Each
+  //  segment after the first repeats the config, so that it can be replayed without them.
+  kKindSegment = 9,
+};
+
+// The value of a tick record when moisture was not read.
+constexpr uint16_t kNoReading = 0xffff;
+
+struct Record {
+  uint32_t msec = 0;
+  Kind kind = kKindTick;
+  uint8_t channel = 0;
+  uint16_t value = 0;
+};
+
+inline void writeHeader(uint8_t* out) {
+  out[0] = kMagic0;
+  out[1] = kMagic1;
+  out[2] = kVersion;
+  out[3] = 0;
+}
+
+inline bool checkHeader(const uint8_t* in) {
+  return in[0] == kMagic0 && in[1] == kMagic1 && in[2] >= 1 && in[2] <= kVersion;
+}
+
+inline void encode(const Record& rec, uint8_t* out) {
+  for (unsigned i = 0; i < 4; i++) {
+    out[i] = static_cast<uint8_t>(rec.msec >> (8 * i));
+  }
+  out[4] = rec.kind;
+  out[5] = rec.channel;
+  out[6] = static_cast<uint8_t>(rec.value);
+  out[7] = static_cast<uint8_t>(rec.value >> 8);
+}
+
+// Returns false if the record is not of a known kind.
+inline bool decode(const uint8_t* in, Record* rec) {
+  rec->msec = 0;
+  for (unsigned i = 0; i < 4; i++) {
+    rec->msec |= static_cast<uint32_t>(in[i]) << (8 * i);
+  }
+  rec->kind = static_cast<Kind>(in[4]);
+  rec->channel = in[5];
+  rec->value = static_cast<uint16_t>(in[6] | (in[7] << 8));
+  return rec->kind >= kKindTick && rec->kind <= kKindSegment;
+}
+
+// Bytes used by the JSON text following a config record.
+inline size_t paddedBytes(size_t len) {
+  return (len + kRecordBytes - 1) / kRecordBytes * kRecordBytes;
+}
+
+// Climate readings are stored in hundredths.  The device rounds readings the same way
+//  before using them, so a replay sees exactly the values the device used.
+inline uint16_t toCenti(float val) {
+  return static_cast<uint16_t>(static_cast<int16_t>(lroundf(val * 100.0f)));
+}
+inline float fromCenti(uint16_t val) { return static_cast<int16_t>(val) / 100.0f; }
+
+}  // namespace trace
+}  // namespace og3
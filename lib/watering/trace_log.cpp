@@ -0,0 +1,346 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "trace_log.h"
+
+#ifndef NATIVE
+#include <LittleFS.h>
+#endif
+#include <og3/constants.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "watering_constants.h"
+
+namespace og3 {
+
+namespace {
+// Trace segments are stored in this directory as files named by sequence number.
+constexpr char kDir[] = "/trace";
+// Where traces were kept before they were split into segments.
+constexpr char kOldPath[] = "/trace.bin";
+constexpr char kOldPrevPath[] = "/trace.prev.bin";
+// A config larger than this is not repeated in later segments.
+constexpr size_t kMaxRepeatedConfigBytes = kTraceSegmentBytes / 4;
+
+#ifndef NATIVE
+void segmentPath(uint32_t segment, char* path, size_t len) {
+  snprintf(path, len, "%s/%08lu.bin", kDir, static_cast<unsigned long>(segment));
+}
+#endif
+}  // namespace
+
+const char TraceLog::kName[] = "trace";
+
+TraceLog::TraceLog(HAApp* app) : Module(kName, &app->module_system()), m_app(app) {
+  add_init_fn([this]() {
+    findSegments();
+#ifndef NATIVE
+    m_app->web_server().on("/api/trace", HTTP_GET, [this](AsyncWebServerRequest* request) {
+      handleTraceRequest(request);
+    });
+#endif
+  });
+  add_update_fn([this]() {
+    if (m_buffer_len > 0 && millis() - m_last_flush_msec >= kHistoryFlushMsec) {
+      flush();
+    }
+  });
+}
+
+void TraceLog::findSegments() {
+#ifndef NATIVE
+  for (const char* path : {kOldPath, kOldPrevPath}) {
+    if (LittleFS.exists(path)) {
+      LittleFS.remove(path);
+    }
+  }
+  if (!LittleFS.exists(kDir) && !LittleFS.mkdir(kDir)) {
+    log()->logf("trace: failed to create %s.", kDir);
+    return;
+  }
+  m_ok = true;
+  // Find the kept segments, and the first segment of the last boot among them, from the
+  //  segment record at the start of each.
+  uint32_t oldest = UINT32_MAX;
+  uint32_t newest = 0;
+  uint32_t newest_boot = 0;
+  size_t bytes = 0;
+  File dir = LittleFS.open(kDir);
+  for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+    const char* slash = strrchr(file.name(), '/');
+    const uint32_t segment = strtoul(slash ? slash + 1 : file.name(), nullptr, 10);
+    uint8_t start[trace::kHeaderBytes + trace::kRecordBytes];
+    trace::Record rec;
+    if (segment == 0 || file.read(start, sizeof(start)) != sizeof(start) ||
+        !trace::checkHeader(start) || !trace::decode(start + trace::kHeaderBytes, &rec) ||
+        rec.kind != trace::kKindSegment) {
+      continue;
+    }
+    bytes += file.size();
+    oldest = std::min(oldest, segment);
+    newest = std::max(newest, segment);
+    if (rec.value == 0) {
+      newest_boot = std::max(newest_boot, segment);
+    }
+  }
+  dir.close();
+  if (newest > 0) {
+    m_segment = newest;
+    m_oldest = oldest;
+    m_kept_bytes = bytes;
+    m_prev_first = std::max(oldest, newest_boot);
+    m_prev_last = newest;
+  }
+#else
+  m_ok = true;
+#endif
+}
+
+void TraceLog::writeSegment(const uint8_t* data, size_t len) {
+#ifndef NATIVE
+  char path[40];
+  segmentPath(m_segment, path, sizeof(path));
+  File file = LittleFS.open(path, "a");
+  if (!file || file.write(data, len) != len) {
+    log()->logf("trace: failed to append to %s.", path);
+  }
+  if (file) {
+    file.close();
+  }
+#else
+  std::vector<uint8_t>& segment = m_segments[m_segment];
+  segment.insert(segment.end(), data, data + len);
+#endif
+}
+
+void TraceLog::removeSegment(uint32_t segment) {
+#ifndef NATIVE
+  char path[40];
+  segmentPath(segment, path, sizeof(path));
+  if (LittleFS.exists(path)) {
+    LittleFS.remove(path);
+  }
+#else
+  m_segments.erase(segment);
+#endif
+}
+
+size_t TraceLog::readSegment(uint32_t segment, size_t offset, uint8_t* data, size_t len) const {
+#ifndef NATIVE
+  char path[40];
+  segmentPath(segment, path, sizeof(path));
+  if (!LittleFS.exists(path)) {
+    return 0;
+  }
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    return 0;
+  }
+  size_t num = 0;
+  if (offset < file.size() && file.seek(offset)) {
+    num = file.read(data, len);
+  }
+  file.close();
+  return num;
+#else
+  const auto it = m_segments.find(segment);
+  if (it == m_segments.end() || offset >= it->second.size()) {
+    return 0;
+  }
+  const size_t num = std::min(len, it->second.size() - offset);
+  memcpy(data, it->second.data() + offset, num);
+  return num;
+#endif
+}
+
+size_t TraceLog::segmentBytes(uint32_t segment) const {
+#ifndef NATIVE
+  char path[40];
+  segmentPath(segment, path, sizeof(path));
+  if (!LittleFS.exists(path)) {
+    return 0;
+  }
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    return 0;
+  }
+  const size_t bytes = file.size();
+  file.close();
+  return bytes;
+#else
+  const auto it = m_segments.find(segment);
+  return it == m_segments.end() ? 0 : it->second.size();
+#endif
+}
+
+void TraceLog::startSegment(unsigned long msec) {
+  flush();
+  if (!m_have_segment) {
+    m_boot_segment = m_segment + 1;
+    m_have_segment = true;
+  }
+  m_segment += 1;
+  // Delete the oldest segments until there is room for a full one.
+  while (m_oldest < m_segment && (m_kept_bytes + kTraceSegmentBytes > kTraceMaxBytes ||
+                                  m_segment - m_oldest >= kTraceMaxSegments)) {
+    m_kept_bytes -= std::min(m_kept_bytes, segmentBytes(m_oldest));
+    removeSegment(m_oldest);
+    m_oldest += 1;
+  }
+  m_segment_bytes = 0;
+  trace::writeHeader(m_buffer);
+  m_buffer_len = trace::kHeaderBytes;
+  const uint32_t index = m_segment - m_boot_segment;
+  addRecord(trace::kKindSegment, 0, std::min<uint32_t>(index, UINT16_MAX), msec, nullptr, 0);
+  if (index > 0 && !m_config.empty()) {
+    addRecord(trace::kKindConfig, 0, m_config.size(), msec, m_config.data(), m_config.size());
+  }
+}
+
+void TraceLog::append(const uint8_t* data, size_t len) {
+  while (len > 0) {
+    if (m_buffer_len == sizeof(m_buffer)) {
+      flush();
+    }
+    const size_t n = std::min(len, sizeof(m_buffer) - m_buffer_len);
+    memcpy(m_buffer + m_buffer_len, data, n);
+    m_buffer_len += n;
+    data += n;
+    len -= n;
+  }
+}
+
+void TraceLog::addRecord(trace::Kind kind, uint8_t channel, uint16_t value, unsigned long msec,
+                         const char* extra, size_t extra_len) {
+  trace::Record rec;
+  rec.msec = static_cast<uint32_t>(msec);
+  rec.kind = kind;
+  rec.channel = channel;
+  rec.value = value;
+  uint8_t data[trace::kRecordBytes];
+  trace::encode(rec, data);
+  append(data, sizeof(data));
+  if (extra_len > 0) {
+    append(reinterpret_cast<const uint8_t*>(extra), extra_len);
+    const uint8_t padding[trace::kRecordBytes] = {};
+    append(padding, trace::paddedBytes(extra_len) - extra_len);
+  }
+}
+
+void TraceLog::add(trace::Kind kind, uint8_t channel, uint16_t value, unsigned long msec,
+                   const char* extra, size_t extra_len) {
+  // Start a segment after boot, or when this record won't fit in the current one.
+  const size_t bytes = trace::kRecordBytes + trace::paddedBytes(extra_len);
+  if (!m_have_segment || m_segment_bytes + m_buffer_len + bytes > kTraceSegmentBytes) {
+    startSegment(msec);
+  }
+  addRecord(kind, channel, value, msec, extra, extra_len);
+}
+
+void TraceLog::addTick(unsigned plant, unsigned long msec, uint16_t raw_counts) {
+  add(trace::kKindTick, plant, raw_counts, msec);
+}
+
+void TraceLog::addFloat(bool floating) { add(trace::kKindFloat, 0, floating ? 1 : 0, millis()); }
+
+void TraceLog::addClimate(float temp_c, float humidity) {
+  const unsigned long msec = millis();
+  add(trace::kKindTemperature, 0, trace::toCenti(temp_c), msec);
+  add(trace::kKindHumidity, 0, trace::toCenti(humidity), msec);
+}
+
+void TraceLog::addEnable(unsigned plant, bool enabled) {
+  add(trace::kKindEnable, plant, enabled ? 1 : 0, millis());
+}
+
+void TraceLog::addState(unsigned plant, unsigned state) {
+  add(trace::kKindState, plant, state, millis());
+}
+
+void TraceLog::addConfig(const char* json, size_t len) {
+  len = std::min(len, static_cast<size_t>(UINT16_MAX));
+  if (len <= kMaxRepeatedConfigBytes) {
+    m_config.assign(json, len);
+  }
+  add(trace::kKindConfig, 0, len, millis(), json, len);
+}
+
+void TraceLog::flush() {
+  m_last_flush_msec = millis();
+  if (m_buffer_len == 0) {
+    return;
+  }
+  if (m_ok) {
+    writeSegment(m_buffer, m_buffer_len);
+  }
+  m_segment_bytes += m_buffer_len;
+  m_kept_bytes += m_buffer_len;
+  m_buffer_len = 0;
+}
+
+TraceLog::Reader::Reader(const TraceLog* log, bool prev) : m_log(log) {
+  const uint32_t oldest = log->oldestSegment();
+  if (prev) {
+    m_segment = std::max(oldest, log->m_prev_first);
+    m_last = log->m_prev_last;
+  } else if (log->m_have_segment) {
+    m_segment = std::max(oldest, log->m_boot_segment);
+    m_last = log->m_segment;
+  }
+}
+
+size_t TraceLog::Reader::read(uint8_t* buffer, size_t max_len) {
+  size_t len = 0;
+  if (!m_header_done) {
+    // The trace starts with one header, and the header of each segment is skipped.
+    uint8_t header[trace::kHeaderBytes];
+    trace::writeHeader(header);
+    const size_t n = std::min(max_len, sizeof(header) - m_offset);
+    memcpy(buffer, header + m_offset, n);
+    len += n;
+    m_offset += n;
+    if (m_offset < sizeof(header)) {
+      return len;
+    }
+    m_header_done = true;
+    m_offset = trace::kHeaderBytes;
+  }
+  while (len < max_len && m_segment <= m_last) {
+    const size_t n = m_log->readSegment(m_segment, m_offset, buffer + len, max_len - len);
+    if (n == 0) {
+      // The end of this segment, or it has been deleted.
+      m_segment += 1;
+      m_offset = trace::kHeaderBytes;
+      continue;
+    }
+    m_offset += n;
+    len += n;
+  }
+  return len;
+}
+
+void TraceLog::handleTraceRequest(AsyncWebServerRequest* request) {
+#ifndef NATIVE
+  if (m_limiter && !m_limiter->admit(RateLimiter::kApiRead, request)) {
+    return;
+  }
+  // Records still buffered in RAM are not included until the next flush, which happens
+  //  within kHistoryFlushMsec.
+  auto reader = std::make_shared<Reader>(this, request->hasParam("prev"));
+  if (!m_ok || !reader->valid()) {
+    request->send(404, "text/plain", "no trace");
+    return;
+  }
+  AsyncWebServerResponse* response = request->beginChunkedResponse(
+      "application/octet-stream", [reader](uint8_t* buffer, size_t max_len, size_t index) {
+        return reader->read(buffer, max_len);
+      });
+  response->addHeader("Content-Disposition", "attachment; filename=\"trace.bin\"");
+  request->send(response);
+#endif
+}
+
+}  // namespace og3
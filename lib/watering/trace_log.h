@@ -0,0 +1,125 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <og3/ha_app.h>
+#include <og3/module.h>
+
+#include <cstdint>
+#include <string>
+
+#ifdef NATIVE
+#include <map>
+#include <vector>
+#endif
+
+#include "rate_limiter.h"
+#include "trace_format.h"
+
+namespace og3 {
+
+// TraceLog records the inputs to the watering state machines from boot in LittleFS: each
+//  state machine update with its raw moisture reading, reservoir float and climate changes,
+//  watering enable changes, and the resulting state changes.
+// The trace is written to numbered segment files of up to kTraceSegmentBytes, and the
+//  oldest are deleted to keep within kTraceMaxBytes, so the last few days are always
+//  recorded.  Each boot starts a new segment, so the trace of a run which over- or
+//  under-watered a plant can still be downloaded after a restart, and as the budget is in
+//  bytes, frequent reboots don't shorten the trace which is kept.
+// Download traces from /api/trace (or /api/trace?prev=1 for the previous boot) and replay
+//  them with the test_replay native test.  If the start of a boot has been deleted, the
+//  trace starts with a later segment, which repeats the config but not the state of the
+//  filters, so its replay shows what happened rather than checking it.
+// Native builds keep the segments in memory, so tests can record and replay a trace.
+class TraceLog : public Module {
+ public:
+  static const char kName[];
+
+  explicit TraceLog(HAApp* app);
+
+  static TraceLog* get(const NameToModule& n2m) { return GetModule<TraceLog>(n2m, kName); }
+
+  // Record a state machine update of a plant at msec, with the raw moisture counts read,
+  //  or trace::kNoReading if moisture was not read.
+  void addTick(unsigned plant, unsigned long msec, uint16_t raw_counts);
+  void addFloat(bool floating);
+  // The readings should already be rounded with trace::fromCenti(trace::toCenti(x)).
+  void addClimate(float temp_c, float humidity);
+  void addEnable(unsigned plant, bool enabled);
+  void addState(unsigned plant, unsigned state);
+  // Record the configuration as loaded at boot, as a JSON object with "plants" like
+  //  GET /api/plants and "reservoir" with the reservoir config variables.
+  void addConfig(const char* json, size_t len);
+
+  // Append any buffered records to flash.
+  void flush();
+  // Admit /api/trace requests through limiter, as they read through flash.
+  void setLimiter(RateLimiter* limiter) { m_limiter = limiter; }
+
+  // Reads the kept segments of one boot as a single trace, oldest first, reading a segment
+  //  at a time so the trace doesn't have to fit in memory.
+  class Reader {
+   public:
+    // Read the trace of this boot, or of the previous boot if prev.
+    Reader(const TraceLog* log, bool prev);
+    // Whether any of the trace is still kept.
+    bool valid() const { return m_segment <= m_last; }
+    // Fill buffer with up to max_len bytes of the trace, returning 0 at the end.
+    size_t read(uint8_t* buffer, size_t max_len);
+
+   private:
+    const TraceLog* const m_log;
+    uint32_t m_segment = 1;
+    uint32_t m_last = 0;
+    // Offset into the current segment, or into the trace header before the first segment.
+    size_t m_offset = 0;
+    bool m_header_done = false;
+  };
+
+  // The number of the segment being written, the oldest segment kept, and the bytes kept.
+  uint32_t segment() const { return m_segment; }
+  uint32_t oldestSegment() const { return m_oldest; }
+  size_t keptBytes() const { return m_kept_bytes + m_buffer_len; }
+
+ private:
+  void add(trace::Kind kind, uint8_t channel, uint16_t value, unsigned long msec,
+           const char* extra = nullptr, size_t extra_len = 0);
+  void addRecord(trace::Kind kind, uint8_t channel, uint16_t value, unsigned long msec,
+                 const char* extra, size_t extra_len);
+  void append(const uint8_t* data, size_t len);
+  void startSegment(unsigned long msec);
+  // Segment storage: files on the device, and memory in native builds.
+  void findSegments();
+  void writeSegment(const uint8_t* data, size_t len);
+  void removeSegment(uint32_t segment);
+  size_t readSegment(uint32_t segment, size_t offset, uint8_t* data, size_t len) const;
+  size_t segmentBytes(uint32_t segment) const;
+  void handleTraceRequest(AsyncWebServerRequest* request);
+
+  HAApp* const m_app;
+  RateLimiter* m_limiter = nullptr;
+  bool m_ok = false;
+  // The segment being written, and whether it has been started since boot.
+  uint32_t m_segment = 0;
+  bool m_have_segment = false;
+  // The first segment of this boot, and the range of segments of the previous boot.
+  uint32_t m_boot_segment = 1;
+  uint32_t m_prev_first = 1;
+  uint32_t m_prev_last = 0;
+  // The oldest segment kept, and the bytes flushed to the kept segments.
+  uint32_t m_oldest = 1;
+  size_t m_kept_bytes = 0;
+  // Bytes flushed to the current segment.
+  size_t m_segment_bytes = 0;
+  // The config recorded at boot, repeated at the start of each segment.
+  std::string m_config;
+  uint8_t m_buffer[256];
+  size_t m_buffer_len = 0;
+  unsigned long m_last_flush_msec = 0;
+#ifdef NATIVE
+  std::map<uint32_t, std::vector<uint8_t>> m_segments;
+#endif
+};
+
+}  // namespace og3
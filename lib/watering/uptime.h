@@ -0,0 +1,44 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#ifndef NATIVE
+#include <esp_timer.h>
+#endif
+
+namespace og3 {
+
+// Microseconds since boot, which does not wrap like millis().
+// Native builds extend millis() across wraps, so that tests can drive this clock.
+inline int64_t uptimeUsec() {
+#ifndef NATIVE
+  return esp_timer_get_time();
+#else
+  static uint32_t s_last_msec = 0;
+  static int64_t s_wraps = 0;
+  const uint32_t msec = static_cast<uint32_t>(millis());
+  if (msec < s_last_msec) {
+    s_wraps += 1;
+  }
+  s_last_msec = msec;
+  return ((s_wraps << 32) + msec) * 1000;
+#endif
+}
+
+// Msec from then until now, as returned by millis(), which is correct when millis() wraps
+//  around every 49.7 days.
+inline uint32_t elapsedMsec(unsigned long now, unsigned long then) {
+  return static_cast<uint32_t>(now - then);
+}
+
+// Whether millis() value now is before deadline, for deadlines less than 24.8 days away.
+inline bool msecBefore(unsigned long now, unsigned long deadline) {
+  return static_cast<int32_t>(static_cast<uint32_t>(now - deadline)) < 0;
+}
+
+}  // namespace og3
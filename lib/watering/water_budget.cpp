@@ -0,0 +1,58 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "water_budget.h"
+
+namespace og3 {
+
+void WaterBudget::start(float secs) {
+  m_active = true;
+  m_budget_sec = secs > 0.0f ? secs : 0.0f;
+  for (unsigned i = 0; i < kMaxPlants; i++) {
+    m_used_sec[i] = 0.0f;
+  }
+}
+
+void WaterBudget::setNeed(unsigned plant, float need) {
+  if (plant < kMaxPlants) {
+    m_need[plant] = need > 0.0f ? need : 0.0f;
+  }
+}
+
+void WaterBudget::addUsedSec(unsigned plant, float secs) {
+  if (m_active && plant < kMaxPlants) {
+    m_used_sec[plant] += secs;
+  }
+}
+
+float WaterBudget::share(unsigned plant) const {
+  if (plant >= kMaxPlants || m_need[plant] <= 0.0f) {
+    return 0.0f;
+  }
+  float total = 0.0f;
+  for (unsigned i = 0; i < kMaxPlants; i++) {
+    total += m_need[i];
+  }
+  return m_need[plant] / total;
+}
+
+float WaterBudget::allowanceSec(unsigned plant, float remaining_secs) const {
+  if (!m_active) {
+    return remaining_secs;
+  }
+  // Share out the water left plus what the plants which still need water have already used,
+  //  so water used by plants which no longer need any isn't counted again.
+  float pool = remaining_secs > 0.0f ? remaining_secs : 0.0f;
+  for (unsigned i = 0; i < kMaxPlants; i++) {
+    if (m_need[i] > 0.0f) {
+      pool += m_used_sec[i];
+    }
+  }
+  const float allowance = share(plant) * pool - usedSec(plant);
+  if (allowance <= 0.0f) {
+    return 0.0f;
+  }
+  return allowance < remaining_secs ? allowance : remaining_secs;
+}
+
+}  // namespace og3
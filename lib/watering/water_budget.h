@@ -0,0 +1,44 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include "watering_constants.h"
+
+namespace og3 {
+
+// WaterBudget shares the pump time left after the reservoir float drops among the plants
+//  which need water most, instead of giving it to whichever plant asks first.
+// The need of a plant is its priority times how far its moisture is below its minimum
+//  target.  Each plant may pump for its share, in proportion to its need, of the water left
+//  plus what the plants which still need water have pumped, less what it has pumped itself.
+//  As plants are watered their needs fall, and the others share what is left.
+class WaterBudget {
+ public:
+  static constexpr unsigned kMaxPlants = ::og3::kMaxPlants;
+
+  // Start sharing secs of pumping, when the float drops.
+  void start(float secs);
+  // Stop sharing, when the reservoir is refilled.
+  void stop() { m_active = false; }
+  bool active() const { return m_active; }
+  float budgetSec() const { return m_budget_sec; }
+
+  void setNeed(unsigned plant, float need);
+  void addUsedSec(unsigned plant, float secs);
+  float needOf(unsigned plant) const { return plant < kMaxPlants ? m_need[plant] : 0.0f; }
+  float usedSec(unsigned plant) const { return plant < kMaxPlants ? m_used_sec[plant] : 0.0f; }
+
+  // The fraction of the budget for a plant by its need, from 0 to 1.
+  float share(unsigned plant) const;
+  // Pump seconds which a plant may still use, at most the remaining_secs in the reservoir.
+  float allowanceSec(unsigned plant, float remaining_secs) const;
+
+ private:
+  bool m_active = false;
+  float m_budget_sec = 0.0f;
+  float m_need[kMaxPlants] = {};
+  float m_used_sec[kMaxPlants] = {};
+};
+
+}  // namespace og3
@@ -4,14 +4,18 @@
 #include "watering.h"
 
 #include <og3/blink_led.h>
-#include <og3/html_table.h>
 #include <og3/tasks.h>
 #include <og3/units.h>
 #include <og3/web_server.h>
 
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
 
 #include "ArduinoJson/Variant/JsonVariant.hpp"
+#include "html_stream.h"
+#include "uptime.h"
 #include "watering_constants.h"
 
 namespace og3 {
@@ -43,6 +47,7 @@ int wateringDirection(Watering::State state) {
     case Watering::State::kStateDisabled:
     case Watering::State::kStatePumpTest:
     case Watering::State::kStateTest:
+    case Watering::State::kStateSensorFault:
       return 0;
   }
   return 0;
@@ -61,6 +66,7 @@ const char* Watering::s_state_names[] = {
     "watering disabled",  // kStateDisabled
     "pump test",          // kStatePumpTest
     "test",               // kStateTest
+    "sensor fault",       // kStateSensorFault
 };
 
 // static
@@ -71,7 +77,7 @@ bool Watering::StateVariable::fromString(const String& value) {
   if (fromString(value)) {
     return true;
   }
-  for (int i = 0; i <= Watering::kStateTest; i++) {
+  for (int i = 0; i <= Watering::kStateSensorFault; i++) {
     if (0 == strcmp(value.c_str(), s_state_names[i])) {
       m_value = static_cast<Watering::State>(i);
       return true;
@@ -100,8 +106,14 @@ Watering::Watering(unsigned index, const char* name, uint8_t moisture_pin, uint8
                  "raw moisture reading", "soil moisture %", &app->module_system(), m_cfg_vg, m_vg),
       m_pump(varname("pump", &m_pump_varname), &app->tasks(), pump_ctl_pin, "pump state", true,
              m_vg, Relay::OnLevel::kHigh),
+      m_pump_timer(pump_ctl_pin, true /*on_high*/,
+                   varname("dose_actual_msec", &m_dose_actual_varname),
+                   varname("dose_error_mean_msec", &m_dose_error_mean_varname),
+                   varname("dose_error_max_msec", &m_dose_error_max_varname), m_vg),
       m_mode_led("mode_led", mode_led, app, 100 /*msec-on*/, false /*onLow*/),
       m_dose_log(m_vg, m_cfg_vg, &app->module_system(), this),
+      m_forecast(varname("drying_rate", &m_drying_rate_varname),
+                 varname("next_watering_sec", &m_next_watering_varname), m_vg),
       m_plant_name("name", name, nullptr, nullptr, kCfgSet, m_cfg_vg),
       m_max_moisture_target("max_moisture_target", 80.0f, units::kPercentage, "Max moisture",
                             kCfgSet, 0, m_cfg_vg),
@@ -111,19 +123,44 @@ Watering::Watering(unsigned index, const char* name, uint8_t moisture_pin, uint8
                        kCfgSet, 0, m_cfg_vg),
       m_between_doses_sec("between_doses_sec", kPumpOffSec, units::kSeconds, "Wait between doses",
                           kCfgSet, 0, m_cfg_vg),
+      m_flow_ml_per_sec("flow_ml_per_sec", kPumpFlowMlPerSec, "ml/s", "Pump flow", kCfgSet, 1,
+                        m_cfg_vg),
+      m_water_priority("water_priority", 1.0f, "", "Priority for low water", kCfgSet, 1,
+                       m_cfg_vg),
       m_state(varname("watering_state", &m_watering_varname), kStateWaitForNextCycle,
               "watering state", 0, m_vg),
       m_sec_since_dose(varname("sec_since_pump", &m_sec_dose_varname), 0, units::kSeconds,
                        "seconds since pump dose", 0, 0, m_vg),
+      m_water_share(varname("water_share", &m_water_share_varname), 0.0f, units::kPercentage,
+                    "share of low water", 0, 0, m_vg),
+      m_sensor_health(varname("sensor_health", &m_sensor_health_varname),
+                      "moisture sensor health", m_vg),
+      m_sensor_noise(varname("sensor_noise", &m_sensor_noise_varname), 0.0f, units::kPercentage,
+                     "moisture sensor noise", 0, 1, m_vg),
       m_watering_enabled("watering_enabled", false, "watering enabled", kCfgSet, m_cfg_vg),
       m_reservoir_check_enabled("res_check_enabled", false, "reservior check enabled", kCfgSet,
-                                m_cfg_vg) {
+                                m_cfg_vg),
+      m_kalman_enabled("kalman_moisture", false, "Kalman moisture estimate", kCfgSet, m_cfg_vg) {
   setDependencies(&m_dependencies);
   // 10 seconds after boot, start the plant state machine.
   m_next_update_msec = millis() + (10 + 15 * index) * kMsecInSec;
   add_link_fn([this](og3::NameToModule& name_to_module) -> bool {
     m_config = ConfigInterface::get(name_to_module);
     m_reservoir_check = ReservoirCheck::get(name_to_module);
+    m_history = HistoryLog::get(name_to_module);
+    m_trace = TraceLog::get(name_to_module);
+    m_telemetry = Telemetry::get(name_to_module);
+    PlantRouter* router = PlantRouter::get(name_to_module);
+    if (router) {
+      router->setPage(m_index, PlantRouter::kStatusPage,
+                      [this](AsyncWebServerRequest* request) { handleStatusRequest(request); });
+      router->setPage(m_index, PlantRouter::kConfigPage,
+                      [this](AsyncWebServerRequest* request) { handleConfigRequest(request); });
+      router->setPage(m_index, PlantRouter::kPumpPage, [this](AsyncWebServerRequest* request) {
+        testPump();
+        request->redirect(statusUrl());
+      });
+    }
     return true;
   });
   add_init_fn([this]() {
@@ -170,18 +207,27 @@ Watering::Watering(unsigned index, const char* name, uint8_t moisture_pin, uint8
                                  ha::device_class::sensor::kDuration);
         return addEntry(entry, had, json);
       });
+      ha_discovery->addDiscoveryCallback([this, addEntry](HADiscovery* had, JsonDocument* json) {
+        HADiscovery::Entry entry(m_forecast.rateVariable(), ha::device_type::kSensor);
+        return addEntry(entry, had, json);
+      });
+      ha_discovery->addDiscoveryCallback([this, addEntry](HADiscovery* had, JsonDocument* json) {
+        HADiscovery::Entry entry(m_forecast.nextWateringVariable(), ha::device_type::kSensor,
+                                 ha::device_class::sensor::kDuration);
+        return addEntry(entry, had, json);
+      });
+      ha_discovery->addDiscoveryCallback([this, addEntry](HADiscovery* had, JsonDocument* json) {
+        HADiscovery::Entry entry(m_sensor_health, ha::device_type::kSensor);
+        return addEntry(entry, had, json);
+      });
+      ha_discovery->addDiscoveryCallback([this, addEntry](HADiscovery* had, JsonDocument* json) {
+        HADiscovery::Entry entry(m_sensor_noise, ha::device_type::kSensor);
+        return addEntry(entry, had, json);
+      });
       m_dose_log.addHADiscovery(ha_discovery);
     }
   });
   add_update_fn([this]() { loop(); });
-  m_app->web_server().on(
-      statusUrl(), [this](AsyncWebServerRequest* request) { this->handleStatusRequest(request); });
-  m_app->web_server().on(
-      configUrl(), [this](AsyncWebServerRequest* request) { this->handleConfigRequest(request); });
-  m_app->web_server().on(pumpTestUrl(), [this](AsyncWebServerRequest* request) {
-    testPump();
-    request->redirect(statusUrl());
-  });
 }
 
 void Watering::setPumpEnable(bool enable) {
@@ -197,18 +243,30 @@ void Watering::loop() {
   if (m_watering_enabled.value()) {
     if (state() == kStateDisabled) {
       // Detected watering enabled.
+      if (m_trace) {
+        m_trace->addEnable(m_index, true);
+      }
       setPumpEnable(true);
     }
   } else {
     if (state() != kStateDisabled) {
       // Detected watering disabled.
+      if (m_trace) {
+        m_trace->addEnable(m_index, false);
+      }
       setPumpEnable(false);
     }
   }
 
+  // The pump timer turned the pump off from its own task, so show the relay as off now.
+  if (m_pump_timer.fired()) {
+    m_pump.turnOff();
+    m_pump_off_msec = millis();
+  }
+
   const auto nowMsec = millis();
 
-  if (nowMsec < m_next_update_msec) {
+  if (msecBefore(nowMsec, m_next_update_msec)) {
     return;
   }
   m_next_update_msec = nowMsec + static_cast<unsigned long>(2000);
@@ -222,36 +280,67 @@ void Watering::loop() {
   //  when not watering.
   m_dose_log.update(isWatering(state()));
 
-  const long msecSincePump = nowMsec - m_pump.lastOnMsec();
+  const uint32_t msecSincePump = elapsedMsec(nowMsec, m_pump.lastOnMsec());
+  // Unlike millis(), this does not wrap, so the moisture filter and forecast see time move forward.
+  const int64_t uptimeMsec = uptimeUsec() / 1000;
   m_sec_since_dose = msecSincePump * 1e-3;
-  const bool shouldReadMoisture = msecSincePump >= kWaitBetweenPumpAndMoisureReadingMsec;
+  // The Kalman estimate models how a dose soaks in, so when it decides when to water, the
+  //  kernel filter sigma is left as it is.
+  const bool kalman = m_kalman_enabled.value();
   // We found that if we read moisture level after pump has been running, the reading
-  //  is significantly lower, so a reference voltage must be dropping.
+  //  is significantly lower, so a reference voltage must be dropping.  The Kalman estimate
+  //  doesn't model this, so it only reads once the pump has been off for the same wait.
+  const uint32_t wait = static_cast<uint32_t>(kWaitBetweenPumpAndMoisureReadingMsec);
+  const bool shouldReadMoisture =
+      kalman ? !m_pump_timer.isRunning() && state() != kStateEndOfDose &&
+                   elapsedMsec(nowMsec, m_pump_off_msec) >= wait
+             : msecSincePump >= wait;
   if (shouldReadMoisture) {
-    if (m_state.value() == kStateWaitForNextCycle) {
-      // After watering, increase the kernel size from the watering amount to
-      //  the amount used between watering, but don't weigh data from
-      //  before the watering by more than they were during watering mode.
-      // The time in seconds that the state machine might have switched out of watering mode.
-      const float stateChangeSec =
-          static_cast<float>(m_pump.lastOnMsec()) / kMsecInSec + kPumpOffSec;
-      const float secSinceStateChange = static_cast<float>(nowMsec) / kMsecInSec - stateChangeSec;
-      // The growing sigma value that should be kKernelWateringSec when the state changed.
-      const float sigma1 = secSinceStateChange + kKernelWateringSec;
-      // Keep sigma between the minimum and maximum values.
-      const float sigma = clamp(sigma1, kKernelWateringSec, kKernelNotWateringSec);
-      m_moisture.setSigma(sigma);
-    } else {
-      m_moisture.setSigma(kKernelWateringSec);
+    if (!kalman) {
+      if (m_state.value() == kStateWaitForNextCycle) {
+        // After watering, increase the kernel size from the watering amount to
+        //  the amount used between watering, but don't weigh data from
+        //  before the watering by more than they were during watering mode.
+        // The time in seconds that the state machine might have switched out of watering mode.
+        const float secSinceStateChange =
+            static_cast<float>(msecSincePump) / kMsecInSec - static_cast<float>(kPumpOffSec);
+        // The growing sigma value that should be kKernelWateringSec when the state changed.
+        const float sigma1 = secSinceStateChange + kKernelWateringSec;
+        // Keep sigma between the minimum and maximum values.
+        const float sigma = clamp(sigma1, kKernelWateringSec, kKernelNotWateringSec);
+        m_moisture.setSigma(sigma);
+      } else {
+        m_moisture.setSigma(kKernelWateringSec);
+      }
     }
 
-#if 0
-    if (m_shtc3.ok() && !m_shtc3.temperatureVar().failed()) {
+    if (m_climate && m_climate->ok() &&
+        elapsedMsec(nowMsec, m_climate->sampleMsec()) < kClimateMaxAgeMsec) {
       // Add current temperature, adjust moisture reading.
-      m_moisture.setTempC(m_shtc3.temperature());
+      m_moisture.setTempC(m_climate->temperature());
+      m_forecast.setClimate(m_climate->temperature(), m_climate->humidity());
+    }
+    m_moisture.setUseKalman(m_kalman_enabled.value());
+    m_moisture.read(uptimeMsec);
+    const SensorHealth& health = m_moisture.health();
+    if (health.status() != m_sensor_health.value()) {
+      log()->logf("plant%u: moisture sensor %s -> %s (median %.1f%%, noise %.1f%%).", m_index,
+                  SensorHealth::s_status_names[static_cast<int>(m_sensor_health.value())],
+                  SensorHealth::s_status_names[static_cast<int>(health.status())],
+                  health.median(), health.noise());
+      m_sensor_health = health.status();
+    }
+    m_sensor_noise = health.noise();
+    // The drying rate is only measured while nothing but drying changes the moisture level.
+    if (m_state.value() == kStateWaitForNextCycle) {
+      m_forecast.addSample(static_cast<float>(uptimeMsec) / kMsecInSec,
+                           m_moisture.filteredValue());
+    } else {
+      m_forecast.restart();
+    }
+    if (m_history) {
+      m_history->addMoisture(m_index, m_moisture.filteredValue(), m_moisture.rawCounts());
     }
-#endif
-    m_moisture.read(nowMsec);
     if (m_index == 0) {
       const float level = m_moisture.filteredValue();
       if (level > m_max_moisture_target.value()) {
@@ -264,6 +353,18 @@ void Watering::loop() {
     }
   }
 
+  if (m_reservoir_check) {
+    m_reservoir_check->setWaterNeed(m_index, waterNeed());
+    m_water_share = m_reservoir_check->rationing()
+                        ? 100.0f * m_reservoir_check->waterBudget().share(m_index)
+                        : 100.0f;
+  }
+
+  if (m_trace) {
+    m_trace->addTick(m_index, nowMsec,
+                     shouldReadMoisture ? m_moisture.rawCounts() : trace::kNoReading);
+  }
+
   // Run the state machine.
   switch (state()) {
     case kStateEval: {
@@ -277,12 +378,10 @@ void Watering::loop() {
       } else if (reservoirCheckEnabled() && isReservoirEmpty()) {
         // Reservoir may be low, so don't consider using the pump.
         setState(kStateEval, kWaitForNextCycleMsec, "reservoir too low");
-      } else if (m_moisture.readingIsFailed()) {
-        setState(kStateDisabled, 1, "failed reading moisture sensor");
-      } else if (m_moisture.filteredValue() < kMinPlausibleMoisture) {
-        log()->logf("plant%d: Moisture sensor reading is too low (%.1f < %.1f).", m_index,
-                    m_moisture.filteredValue(), kMinPlausibleMoisture);
-        setState(kStateDisabled, 1, "moisture level implausibly low");
+      } else if (!m_moisture.health().canWater()) {
+        // The sensor is disconnected, out of soil or stuck, so its readings can't say
+        //  whether the plant needs water.
+        setState(kStateSensorFault, 1, sensorHealthName());
       } else {
         // Check whether to turn on the pump.
         const float val = m_moisture.filteredValue();
@@ -293,6 +392,8 @@ void Watering::loop() {
           setState(kStateWaitForNextCycle, kWaitForNextCycleMsec, "moisture past maximum range");
         } else if (m_dose_log.shouldPauseWatering()) {
           setState(kStateWateringPaused, kWaitForNextCycleMsec, "too many doses in cycle");
+        } else if (doseMsecAllowed() < kMinLowWaterDoseMsec) {
+          setState(kStateEval, kWaitForNextCycleMsec, "used share of low water");
         } else {
           setState(kStateDose, 1, "start pump");
         }
@@ -301,22 +402,40 @@ void Watering::loop() {
       break;
     }
 
-    case kStateDose:
-      // Start the pump, and run for kPumpOnMsec.
+    case kStateDose: {
+      // Start the pump, and run for kPumpOnMsec, or for what is left of this plant's share
+      //  of low water.
+      // The pump timer turns the pump off at the deadline, even if this loop is late.
+      float dose_msec = std::min(m_pump_dose_msec.value(), doseMsecAllowed());
+      if (m_moisture.health().status() == SensorHealth::Status::kNoisy) {
+        // Water more cautiously while the readings are noisy.
+        dose_msec *= kNoisySensorDoseFraction;
+      }
       m_pump.turnOn();
+      m_pump_timer.start(dose_msec);
       m_dose_log.addDose();
-      setState(kStateEndOfDose, m_pump_dose_msec.value(), "end watering dose");
+      setState(kStateEndOfDose, dose_msec, "end watering dose");
       break;
+    }
 
-    case kStateEndOfDose:
-      // Turn pump off at end of dose.
+    case kStateEndOfDose: {
+      // The pump timer has already turned the pump off, so this updates the relay state.
       m_pump.turnOff();
+      m_pump_off_msec = nowMsec;
+      const float on_msec = m_pump_timer.finish();
+      const float ml = 1e-3f * on_msec * m_flow_ml_per_sec.value();
+      m_dose_log.addPumpMsec(on_msec);
+      m_moisture.addDose(ml);
       if (m_reservoir_check) {
-        m_reservoir_check->pumpRanForMsec(m_pump_dose_msec.value());
+        m_reservoir_check->pumpRanForMsec(m_index, on_msec, ml);
+      }
+      if (m_history) {
+        m_history->addDose(m_index, static_cast<unsigned>(on_msec + 0.5f));
       }
       // Eval mode will wait until kPumpOffSec until it will allow the pump to run again.
       setState(kStateEval, kWaitForNextCycleMsec, "continue watering");
       break;
+    }
 
     case kStateWateringPaused: {
       const float val = m_moisture.filteredValue();
@@ -340,11 +459,17 @@ void Watering::loop() {
       // After moisture level reaches maximum level, wait for it to reach minimum
       //  moisture level and also wait for minimum time between watering cycles, then
       //  go back to kStateEval.
+      // Moisture is still sampled every kWaitForNextCycleMsec for the filter and sensor health,
+      //  but the drying forecast decides how often to check whether to start watering.
       const float val = m_moisture.filteredValue();
       m_pump.turnOff();
-      if (val < m_min_moisture_target.value()) {
+      const unsigned long wait_msec = waitForDryingMsec(val);
+      if (msecBefore(nowMsec, m_drying_check_msec)) {
+        setState(kStateWaitForNextCycle, kWaitForNextCycleMsec, "");
+      } else if (val < m_min_moisture_target.value()) {
         setState(kStateEval, 1, "start watering");
       } else {
+        m_drying_check_msec = nowMsec + wait_msec;
         setState(kStateWaitForNextCycle, kWaitForNextCycleMsec, "");
       }
       break;
@@ -353,13 +478,27 @@ void Watering::loop() {
     case kStateDisabled:
       // State for when pump is disabled.
       m_pump.turnOff();
+      m_pump_timer.cancel();
       // Update every 10 seconds to get latest readings.
       setState(kStateDisabled, 10 * kMsecInSec, "");
       break;
 
+    case kStateSensorFault:
+      // Hold the pump off until the moisture sensor can be trusted again.
+      m_pump.turnOff();
+      m_pump_timer.cancel();
+      if (m_moisture.health().canWater()) {
+        setState(kStateWaitForNextCycle, 1, "moisture sensor ok");
+      } else {
+        // Update every 10 seconds to get latest readings.
+        setState(kStateSensorFault, 10 * kMsecInSec, "");
+      }
+      break;
+
     case kStatePumpTest:
       // State for when testing a single pump cycle, transitions to disabled mode.
       m_pump.turnOn();
+      m_pump_timer.start(m_pump_dose_msec.value());
       setState(kStateDisabled, m_pump_dose_msec.value(), "end of pump test");
       break;
 
@@ -370,7 +509,12 @@ void Watering::loop() {
       break;
   }
 
-  m_app->mqttSend(m_vg);
+  if (m_telemetry) {
+    m_telemetry->mqttSend(m_vg, m_state_changed);
+  } else {
+    m_app->mqttSend(m_vg);
+  }
+  m_state_changed = false;
   if (m_reservoir_check) {
     m_reservoir_check->mqttUpdate();
   }
@@ -381,6 +525,14 @@ void Watering::setState(State state, unsigned msec, const char* msg) {
     // The watering state changed.
     log()->logf("plant%u: %s -> %s in %d.%03d: %s.", m_index, s_state_names[m_state.value()],
                 s_state_names[state], msec / 1000, msec % 1000, msg);
+    if (m_trace) {
+      m_trace->addState(m_index, state);
+    }
+    m_state_changed = true;
+    if (state == kStateWaitForNextCycle) {
+      // Check whether to start watering at the next update.
+      m_drying_check_msec = millis();
+    }
   } else {
     // The watering state is staying the same.
     log()->debugf("plant%u: %s -> %s in %d.%03d: %s.", m_index, s_state_names[m_state.value()],
@@ -392,9 +544,21 @@ void Watering::setState(State state, unsigned msec, const char* msg) {
   m_next_update_msec = millis() + static_cast<unsigned long>(msec);
 }
 
+unsigned long Watering::waitForDryingMsec(float moisture) {
+  const float secs = m_forecast.update(moisture, m_min_moisture_target.value());
+  if (secs <= 0.0f) {
+    return kWaitForNextCycleMsec;
+  }
+  // Sleep through about half of the predicted time left, so checks get closer together
+  //  as the predicted time approaches and the prediction is corrected along the way.
+  const float msec = 0.5f * secs * kMsecInSec;
+  return static_cast<unsigned long>(clamp(msec, static_cast<float>(kWaitForNextCycleMsec),
+                                         static_cast<float>(kForecastMaxWaitMsec)));
+}
+
 void Watering::_fullTest() {
   // test
-  m_moisture.read(millis());
+  m_moisture.read(uptimeUsec() / 1000);
   log()->logf("plant%u: moisture: %s: %d, %.1f", m_index,
               m_moisture.readingIsFailed() ? "NOT OK" : "OK", m_moisture.rawCounts(),
               m_moisture.filteredValue());
@@ -410,27 +574,42 @@ void Watering::_fullTest() {
 
 void Watering::handleStatusRequest(AsyncWebServerRequest* request) {
 #ifndef NATIVE
-  m_html.clear();
-  html::writeTableInto(&m_html, variables());
-  add_html_button(&m_html, "Configure", configUrl());
-  add_html_button(&m_html, "Test pump", pumpTestUrl());
-  m_html += HTML_BUTTON("/", "Back");
-  sendWrappedHTML(request, m_app->board_cname(), this->name(), m_html.c_str());
+  auto page = HtmlStream::create(m_app->board_cname(), this->name());
+  page->table(variables())
+      .button("Configure", configUrl())
+      .button("Test pump", pumpTestUrl())
+      .button("Back", "/");
+  HtmlStream::send(page, request);
 #endif
 }
 void Watering::handleConfigRequest(AsyncWebServerRequest* request) {
 #ifndef NATIVE
-  ::og3::read(*request, m_cfg_vg);
-  m_html.clear();
-  html::writeFormTableInto(&m_html, m_cfg_vg);
-  add_html_button(&m_html, "Back", statusUrl());
-  sendWrappedHTML(request, m_app->board_cname(), this->name(), m_html.c_str());
-  if (m_config) {
+  const bool changed = HtmlStream::readForm(request, &m_cfg_vg);
+  auto page = HtmlStream::create(m_app->board_cname(), this->name());
+  page->formTable(m_cfg_vg).button("Back", statusUrl());
+  HtmlStream::send(page, request);
+  if (changed && m_config) {
     m_config->write_config(m_cfg_vg);
   }
 #endif
 }
 
+float Watering::waterNeed() const {
+  if (!isEnabled() || !reservoirCheckEnabled() || state() == kStateDisabled ||
+      !m_moisture.health().canWater()) {
+    return 0.0f;
+  }
+  const float deficit = minTarget() - m_moisture.filteredValue();
+  return deficit > 0.0f ? deficit * m_water_priority.value() : 0.0f;
+}
+
+float Watering::doseMsecAllowed() const {
+  if (!m_reservoir_check || !reservoirCheckEnabled() || !m_reservoir_check->rationing()) {
+    return m_pump_dose_msec.value();
+  }
+  return kMsecInSec * m_reservoir_check->pumpSecondsFor(m_index);
+}
+
 void Watering::getApiPlants(JsonObject json) const {
   json["name"] = plantName();
   json["minMoisture"] = minTarget();
@@ -441,39 +620,164 @@ void Watering::getApiPlants(JsonObject json) const {
   json["currentMoisture"] = moisturePercent();
   json["pumpOnTime"] = m_pump_dose_msec.value();
   json["secsBetweenDoses"] = m_between_doses_sec.value();
+  json["flowMlPerSec"] = m_flow_ml_per_sec.value();
   json["maxDosesPerCycle"] = m_dose_log.maxDoesPerCycle();
+  json["reservoirCheck"] = reservoirCheckEnabled();
+  json["kalman"] = m_kalman_enabled.value();
+  json["waterPriority"] = m_water_priority.value();
+  json["waterShare"] = m_water_share.value();
+  json["sensorHealth"] = sensorHealthName();
+  json["sensorNoise"] = m_sensor_noise.value();
   json["doseCount"] = m_dose_log.doseCount();
+  json["pumpSecsToday"] = m_dose_log.pumpSecs();
+  m_dose_log.dosesByHour(json["dosesByHour"].to<JsonArray>());
   json["state"] = m_state.string();
+  if (m_forecast.valid()) {
+    json["dryingRate"] = m_forecast.ratePerHour();
+  }
+  if (!m_forecast.nextWateringVariable().failed()) {
+    json["nextWateringSec"] = m_forecast.nextWateringVariable().value();
+  }
 }
 
 namespace {
+
+constexpr unsigned kMaxPlantNameLen = 32;
+constexpr float kMaxAdcCounts = 4095;
+constexpr float kMaxPumpOnMsec = 60 * kMsecInSec;
+constexpr float kMaxWaterPriority = 10;
+constexpr float kMaxFlowMlPerSec = 1000;
+
+// Checks fields of a plant settings object, adding an error for each bad one.
+class FieldChecker {
+ public:
+  FieldChecker(unsigned id, JsonObjectConst json, JsonArray errors)
+      : m_id(id), m_json(json), m_errors(errors) {}
+
+  bool ok() const { return m_ok; }
+
+  void error(const char* field, const char* message) {
+    JsonObject error = m_errors.add<JsonObject>();
+    error["id"] = m_id;
+    error["field"] = field;
+    error["message"] = message;
+    m_ok = false;
+  }
+
+  // Check that a field, if present, is a number from min to max.
+  void number(const char* field, float min, float max, bool integer) {
+    const JsonVariantConst var = m_json[field];
+    if (var.isNull()) {
+      return;
+    }
+    if (integer ? !var.is<int>() : !var.is<float>()) {
+      error(field, integer ? "not an integer" : "not a number");
+      return;
+    }
+    const float val = var.as<float>();
+    if (val < min || val > max) {
+      char msg[64];
+      snprintf(msg, sizeof(msg), "not from %g to %g", min, max);
+      error(field, msg);
+    }
+  }
+
+  void boolean(const char* field) {
+    const JsonVariantConst var = m_json[field];
+    if (!var.isNull() && !var.is<bool>()) {
+      error(field, "not true or false");
+    }
+  }
+
+  void string(const char* field, size_t max_len) {
+    const JsonVariantConst var = m_json[field];
+    if (var.isNull()) {
+      return;
+    }
+    if (!var.is<const char*>()) {
+      error(field, "not a string");
+    } else if (strlen(var.as<const char*>()) == 0 || strlen(var.as<const char*>()) > max_len) {
+      error(field, "wrong length");
+    }
+  }
+
+ private:
+  const unsigned m_id;
+  const JsonObjectConst m_json;
+  JsonArray m_errors;
+  bool m_ok = true;
+};
+
 template <typename T>
-bool getVal(JsonObject json, const char* name, const std::function<void(const T& val)>& fn) {
-  const JsonVariant var = json[name];
-  if (!var.is<T>()) {
-    return false;
+void setIfPresent(JsonObjectConst json, const char* name, const std::function<void(T)>& fn) {
+  const JsonVariantConst var = json[name];
+  if (!var.isNull()) {
+    fn(var.as<T>());
   }
-  fn(var.as<T>());
-  return true;
 }
+
 }  // namespace
 
-bool Watering::putApiPlants(JsonObject json) {
-  const bool res =
-      getVal<const char*>(json, "name", [this](const char* name) { m_plant_name = name; }) &&
-      getVal<int>(json, "minMoisture", [this](const int& val) { m_min_moisture_target = val; }) &&
-      getVal<int>(json, "maxMoisture", [this](const int& val) { m_max_moisture_target = val; }) &&
-      getVal<int>(json, "adc0", [this](const int& val) { m_moisture.adc().set_in_min(val); }) &&
-      getVal<int>(json, "adc100", [this](const int& val) { m_moisture.adc().set_in_max(val); }) &&
-      getVal<int>(json, "pumpOnTime", [this](const int& val) { m_pump_dose_msec = val; }) &&
-      getVal<int>(json, "secsBetweenDoses",
-                  [this](const int& val) { m_between_doses_sec = val; }) &&
-      getVal<int>(json, "maxDosesPerCycle",
-                  [this](const int& val) { m_dose_log.setMaxDoesPerCycle(val); }) &&
-      getVal<bool>(json, "enabled", [this](const bool& val) { m_watering_enabled = val; });
-  if (res && m_config) {
+bool Watering::checkApiPlants(JsonObjectConst json, JsonArray errors) const {
+  FieldChecker check(m_index + 1, json, errors);
+  check.string("name", kMaxPlantNameLen);
+  check.number("minMoisture", 0, 100, true);
+  check.number("maxMoisture", 0, 100, true);
+  check.number("adc0", 0, kMaxAdcCounts, true);
+  check.number("adc100", 0, kMaxAdcCounts, true);
+  check.number("pumpOnTime", 1, kMaxPumpOnMsec, true);
+  check.number("secsBetweenDoses", 0, kSecInDay, true);
+  check.number("maxDosesPerCycle", 1, 100, true);
+  check.number("flowMlPerSec", 0.1f, kMaxFlowMlPerSec, false);
+  check.boolean("enabled");
+  check.boolean("reservoirCheck");
+  check.boolean("kalman");
+  check.number("waterPriority", 0, kMaxWaterPriority, false);
+  if (!check.ok()) {
+    return false;
+  }
+  // Check the settings against each other, as they will be after the update.
+  if ((json["minMoisture"] | minTarget()) > (json["maxMoisture"] | maxTarget())) {
+    check.error("minMoisture", "more than maxMoisture");
+  }
+  const int adc0 = json["adc0"] | static_cast<int>(m_moisture.adc().in_min());
+  const int adc100 = json["adc100"] | static_cast<int>(m_moisture.adc().in_max());
+  if (adc0 == adc100) {
+    check.error("adc0", "same as adc100");
+  }
+  return check.ok();
+}
+
+void Watering::applyApiPlants(JsonObjectConst json) {
+  setIfPresent<const char*>(json, "name", [this](const char* name) { m_plant_name = name; });
+  setIfPresent<int>(json, "minMoisture", [this](int val) { m_min_moisture_target = val; });
+  setIfPresent<int>(json, "maxMoisture", [this](int val) { m_max_moisture_target = val; });
+  setIfPresent<int>(json, "adc0", [this](int val) { m_moisture.adc().set_in_min(val); });
+  setIfPresent<int>(json, "adc100", [this](int val) { m_moisture.adc().set_in_max(val); });
+  setIfPresent<int>(json, "pumpOnTime", [this](int val) { m_pump_dose_msec = val; });
+  setIfPresent<int>(json, "secsBetweenDoses", [this](int val) { m_between_doses_sec = val; });
+  setIfPresent<int>(json, "maxDosesPerCycle",
+                    [this](int val) { m_dose_log.setMaxDoesPerCycle(val); });
+  setIfPresent<float>(json, "flowMlPerSec", [this](float val) { m_flow_ml_per_sec = val; });
+  setIfPresent<bool>(json, "enabled", [this](bool val) { m_watering_enabled = val; });
+  setIfPresent<bool>(json, "reservoirCheck",
+                     [this](bool val) { m_reservoir_check_enabled = val; });
+  setIfPresent<bool>(json, "kalman", [this](bool val) { m_kalman_enabled = val; });
+  setIfPresent<float>(json, "waterPriority", [this](float val) { m_water_priority = val; });
+}
+
+void Watering::saveConfig() {
+  if (m_config) {
     m_config->write_config(m_cfg_vg);
   }
+}
+
+bool Watering::putApiPlants(JsonObjectConst json, JsonArray errors) {
+  if (!checkApiPlants(json, errors)) {
+    return false;
+  }
+  applyApiPlants(json);
+  saveConfig();
   return true;
 }
 
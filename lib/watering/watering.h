@@ -8,9 +8,16 @@
 #include <og3/logger.h>
 #include <og3/relay.h>
 
+#include "climate_readings.h"
 #include "dose_log.h"
+#include "drying_forecast.h"
+#include "history_log.h"
 #include "moisture_sensor.h"
+#include "plant_router.h"
+#include "pump_timer.h"
 #include "reservoir_check.h"
+#include "telemetry.h"
+#include "trace_log.h"
 
 namespace og3 {
 
@@ -44,14 +51,17 @@ class Watering : public Module {
 
     // Test state.
     kStateTest,
+
+    // The moisture sensor can't be trusted, so hold off watering until it can.
+    kStateSensorFault,
   };
 
   class StateVariable : public EnumStrVariable<State> {
    public:
     StateVariable(const char* name_, const State value, const char* description_, unsigned flags_,
                   VariableGroup& group)
-        : EnumStrVariable<State>(name_, value, description_, kStateTest, s_state_names, flags_,
-                                 group) {}
+        : EnumStrVariable<State>(name_, value, description_, kStateSensorFault, s_state_names,
+                                 flags_, group) {}
     String string() const override;
     bool fromString(const String& value) override;
 
@@ -64,6 +74,20 @@ class Watering : public Module {
 
   static const char* s_state_names[];
 
+  class SensorHealthVariable : public EnumStrVariable<SensorHealth::Status> {
+   public:
+    SensorHealthVariable(const char* name_, const char* description_, VariableGroup& group)
+        : EnumStrVariable<SensorHealth::Status>(name_, SensorHealth::Status::kOk, description_,
+                                                SensorHealth::Status::kDisconnected,
+                                                SensorHealth::s_status_names, 0, group) {}
+
+    SensorHealthVariable& operator=(const SensorHealth::Status value) {
+      m_value = value;
+      setFailed(false);
+      return *this;
+    }
+  };
+
   Watering(unsigned index, const char* name, uint8_t moisture_pin, uint8_t mode_led,
            uint8_t pump_ctl_pin, HAApp* app);
 
@@ -75,6 +99,8 @@ class Watering : public Module {
   bool isEnabled() const { return m_watering_enabled.value(); }
   float moisturePercent() const { return m_moisture.filteredValue(); }
   unsigned rawMoisture() const { return m_moisture.rawCounts(); }
+  const MoistureSensor& moistureSensor() const { return m_moisture; }
+  const Rollup& moistureRollup() const { return m_moisture.rollup(); }
 
   float maxTarget() const { return m_max_moisture_target.value(); }
   float minTarget() const { return m_min_moisture_target.value(); }
@@ -91,6 +117,16 @@ class Watering : public Module {
     add_html_button(body, plantName().c_str(), statusUrl());
   }
   bool isReservoirEmpty() const { return !m_reservoir_check->haveWater(); }
+  // The need of this plant for the water left after the reservoir float drops: its priority
+  //  times how far its moisture is below its minimum target.
+  float waterNeed() const;
+  // The pump time this plant may use for the next dose, which after the float drops is
+  //  limited to its share of the water left.
+  float doseMsecAllowed() const;
+  // The health of the moisture sensor: ok, noisy, stuck, out of soil or disconnected.
+  const char* sensorHealthName() const {
+    return SensorHealth::s_status_names[static_cast<int>(m_moisture.health().status())];
+  }
 
   const VariableGroup& variables() const { return m_vg; }
   const VariableGroup& configVariables() const { return m_cfg_vg; }
@@ -98,11 +134,24 @@ class Watering : public Module {
   Relay& relay() { return m_pump; }
 
   const DoseLog& doseLog() const { return m_dose_log; }
+  const DryingForecast& forecast() const { return m_forecast; }
+  // Set where to get the temperature and humidity, which adjust moisture readings and the
+  //  drying forecast.
+  void setClimate(const ClimateReadings* climate) { m_climate = climate; }
 
   void loop();
 
   void getApiPlants(JsonObject json) const;
-  bool putApiPlants(JsonObject json);
+  // Check settings in the form written by getApiPlants(), adding {"id", "field", "message"}
+  //  to errors for each bad one.  Fields which aren't settings are ignored.
+  bool checkApiPlants(JsonObjectConst json, JsonArray errors) const;
+  // Apply settings which passed checkApiPlants().  Settings not in json keep their values.
+  void applyApiPlants(JsonObjectConst json);
+  // Write the settings to flash.
+  void saveConfig();
+  // Check, apply and save settings, returning false without applying any if one is bad,
+  //  with the errors added to errors as by checkApiPlants().
+  bool putApiPlants(JsonObjectConst json, JsonArray errors);
 
  protected:
   // This method performs the work of the state machine.
@@ -110,6 +159,9 @@ class Watering : public Module {
   //  this to get called again after a given time interval.
   // The first call to this is scheduled in the constructor.
   void setState(State state, unsigned msec, const char* msg);
+  // How long to wait before checking again whether the soil has dried to the minimum target.
+  // This updates the forecast, so it is called at each reading while waiting.
+  unsigned long waitForDryingMsec(float moisture);
 
  private:
   void _fullTest();
@@ -129,31 +181,60 @@ class Watering : public Module {
   const String m_status_url;
   const String m_config_url;
   const String m_pump_test_url;
-  String m_html;
 
   std::string m_device_id;
   std::string m_moisture_varname;
   std::string m_pump_varname;
+  std::string m_dose_actual_varname;
+  std::string m_dose_error_mean_varname;
+  std::string m_dose_error_max_varname;
   std::string m_watering_varname;
   std::string m_sec_dose_varname;
+  std::string m_drying_rate_varname;
+  std::string m_next_watering_varname;
+  std::string m_water_share_varname;
+  std::string m_sensor_health_varname;
+  std::string m_sensor_noise_varname;
 
   ReservoirCheck* m_reservoir_check = nullptr;
+  HistoryLog* m_history = nullptr;
+  TraceLog* m_trace = nullptr;
+  Telemetry* m_telemetry = nullptr;
+  const ClimateReadings* m_climate = nullptr;
   ConfigInterface* m_config = nullptr;
   MoistureSensor m_moisture;
   Relay m_pump;
+  PumpTimer m_pump_timer;
   BlinkLed m_mode_led;
   DoseLog m_dose_log;
+  DryingForecast m_forecast;
 
   unsigned long m_next_update_msec = 0;
+  // When the pump last turned off at the end of a dose.
+  unsigned long m_pump_off_msec = 0;
+  // When the wait for the soil to dry next checks whether to start watering.
+  unsigned long m_drying_check_msec = 0;
+  // Whether the state changed since it was last sent to MQTT.
+  bool m_state_changed = false;
   Variable<String> m_plant_name;
   FloatVariable m_max_moisture_target;
   FloatVariable m_min_moisture_target;
   FloatVariable m_pump_dose_msec;
   FloatVariable m_between_doses_sec;
+  FloatVariable m_flow_ml_per_sec;
+  // Weight of this plant's need for the water left after the reservoir float drops.
+  FloatVariable m_water_priority;
   StateVariable m_state;
   FloatVariable m_sec_since_dose;
+  // This plant's share of the water left after the reservoir float drops, in percent.
+  FloatVariable m_water_share;
+  // The health of the moisture sensor, and the noise in its readings.
+  SensorHealthVariable m_sensor_health;
+  FloatVariable m_sensor_noise;
   BoolVariable m_watering_enabled;
   BoolVariable m_reservoir_check_enabled;
+  // Whether the state machine uses the Kalman moisture estimate.
+  BoolVariable m_kalman_enabled;
 };
 
 }  // namespace og3
@@ -1,19 +1,52 @@
 // Copyright (c) 2025 Chris Lee and contibuters.
 // Licensed under the MIT license. See LICENSE file in the project root for details.
 
+#pragma once
+
 #include <og3/units.h>
 
+#include <cstddef>
+
 namespace og3 {
 
+// The most plants which one device can water, which sizes the per-plant tables.
+constexpr unsigned kMaxPlants = 32;
+
 // When the reservoir level sensor goes low, this is the estimated number of seconds
 //  left the pump can run before the water level is too low for the pump.
 constexpr float kLowWaterSecsRemaining = 10.0f;
+// Doses shorter than this are not worth running the pump for, when the water left after the
+//  float drops is shared among plants.
+constexpr float kMinLowWaterDoseMsec = 500.0f;
+// Default pump flow, and reservoir volume when full.
+constexpr float kPumpFlowMlPerSec = 20.0f;
+constexpr float kReservoirCapacityMl = 4000.0f;
+// Time constant for averaging the rate of water use from the reservoir.
+constexpr float kReservoirUsageTauSec = 3 * kSecInDay;
 // At one point I thought maybe the moisture leval reading was unreliable for a
 //  short time after the pump was run, so I introduced a minimum wait between the
 //  the the pump was run and a reading was taken.
 constexpr long kWaitBetweenPumpAndMoisureReadingMsec = kMsecInSec;
 // < 5% means the sensor is probably not in soil.
 constexpr float kMinPlausibleMoisture = 5.0f;
+// > 130% means the sensor is probably disconnected or shorted.
+constexpr float kMaxPlausibleMoisture = 130.0f;
+
+// Parameters of the moisture sensor health checks (see SensorHealth).
+// A probe is stuck if this many readings in a row have the same ADC counts.
+constexpr unsigned kSensorStuckReadings = 30;
+// A probe is noisy if the standard deviation of its noise is more than this (%).
+constexpr float kSensorNoisyPercent = 5.0f;
+// Weight of each reading in the variance of the differences between readings.
+constexpr float kSensorNoiseAlpha = 0.05f;
+// Differences between readings are clipped at this many times the noise, plus the minimum.
+constexpr float kSensorDiffClip = 4.0f;
+constexpr float kSensorMinDiffClip = 1.0f;
+// Smallest and largest steps of the median and MAD of readings (%).
+constexpr float kSensorMinStep = 0.05f;
+constexpr float kSensorMaxStep = 32.0f;
+// Doses are cut to this fraction while a probe is noisy.
+constexpr float kNoisySensorDoseFraction = 0.5f;
 // Always wait 15 minutes between pump cycles.
 constexpr long kPumpOffSec = 15 * kSecInMin;
 // Wait 1 minute between checks in eval mode while waiting for moisture level to drop.
@@ -26,6 +59,22 @@ constexpr float kKernelWateringSec = 5 * kSecInMin;
 // When not watering, smoothe the moisture level over about 20 minutes.
 constexpr float kKernelNotWateringSec = 20 * kSecInMin;
 
+// Parameters of the Kalman moisture estimate (see MoistureKalman).
+// Variance of moisture readings (%^2).
+constexpr float kKalmanReadingVar = 4.0f;
+// Growth of the variance of the moisture level (%^2), its rate of change ((%/hour)^2) per
+//  hour, and of the rise per ml ((%/ml)^2) with each dose.
+constexpr float kKalmanLevelVarPerHour = 0.5f;
+constexpr float kKalmanRateVarPerHour = 0.04f;
+constexpr float kKalmanRiseVarPerDose = 1e-4f;
+// The rise in moisture per ml of water before any is measured.
+constexpr float kKalmanInitialRisePerMl = 0.05f;
+// Time constant for water from a dose to reach the moisture probe.
+constexpr float kKalmanSoakSec = 1 * kSecInMin;
+
+// Cached climate readings older than this are not used to adjust moisture readings.
+constexpr unsigned long kClimateMaxAgeMsec = 10 * kMsecInMin;
+
 // Default ADC reading at which to consider soil moisture to be 100%.
 constexpr unsigned kFullMoistureCounts = 1470;
 // Default ADC reading at which to consider soil moisture to be 0%.
@@ -35,4 +84,42 @@ constexpr unsigned kMaxDosesPerCycle = 5;
 
 constexpr unsigned kWateringPauseSec = kSecInDay;
 
+// The moisture history stores at most one reading per plant in this interval.
+constexpr unsigned kHistoryMoistureIntervalSec = 5 * kSecInMin;
+// Buffered history records are appended to flash at least this often.
+constexpr unsigned long kHistoryFlushMsec = 10 * kMsecInMin;
+// The history flash budget is kHistoryMaxSegments segments of kHistorySegmentBytes each.
+constexpr size_t kHistorySegmentBytes = 16 * 1024;
+constexpr unsigned kHistoryMaxSegments = 8;
+
+// The drying forecast measures the drying rate over readings at least this far apart.
+constexpr float kForecastRateSec = 10 * kSecInMin;
+// Forgetting factor for each drying rate, which weighs about the last 200 rates (~1.5 days).
+constexpr float kForecastForgetting = 0.995f;
+// Below this drying rate in %/hour, there is no forecast of the next watering.
+constexpr float kForecastMinDryingPerHour = 0.01f;
+// While waiting for the soil to dry, check whether to start watering at most this long apart
+//  when the forecast says watering is a long way off.  Moisture is still read every
+//  kWaitForNextCycleMsec.
+constexpr unsigned long kForecastMaxWaitMsec = 15 * kMsecInMin;
+
+// The input trace is kept in segments of up to kTraceSegmentBytes, using at most
+//  kTraceMaxBytes (about 2.5 days of recording) in at most kTraceMaxSegments files.  The
+//  oldest segments are deleted to make room for a new one.
+constexpr size_t kTraceSegmentBytes = 16 * 1024;
+constexpr size_t kTraceMaxBytes = 128 * 1024;
+constexpr unsigned kTraceMaxSegments = 32;
+
+// While MQTT is disconnected, each variable group is queued for sending later at most this
+//  often, and also whenever a watering state changes.
+constexpr unsigned long kMqttBacklogIntervalMsec = 5 * kMsecInMin;
+// The backlog keeps the newest messages in RAM, and older ones in a LittleFS file.
+constexpr size_t kMqttBacklogRamBytes = 16 * 1024;
+constexpr size_t kMqttBacklogFileBytes = 64 * 1024;
+// After reconnecting, wait for discovery and current values to go out, then send the
+//  backlog kMqttReplayBatch messages at a time every kMqttReplayPeriodMsec.
+constexpr unsigned long kMqttReplayDelayMsec = 5 * kMsecInSec;
+constexpr unsigned long kMqttReplayPeriodMsec = 250;
+constexpr unsigned kMqttReplayBatch = 4;
+
 }  // namespace og3
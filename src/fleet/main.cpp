@@ -0,0 +1,278 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+// A load generator which runs a fleet of virtual Plant133 devices against an MQTT broker, to
+//  size the broker and see what a site-wide power cut costs when every device reconnects and
+//  sends its Home Assistant discovery at once.
+//
+//   pio run -e fleet
+//   .pio/build/fleet/program --devices 300 --speed 10 --outage-at 60 --duration 180
+//
+// Each device runs the real watering code on simulated hardware (see lib/sim/sim_device.h),
+//  on a virtual clock which runs --speed times faster than wall time.  Connections,
+//  reconnects and reports use wall time.
+
+#include <poll.h>
+#include <sim_device.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "mqtt_client.h"
+#include "virtual_device.h"
+
+namespace {
+
+// Virtual msec per run of the application loop of every device.
+constexpr uint32_t kTickMsec = 1000;
+// Ticks run between polls of the network, so that a fast clock does not starve the sockets.
+constexpr unsigned kMaxTicksPerPoll = 20;
+
+struct Options {
+  unsigned devices = 100;
+  fleet::BrokerOptions broker;
+  float speed = 1.0f;
+  unsigned duration_secs = 120;
+  unsigned report_secs = 5;
+  // Wall secs after start at which every device loses power, and for how long (0: never).
+  unsigned outage_at_secs = 0;
+  unsigned outage_secs = 10;
+  uint32_t seed = 1;
+};
+
+void usage(const char* prog) {
+  fprintf(stderr,
+          "usage: %s [--devices N] [--broker HOST] [--port PORT] [--speed X] [--duration SECS]\n"
+          "          [--report SECS] [--outage-at SECS] [--outage-secs SECS] [--seed N]\n",
+          prog);
+  exit(2);
+}
+
+Options parseArgs(int argc, char** argv) {
+  Options opts;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) {
+      usage(argv[0]);
+    }
+    const char* arg = argv[i];
+    const char* val = argv[++i];
+    if (!strcmp(arg, "--devices")) {
+      opts.devices = atoi(val);
+    } else if (!strcmp(arg, "--broker")) {
+      opts.broker.host = val;
+    } else if (!strcmp(arg, "--port")) {
+      opts.broker.port = atoi(val);
+    } else if (!strcmp(arg, "--speed")) {
+      opts.speed = atof(val);
+    } else if (!strcmp(arg, "--duration")) {
+      opts.duration_secs = atoi(val);
+    } else if (!strcmp(arg, "--report")) {
+      opts.report_secs = std::max(1, atoi(val));
+    } else if (!strcmp(arg, "--outage-at")) {
+      opts.outage_at_secs = atoi(val);
+    } else if (!strcmp(arg, "--outage-secs")) {
+      opts.outage_secs = atoi(val);
+    } else if (!strcmp(arg, "--seed")) {
+      opts.seed = atoi(val);
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (opts.devices == 0 || opts.speed <= 0.0f) {
+    usage(argv[0]);
+  }
+  return opts;
+}
+
+uint64_t wallMsec() {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// What happens after every device powers on at once, until all of them are connected.
+struct Storm {
+  const char* what = nullptr;
+  uint64_t start_msec = 0;
+  fleet::MqttStats start_stats;
+  uint64_t peak_msgs_per_sec = 0;
+  bool done = false;
+};
+
+void reportStorm(const Storm& storm, const fleet::MqttStats& stats, uint64_t now,
+                 const std::vector<std::unique_ptr<fleet::VirtualDevice>>& devices) {
+  uint64_t max_connect = 0;
+  uint64_t max_connack = 0;
+  for (const auto& device : devices) {
+    max_connect = std::max(max_connect, device->connectedAfterBootMsec());
+    max_connack = std::max(max_connack, device->mqtt().connackMsec());
+  }
+  printf(
+      "%s: %zu devices connected after %.1fs (slowest boot to connect %.1fs, slowest CONNACK "
+      "%llums), %llu connect failures, %llu discovery msgs / %.1f kB, peak %llu msgs/s\n",
+      storm.what, devices.size(), (now - storm.start_msec) / 1000.0, max_connect / 1000.0,
+      static_cast<unsigned long long>(max_connack),
+      static_cast<unsigned long long>(stats.connect_failures - storm.start_stats.connect_failures),
+      static_cast<unsigned long long>(stats.discovery_messages -
+                                      storm.start_stats.discovery_messages),
+      (stats.discovery_bytes - storm.start_stats.discovery_bytes) / 1024.0,
+      static_cast<unsigned long long>(storm.peak_msgs_per_sec));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const Options opts = parseArgs(argc, argv);
+  sim::fakeHardware();
+
+  fleet::MqttStats stats;
+  std::vector<std::unique_ptr<fleet::VirtualDevice>> devices;
+  for (unsigned i = 0; i < opts.devices; i++) {
+    devices.emplace_back(new fleet::VirtualDevice(i, opts.seed, opts.broker, &stats));
+  }
+
+  const uint64_t start = wallMsec();
+  const uint64_t end = start + opts.duration_secs * 1000ull;
+  const uint64_t outage_start = start + opts.outage_at_secs * 1000ull;
+  const uint64_t outage_end = outage_start + opts.outage_secs * 1000ull;
+  bool outage_begun = opts.outage_at_secs == 0;
+  bool outage_ended = outage_begun;
+
+  uint32_t virtual_msec = 0;
+  uint64_t virtual_ticks = 0;
+  for (auto& device : devices) {
+    device->boot(virtual_msec, start);
+  }
+  Storm storm;
+  storm.what = "power on";
+  storm.start_msec = start;
+
+  uint64_t next_report = start + opts.report_secs * 1000ull;
+  uint64_t next_second = start + 1000;
+  uint64_t second_messages = 0;
+  fleet::MqttStats last_stats;
+  std::vector<pollfd> fds;
+  std::vector<fleet::VirtualDevice*> fd_devices;
+  std::vector<uint64_t> connacks;
+
+  printf("%u devices, broker %s:%u, virtual clock x%.1f\n", opts.devices, opts.broker.host,
+         opts.broker.port, opts.speed);
+  for (uint64_t now = start; now < end; now = wallMsec()) {
+    if (!outage_begun && now >= outage_start) {
+      outage_begun = true;
+      printf("%7.1fs power cut\n", (now - start) / 1000.0);
+      for (auto& device : devices) {
+        device->powerOff();
+      }
+    }
+    if (outage_begun && !outage_ended && now >= outage_end) {
+      outage_ended = true;
+      printf("%7.1fs power restored\n", (now - start) / 1000.0);
+      for (auto& device : devices) {
+        device->boot(virtual_msec, now);
+      }
+      storm = Storm();
+      storm.what = "power restored";
+      storm.start_msec = now;
+      storm.start_stats = stats;
+    }
+
+    // Advance every device together on the virtual clock.
+    const uint64_t target_ticks = static_cast<uint64_t>((now - start) * opts.speed / kTickMsec);
+    for (unsigned n = 0; virtual_ticks < target_ticks && n < kMaxTicksPerPoll; n++) {
+      virtual_ticks += 1;
+      virtual_msec += kTickMsec;
+      for (auto& device : devices) {
+        device->step(virtual_msec);
+      }
+    }
+
+    fds.clear();
+    fd_devices.clear();
+    for (auto& device : devices) {
+      device->poll(now);
+      const fleet::MqttClient& mqtt = device->mqtt();
+      if (mqtt.fd() >= 0) {
+        const short events = POLLIN | (mqtt.wantWrite() ? POLLOUT : 0);
+        fds.push_back({mqtt.fd(), events, 0});
+        fd_devices.push_back(device.get());
+      }
+    }
+    ::poll(fds.data(), fds.size(), virtual_ticks < target_ticks ? 0 : 10);
+    now = wallMsec();
+    for (size_t i = 0; i < fds.size(); i++) {
+      const bool error = fds[i].revents & (POLLERR | POLLHUP);
+      fd_devices[i]->mqtt().poll((fds[i].revents & POLLIN) || error,
+                                 (fds[i].revents & POLLOUT) || error, now);
+    }
+
+    if (now >= next_second) {
+      next_second = now + 1000;
+      if (!storm.done) {
+        storm.peak_msgs_per_sec =
+            std::max(storm.peak_msgs_per_sec, stats.messages - second_messages);
+      }
+      second_messages = stats.messages;
+    }
+
+    if (now >= next_report) {
+      const double secs = (now - next_report + opts.report_secs * 1000ull) / 1000.0;
+      next_report = now + opts.report_secs * 1000ull;
+      unsigned connected = 0;
+      size_t backlog = 0;
+      connacks.clear();
+      for (const auto& device : devices) {
+        backlog += device->backlogSize();
+        if (device->mqtt().connected()) {
+          connected += 1;
+          connacks.push_back(device->mqtt().connackMsec());
+        }
+      }
+      std::sort(connacks.begin(), connacks.end());
+      const uint64_t msgs_per_sec =
+          static_cast<uint64_t>((stats.messages - last_stats.messages) / secs);
+      printf(
+          "%7.1fs %6.1fh virtual  %u/%u connected  %llu msgs/s  %.1f kB/s  CONNACK p50 %llums "
+          "max %llums  dropped %llu  disconnects %llu  backlog %zu\n",
+          (now - start) / 1000.0, virtual_msec / 3600000.0, connected, opts.devices,
+          static_cast<unsigned long long>(msgs_per_sec),
+          (stats.bytes - last_stats.bytes) / 1024.0 / secs,
+          static_cast<unsigned long long>(connacks.empty() ? 0 : connacks[connacks.size() / 2]),
+          static_cast<unsigned long long>(connacks.empty() ? 0 : connacks.back()),
+          static_cast<unsigned long long>(stats.dropped - last_stats.dropped),
+          static_cast<unsigned long long>(stats.disconnects - last_stats.disconnects), backlog);
+      last_stats = stats;
+      if (virtual_ticks < target_ticks) {
+        printf("         virtual clock is %.1fs behind; lower --speed or --devices\n",
+               (target_ticks - virtual_ticks) * kTickMsec / 1000.0);
+      }
+      fflush(stdout);
+    }
+
+    if (!storm.done && outage_ended == outage_begun) {
+      storm.done = std::all_of(devices.begin(), devices.end(), [](const auto& device) {
+        return device->connectedAfterBootMsec() != 0;
+      });
+      if (storm.done) {
+        reportStorm(storm, stats, now, devices);
+      }
+    }
+  }
+
+  if (!storm.done) {
+    printf("%s: not every device connected before the end of the run\n", storm.what);
+  }
+  printf("total: %llu msgs, %.1f kB (discovery %llu msgs, %.1f kB, backlog %llu msgs), "
+         "%llu dropped, %llu connect attempts, %llu failures\n",
+         static_cast<unsigned long long>(stats.messages), stats.bytes / 1024.0,
+         static_cast<unsigned long long>(stats.discovery_messages),
+         stats.discovery_bytes / 1024.0, static_cast<unsigned long long>(stats.backlog_messages),
+         static_cast<unsigned long long>(stats.dropped),
+         static_cast<unsigned long long>(stats.connect_attempts),
+         static_cast<unsigned long long>(stats.connect_failures));
+  return 0;
+}
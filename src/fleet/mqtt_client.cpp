@@ -0,0 +1,230 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "mqtt_client.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <utility>
+
+namespace fleet {
+
+namespace {
+
+constexpr uint8_t kConnect = 0x10;
+constexpr uint8_t kConnack = 0x20;
+constexpr uint8_t kPublish = 0x30;
+constexpr uint8_t kPingReq = 0xc0;
+
+void appendLength(std::string* out, size_t len) {
+  do {
+    uint8_t byte = len % 128;
+    len /= 128;
+    if (len > 0) {
+      byte |= 0x80;
+    }
+    out->push_back(static_cast<char>(byte));
+  } while (len > 0);
+}
+
+void appendString(std::string* out, const std::string& str) {
+  out->push_back(static_cast<char>(str.size() >> 8));
+  out->push_back(static_cast<char>(str.size() & 0xff));
+  out->append(str);
+}
+
+}  // namespace
+
+MqttClient::MqttClient(std::string client_id, MqttStats* stats)
+    : m_client_id(std::move(client_id)), m_stats(stats) {}
+
+MqttClient::~MqttClient() { abort(); }
+
+bool MqttClient::connect(const char* host, uint16_t port, uint64_t nowMsec) {
+  abort();
+  m_stats->connect_attempts += 1;
+  m_connect_start_msec = nowMsec;
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addrs = nullptr;
+  const std::string port_str = std::to_string(port);
+  if (getaddrinfo(host, port_str.c_str(), &hints, &addrs) != 0 || !addrs) {
+    m_stats->connect_failures += 1;
+    return false;
+  }
+  m_fd = socket(addrs->ai_family, SOCK_STREAM, 0);
+  if (m_fd < 0) {
+    freeaddrinfo(addrs);
+    m_stats->connect_failures += 1;
+    return false;
+  }
+  fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL, 0) | O_NONBLOCK);
+  const int one = 1;
+  setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  const int res = ::connect(m_fd, addrs->ai_addr, addrs->ai_addrlen);
+  freeaddrinfo(addrs);
+  if (res < 0 && errno != EINPROGRESS) {
+    m_stats->connect_failures += 1;
+    abort();
+    return false;
+  }
+  m_state = State::kConnecting;
+  return true;
+}
+
+void MqttClient::abort() {
+  if (m_fd >= 0) {
+    close(m_fd);
+    m_fd = -1;
+  }
+  m_state = State::kDisconnected;
+  m_out.clear();
+  m_in.clear();
+}
+
+void MqttClient::fail() {
+  if (m_state == State::kConnected) {
+    m_stats->disconnects += 1;
+  } else {
+    m_stats->connect_failures += 1;
+  }
+  abort();
+}
+
+void MqttClient::queueConnect() {
+  std::string body;
+  appendString(&body, "MQTT");
+  body.push_back(4);                                // Protocol level 3.1.1.
+  body.push_back(0x02);                             // Clean session.
+  body.push_back(static_cast<char>(kKeepAliveSec >> 8));
+  body.push_back(static_cast<char>(kKeepAliveSec & 0xff));
+  appendString(&body, m_client_id);
+  m_out.push_back(static_cast<char>(kConnect));
+  appendLength(&m_out, body.size());
+  m_out += body;
+}
+
+bool MqttClient::publish(const std::string& topic, const std::string& payload, bool retain,
+                         bool discovery) {
+  const size_t len = 2 + topic.size() + payload.size();
+  if (m_state != State::kConnected || m_out.size() + len + 5 > kMaxQueuedBytes) {
+    m_stats->dropped += 1;
+    return false;
+  }
+  const size_t before = m_out.size();
+  m_out.push_back(static_cast<char>(kPublish | (retain ? 1 : 0)));
+  appendLength(&m_out, len);
+  appendString(&m_out, topic);
+  m_out += payload;
+  const size_t bytes = m_out.size() - before;
+  m_stats->messages += 1;
+  m_stats->bytes += bytes;
+  if (discovery) {
+    m_stats->discovery_messages += 1;
+    m_stats->discovery_bytes += bytes;
+  }
+  return true;
+}
+
+void MqttClient::flush() {
+  while (!m_out.empty()) {
+    const ssize_t n = send(m_fd, m_out.data(), m_out.size(), MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        fail();
+      }
+      return;
+    }
+    m_out.erase(0, n);
+  }
+}
+
+void MqttClient::readPackets(uint64_t nowMsec) {
+  char buf[512];
+  for (;;) {
+    const ssize_t n = recv(m_fd, buf, sizeof(buf), 0);
+    if (n == 0) {
+      fail();
+      return;
+    }
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        fail();
+      }
+      break;
+    }
+    m_in.append(buf, n);
+  }
+  // Brokers only send CONNACK, PINGRESP and DISCONNECT to a QoS 0 publisher.
+  while (m_in.size() >= 2) {
+    size_t len = 0;
+    size_t pos = 1;
+    unsigned shift = 0;
+    for (;;) {
+      if (pos >= m_in.size()) {
+        return;
+      }
+      const uint8_t byte = m_in[pos++];
+      len |= static_cast<size_t>(byte & 0x7f) << shift;
+      shift += 7;
+      if (!(byte & 0x80)) {
+        break;
+      }
+    }
+    if (m_in.size() < pos + len) {
+      return;
+    }
+    const uint8_t type = m_in[0] & 0xf0;
+    if (type == kConnack && m_state == State::kWaitConnack) {
+      if (len < 2 || m_in[pos + 1] != 0) {
+        fail();
+        return;
+      }
+      m_state = State::kConnected;
+      m_connack_msec = nowMsec - m_connect_start_msec;
+    }
+    m_in.erase(0, pos + len);
+  }
+}
+
+void MqttClient::poll(bool readable, bool writable, uint64_t nowMsec) {
+  if (m_fd < 0) {
+    return;
+  }
+  if (m_state == State::kConnecting) {
+    if (!writable) {
+      return;
+    }
+    int err = 0;
+    socklen_t err_len = sizeof(err);
+    if (getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &err, &err_len) < 0 || err != 0) {
+      fail();
+      return;
+    }
+    m_state = State::kWaitConnack;
+    queueConnect();
+  }
+  if (readable) {
+    readPackets(nowMsec);
+  }
+  if (m_state == State::kConnected && m_out.empty() &&
+      nowMsec - m_last_send_msec >= kKeepAliveSec * 1000 / 2) {
+    m_out.push_back(static_cast<char>(kPingReq));
+    m_out.push_back(0);
+  }
+  if (m_fd >= 0 && !m_out.empty()) {
+    flush();
+    m_last_send_msec = nowMsec;
+  }
+}
+
+}  // namespace fleet
@@ -0,0 +1,80 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace fleet {
+
+// Counters shared by all connections of the load generator.
+struct MqttStats {
+  uint64_t messages = 0;
+  uint64_t bytes = 0;
+  uint64_t discovery_messages = 0;
+  uint64_t discovery_bytes = 0;
+  // Messages queued while disconnected and sent after reconnecting.
+  uint64_t backlog_messages = 0;
+  // Publishes dropped because the connection was down or its send buffer was full.
+  uint64_t dropped = 0;
+  uint64_t connect_attempts = 0;
+  uint64_t connect_failures = 0;
+  uint64_t disconnects = 0;
+};
+
+// A minimal non-blocking MQTT 3.1.1 client for the fleet load generator: it connects,
+//  publishes at QoS 0 and keeps the connection alive, which is all the firmware does.
+// Call poll() often, and watch fd() for wantWrite() when it is connected or connecting.
+class MqttClient {
+ public:
+  enum class State { kDisconnected, kConnecting, kWaitConnack, kConnected };
+
+  MqttClient(std::string client_id, MqttStats* stats);
+  ~MqttClient();
+  MqttClient(const MqttClient&) = delete;
+  MqttClient& operator=(const MqttClient&) = delete;
+
+  // Start connecting to host:port, with nowMsec in wall-clock msec.
+  bool connect(const char* host, uint16_t port, uint64_t nowMsec);
+  // Drop the connection without a DISCONNECT, as when the device loses power.
+  void abort();
+
+  // Queue a QoS 0 publish.  Returns false if it was dropped.
+  bool publish(const std::string& topic, const std::string& payload, bool retain,
+               bool discovery = false);
+
+  // Handle socket events and keep-alives.
+  void poll(bool readable, bool writable, uint64_t nowMsec);
+
+  int fd() const { return m_fd; }
+  State state() const { return m_state; }
+  bool connected() const { return m_state == State::kConnected; }
+  bool wantWrite() const { return m_state == State::kConnecting || !m_out.empty(); }
+  // Msec from starting to connect to receiving CONNACK, for the latest connection.
+  uint64_t connackMsec() const { return m_connack_msec; }
+  size_t queuedBytes() const { return m_out.size(); }
+
+  // Bytes queued per connection before publishes are dropped, like a full TCP send buffer.
+  static constexpr size_t kMaxQueuedBytes = 64 * 1024;
+  static constexpr uint16_t kKeepAliveSec = 60;
+
+ private:
+  void fail();
+  void queueConnect();
+  void flush();
+  void readPackets(uint64_t nowMsec);
+
+  const std::string m_client_id;
+  MqttStats* const m_stats;
+  int m_fd = -1;
+  State m_state = State::kDisconnected;
+  std::string m_out;
+  std::string m_in;
+  uint64_t m_connect_start_msec = 0;
+  uint64_t m_connack_msec = 0;
+  uint64_t m_last_send_msec = 0;
+};
+
+}  // namespace fleet
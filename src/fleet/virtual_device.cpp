@@ -0,0 +1,279 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include "virtual_device.h"
+
+#include <uptime.h>
+#include <watering_constants.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace fleet {
+
+namespace {
+
+constexpr float kMsecInHour = 3600.0f * 1000.0f;
+constexpr float kWetPerSec = 0.5f;
+constexpr float kAdcNoise = 8.0f;
+// Time from power-on until the device has joined WiFi and starts MQTT.
+constexpr uint32_t kMinJoinMsec = 2000;
+constexpr uint32_t kMaxJoinMsec = 6000;
+// The climate group is published on the sampler period in src/main.cpp.
+constexpr uint32_t kClimateMsec = 60 * 1000;
+const char kClimateGroup[] = "plant133";
+
+std::string deviceId(unsigned index) {
+  char id[32];
+  snprintf(id, sizeof(id), "plant133-%04u", index);
+  return id;
+}
+
+}  // namespace
+
+VirtualDevice::VirtualDevice(unsigned index, uint32_t seed, const BrokerOptions& broker,
+                             MqttStats* stats)
+    : m_id(deviceId(index)),
+      m_broker(broker),
+      m_stats(stats),
+      m_rng(seed * 7919u + index),
+      m_mqtt(m_id, stats),
+      m_backlog(og3::kMqttBacklogRamBytes) {
+  auto uniformf = [this](float lo, float hi) {
+    return std::uniform_real_distribution<float>(lo, hi)(m_rng);
+  };
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    m_moisture[i] = uniformf(30.0f, 80.0f);
+    m_dry_per_hour[i] = uniformf(0.2f, 2.0f);
+  }
+  m_reservoir_ml = uniformf(0.2f, 1.0f) * og3::kReservoirCapacityMl;
+  m_temperature = uniformf(18.0f, 26.0f);
+  m_humidity = uniformf(30.0f, 60.0f);
+}
+
+void VirtualDevice::boot(uint32_t msec, uint64_t wallMsec) {
+  sim::setHardware(&m_hw);
+  m_hw.now_msec = msec;
+  m_device.reset(new sim::Device());
+
+  JsonDocument doc;
+  JsonArray plants = doc["plants"].to<JsonArray>();
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    JsonObject json = plants.add<JsonObject>();
+    json["id"] = i + 1;
+    json["minMoisture"] = 40;
+    json["maxMoisture"] = 55;
+    json["adc0"] = og3::kNoMoistureCounts;
+    json["adc100"] = og3::kFullMoistureCounts;
+    json["enabled"] = true;
+    json["reservoirCheck"] = true;
+  }
+  doc["reservoir"].to<JsonObject>();
+  std::string config;
+  serializeJson(doc, config);
+  m_device->applyConfig(config.data(), config.size());
+
+  m_boot_wall_msec = wallMsec;
+  m_next_connect_wall_msec =
+      wallMsec + kMinJoinMsec + m_rng() % (kMaxJoinMsec - kMinJoinMsec);
+  m_connected_after_boot_msec = 0;
+  m_announced = false;
+  m_next_climate_msec = msec;
+  for (auto& last : m_last_plant) {
+    last.clear();
+  }
+  m_last_reservoir.clear();
+  // The backlog is in RAM, and the firmware replaces its overflow file after a reboot.
+  m_backlog.clear();
+  m_queued_msec.clear();
+}
+
+void VirtualDevice::powerOff() {
+  m_mqtt.abort();
+  for (bool& on : m_hw.pump_on) {
+    on = false;
+  }
+  m_device.reset();
+}
+
+void VirtualDevice::stepPhysics(uint32_t dt) {
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    m_moisture[i] -= m_dry_per_hour[i] * dt / kMsecInHour;
+    if (m_hw.pump_on[i] && m_reservoir_ml > 0.0f) {
+      m_moisture[i] += kWetPerSec * dt / 1000.0f;
+      m_reservoir_ml -= og3::kPumpFlowMlPerSec * dt / 1000.0f;
+    }
+    m_moisture[i] = std::min(100.0f, std::max(0.0f, m_moisture[i]));
+    const float full = og3::kFullMoistureCounts;
+    const float none = og3::kNoMoistureCounts;
+    const float counts = none + (full - none) * m_moisture[i] / 100.0f +
+                         std::normal_distribution<float>(0.0f, kAdcNoise)(m_rng);
+    m_hw.adc[i] = static_cast<uint16_t>(std::min(4095.0f, std::max(0.0f, counts)));
+  }
+  // Someone refills the reservoir a while after it runs low.
+  if (m_reservoir_ml < 0.05f * og3::kReservoirCapacityMl && m_rng() % 10000 == 0) {
+    m_reservoir_ml = og3::kReservoirCapacityMl;
+  }
+  m_reservoir_ml = std::max(0.0f, m_reservoir_ml);
+  m_hw.float_level = m_reservoir_ml > 0.25f * og3::kReservoirCapacityMl ? HIGH : LOW;
+}
+
+void VirtualDevice::maintainConnection(uint64_t wallMsec) {
+  if (m_mqtt.state() == MqttClient::State::kDisconnected) {
+    if (wallMsec >= m_next_connect_wall_msec) {
+      m_mqtt.connect(m_broker.host, m_broker.port, wallMsec);
+      m_next_connect_wall_msec = wallMsec + kRetryMsec + m_rng() % 1000;
+    }
+    m_announced = false;
+    return;
+  }
+  if (m_mqtt.connected() && !m_announced) {
+    if (m_connected_after_boot_msec == 0) {
+      m_connected_after_boot_msec = std::max<uint64_t>(1, wallMsec - m_boot_wall_msec);
+    }
+    announce();
+    m_next_replay_wall_msec = wallMsec + og3::kMqttReplayDelayMsec;
+  }
+}
+
+void VirtualDevice::announce() {
+  // Home Assistant discovery for every variable of every published group, retained, then
+  //  the full state, as the device sends when MQTT connects.
+  auto discover = [this](const char* group, const og3::VariableGroup& vg) {
+    JsonDocument values;
+    vg.toJson(values.to<JsonObject>(), 0);
+    for (JsonPair kv : values.as<JsonObject>()) {
+      const char* var = kv.key().c_str();
+      JsonDocument doc;
+      doc["name"] = var;
+      doc["unique_id"] = m_id + "_" + group + "_" + var;
+      doc["state_topic"] = m_id + "/" + group;
+      doc["value_template"] = std::string("{{ value_json.") + var + " }}";
+      JsonObject device = doc["device"].to<JsonObject>();
+      device["identifiers"].to<JsonArray>().add(m_id);
+      device["name"] = m_id;
+      device["manufacturer"] = "Chris Lee";
+      device["model"] = "Plantl337";
+      std::string payload;
+      serializeJson(doc, payload);
+      m_mqtt.publish("homeassistant/sensor/" + m_id + "_" + group + "/" + var + "/config",
+                     payload, true, true);
+    }
+  };
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    discover(sim::kPlantNames[i], m_device->plant(i).variables());
+  }
+  discover(og3::ReservoirCheck::kName, m_device->reservoir().variables());
+  m_announced = true;
+
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    publishGroup(sim::kPlantNames[i], m_device->plant(i).variables(), &m_last_plant[i], true);
+  }
+  publishGroup(og3::ReservoirCheck::kName, m_device->reservoir().variables(), &m_last_reservoir,
+               true);
+  publishClimate(true);
+}
+
+void VirtualDevice::publishGroup(const char* group, const og3::VariableGroup& vg,
+                                 std::string* last, bool force, bool event) {
+  JsonDocument doc;
+  vg.toJson(doc.to<JsonObject>(), 0);
+  std::string payload;
+  serializeJson(doc, payload);
+  if (!force && payload == *last) {
+    return;
+  }
+  *last = payload;
+  if (m_mqtt.connected()) {
+    m_mqtt.publish(m_id + "/" + group, payload, false);
+  } else {
+    queue(group, payload, event);
+  }
+}
+
+void VirtualDevice::publishClimate(bool force) {
+  if (!force && og3::msecBefore(m_hw.now_msec, m_next_climate_msec)) {
+    return;
+  }
+  m_next_climate_msec = m_hw.now_msec + kClimateMsec;
+  m_temperature += std::normal_distribution<float>(0.0f, 0.05f)(m_rng);
+  m_humidity += std::normal_distribution<float>(0.0f, 0.2f)(m_rng);
+  m_device->climate().set(m_temperature, m_humidity, m_hw.now_msec);
+  char payload[64];
+  snprintf(payload, sizeof(payload), "{\"temperature\":%.1f,\"humidity\":%.1f}", m_temperature,
+           m_humidity);
+  if (m_mqtt.connected()) {
+    m_mqtt.publish(m_id + "/" + kClimateGroup, payload, false);
+  } else {
+    queue(kClimateGroup, payload, false);
+  }
+}
+
+void VirtualDevice::queue(const char* group, const std::string& payload, bool event) {
+  const auto iter = m_queued_msec.find(group);
+  if (!event && iter != m_queued_msec.end() &&
+      m_hw.now_msec - iter->second < og3::kMqttBacklogIntervalMsec) {
+    return;
+  }
+  m_queued_msec[group] = m_hw.now_msec;
+  // Add the time of the reading to the JSON object.
+  char time[24];
+  snprintf(time, sizeof(time), ",\"t\":%u}", m_hw.now_msec / 1000);
+  const std::string msg = payload.substr(0, payload.size() - 1) + time;
+  const std::string topic = m_id + "/" + group + "/backlog";
+  m_backlog.push(topic.c_str(), msg.data(), msg.size());
+}
+
+void VirtualDevice::replay(uint64_t wallMsec) {
+  if (!m_announced || !m_mqtt.connected() || m_backlog.empty() ||
+      wallMsec < m_next_replay_wall_msec) {
+    return;
+  }
+  m_next_replay_wall_msec = wallMsec + og3::kMqttReplayPeriodMsec;
+  for (unsigned i = 0; i < og3::kMqttReplayBatch; i++) {
+    const og3::MqttBacklog::Message* msg = m_backlog.front();
+    if (!msg || !m_mqtt.publish(msg->topic, msg->payload, false)) {
+      break;
+    }
+    m_stats->backlog_messages += 1;
+    m_backlog.pop();
+  }
+}
+
+void VirtualDevice::poll(uint64_t wallMsec) {
+  if (m_device) {
+    maintainConnection(wallMsec);
+    replay(wallMsec);
+  }
+}
+
+void VirtualDevice::step(uint32_t msec) {
+  if (!m_device) {
+    return;
+  }
+  sim::setHardware(&m_hw);
+  const uint32_t dt = msec - m_hw.now_msec;
+  m_hw.now_msec = msec;
+  stepPhysics(dt);
+  publishClimate(false);
+  og3::Watering::State states[sim::kNumPlants];
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    states[i] = m_device->plant(i).state();
+  }
+  m_device->loop();
+  // The firmware publishes a plant after each update of its state machine, which always
+  //  changes its variables, and the reservoir along with it.
+  bool plant_published = false;
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    const std::string before = m_last_plant[i];
+    publishGroup(sim::kPlantNames[i], m_device->plant(i).variables(), &m_last_plant[i], false,
+                 states[i] != m_device->plant(i).state());
+    plant_published |= before != m_last_plant[i];
+  }
+  if (plant_published) {
+    publishGroup(og3::ReservoirCheck::kName, m_device->reservoir().variables(), &m_last_reservoir,
+                 true);
+  }
+}
+
+}  // namespace fleet
@@ -0,0 +1,94 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#pragma once
+
+#include <mqtt_backlog.h>
+#include <sim_device.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "mqtt_client.h"
+
+namespace fleet {
+
+// Where the virtual devices connect.
+struct BrokerOptions {
+  const char* host = "127.0.0.1";
+  uint16_t port = 1883;
+};
+
+// One Plant133 on simulated hardware: the real watering code runs on a virtual clock over a
+//  simple soil and reservoir model, and publishes what the device publishes over its own
+//  MQTT connection.
+class VirtualDevice {
+ public:
+  VirtualDevice(unsigned index, uint32_t seed, const BrokerOptions& broker, MqttStats* stats);
+
+  const std::string& id() const { return m_id; }
+  MqttClient& mqtt() { return m_mqtt; }
+  bool running() const { return m_device != nullptr; }
+
+  // Power on with millis() at msec, and connect after the device would have joined WiFi.
+  void boot(uint32_t msec, uint64_t wallMsec);
+  // Lose power: the connection drops without a DISCONNECT.
+  void powerOff();
+
+  // Connect and announce when it is time to.
+  void poll(uint64_t wallMsec);
+  // Advance the device to msec of virtual time and run its application loop once.
+  // Native builds extend one millis() into uptimeUsec(), so step every device to the same
+  //  msec before stepping any of them further.
+  void step(uint32_t msec);
+
+  // Wall-clock msec taken to connect after the latest boot, or 0 while not connected.
+  uint64_t connectedAfterBootMsec() const { return m_connected_after_boot_msec; }
+  // Messages waiting to be sent after reconnecting.
+  size_t backlogSize() const { return m_backlog.size(); }
+
+  // Retry period for failed connections.
+  static constexpr uint32_t kRetryMsec = 5000;
+
+ private:
+  void stepPhysics(uint32_t dt);
+  void maintainConnection(uint64_t wallMsec);
+  void announce();
+  void publishGroup(const char* group, const og3::VariableGroup& vg, std::string* last,
+                    bool force, bool event = false);
+  void publishClimate(bool force);
+  // Queue a message while disconnected, as og3::Telemetry does, and send it after reconnecting.
+  void queue(const char* group, const std::string& payload, bool event);
+  void replay(uint64_t wallMsec);
+
+  const std::string m_id;
+  const BrokerOptions m_broker;
+  MqttStats* const m_stats;
+  std::mt19937 m_rng;
+  sim::Hardware m_hw;
+  std::unique_ptr<sim::Device> m_device;
+  MqttClient m_mqtt;
+
+  // Soil and reservoir model.
+  float m_moisture[sim::kNumPlants];
+  float m_dry_per_hour[sim::kNumPlants];
+  float m_reservoir_ml;
+  float m_temperature;
+  float m_humidity;
+
+  uint64_t m_boot_wall_msec = 0;
+  uint64_t m_next_connect_wall_msec = 0;
+  uint64_t m_connected_after_boot_msec = 0;
+  bool m_announced = false;
+  uint32_t m_next_climate_msec = 0;
+  std::string m_last_plant[sim::kNumPlants];
+  std::string m_last_reservoir;
+  og3::MqttBacklog m_backlog;
+  std::map<std::string, uint32_t> m_queued_msec;
+  uint64_t m_next_replay_wall_msec = 0;
+};
+
+}  // namespace fleet
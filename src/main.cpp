@@ -11,7 +11,6 @@
 #include <og3/ha_app.h>
 #include <og3/html_table.h>
 #include <og3/oled_wifi_info.h>
-#include <og3/shtc3.h>
 #include <og3/units.h>
 #include <og3/variable.h>
 
@@ -21,7 +20,17 @@
 #include "ArduinoJson/Deserialization/DeserializationError.hpp"
 #include "ArduinoJson/Deserialization/deserialize.hpp"
 #include "ArduinoJson/Document/JsonDocument.hpp"
+#include "change_tracker.h"
+#include "climate_sampler.h"
+#include "html_stream.h"
+#include "live_config.h"
+#include "ota_upload.h"
+#include "plant_router.h"
+#include "rate_limiter.h"
+#include "static_cache.h"
 #include "svelteesp32async.h"
+#include "telemetry.h"
+#include "trace_log.h"
 #include "watering.h"
 
 #define SW_VERSION "0.9.4"
@@ -79,22 +88,40 @@ og3::OledDisplayRing s_oled(&s_app.module_system(), kModel, kOledSwitchMsec, og3
                             og3::Oled::Orientation::kDefault);
 
 // Temperature/humidity sensing in the vicinity of the device.
-og3::VariableGroup s_climate_vg("plant133");
-og3::Shtc3 s_shtc3("temperature", "humidity", &s_app.module_system(), "temperature", s_climate_vg);
-
-// A periodic task to monitor temperature/humidity and send the results via MQTT.
-og3::PeriodicTaskScheduler climate_scheduler(
-    10 * og3::kMsecInSec, og3::kMsecInMin,
-    []() {
-      s_shtc3.read();
-      s_app.mqttSend(s_climate_vg);
-    },
-    &s_app.tasks());
+// Readings are taken every minute, and everything else uses the cached values.
+og3::ClimateSampler s_climate("plant133", og3::kMsecInMin, &s_app);
+
+// Min/mean/max summaries of recent climate readings for charts in the web interface.
+og3::Rollup s_temperature_rollup({-20.0f, 0.25f});
+og3::Rollup s_humidity_rollup({0.0f, 0.5f});
+
+// s_history keeps a log of moisture, pump, reservoir and climate history in flash.
+og3::HistoryLog s_history(&s_app);
+
+// s_trace records the inputs to the watering state machines from boot, for replay in tests.
+og3::TraceLog s_trace(&s_app);
+
+// s_telemetry publishes to MQTT as JSON and/or MessagePack, and encodes MessagePack API
+//  responses.  Its key numbers are tagged with a random value which differs between boots.
+og3::Telemetry s_telemetry(esp_random() & 0xffff, &s_app);
+
+// s_ota_upload takes compressed firmware images at POST /api/ota (see src/ota_pack).
+og3::OtaUpload s_ota_upload(&s_app, OTA_PASSWORD);
+// s_live_config applies WiFi and MQTT settings without a reboot, and rolls them back if the
+//  connection doesn't come back up.
+og3::LiveConfig s_live_config(&s_app);
 
 // s_reservior monitors the water level of the reservoir: the float, and the number of seconds
 //  the pumps have run since the float detected low water level.
 og3::ReservoirCheck s_reservoir(kWaterPin, &s_app);
 
+// s_router is the one web server handler for the pages and API URLs of every plant.
+og3::PlantRouter s_router(&s_app);
+
+// s_limiter limits how often web requests may move pumps, write settings to flash or build
+//  large responses, and how many may be in flight at once.
+og3::RateLimiter s_limiter;
+
 // s_plants are the 4 different plant watering sytems.
 // The code for the plant watering system is in lib/watering/.
 std::array<og3::Watering, 4> s_plants{{
@@ -103,6 +130,8 @@ std::array<og3::Watering, 4> s_plants{{
     {2, "plant3", kMoistureAnalogPin[2], kModeLED, kPumpCtlPin[2], &s_app},
     {3, "plant4", kMoistureAnalogPin[3], kModeLED, kPumpCtlPin[3], &s_app},
 }};
+static_assert(std::tuple_size<decltype(s_plants)>::value <= og3::kMaxPlants,
+              "too many plants for the per-plant tables");
 
 // Web interface buttons for the main device web page.
 og3::WebButton s_button_wifi_config = s_app.createWifiConfigButton();
@@ -112,41 +141,46 @@ og3::WebButton s_button_restart = s_app.createRestartButton();
 
 static String s_body;
 
+// Wrap a web handler so that it only runs for requests admitted by s_limiter.
+ArRequestHandlerFunction limited(og3::RateLimiter::Endpoint endpoint,
+                                 ArRequestHandlerFunction fn) {
+  return [endpoint, fn](AsyncWebServerRequest* request) {
+    if (s_limiter.admit(endpoint, request)) {
+      fn(request);
+    }
+  };
+}
+
 // Web callback for main device web page.
 void handleWebRoot(AsyncWebServerRequest* request) {
-  // The send of the web page happens asynchronously after this function exits, so we need to make
-  // sure the storage for the page remains.  I don't know of a great way to handle the case where
-  // multiple clients are being served data at once.
-  s_body.clear();
-  s_shtc3.read();
-  og3::html::writeTableInto(&s_body, s_climate_vg);
+  // The page is rendered a chunk at a time as it is sent, so it is never held in memory.
+  auto page = og3::HtmlStream::create(s_app.board_cname(), kSoftware);
+  page->table(s_climate.variables());
   // Write a table of watering state variables.
-  og3::html::writeTableInto(&s_body, s_reservoir.variables());
+  page->table(s_reservoir.variables());
   // Write state of Wifi
-  og3::html::writeTableInto(&s_body, s_app.wifi_manager().variables());
+  page->table(s_app.wifi_manager().variables());
   // Write state of MQTT
-  og3::html::writeTableInto(&s_body, s_app.mqtt_manager().variables());
+  page->table(s_app.mqtt_manager().variables());
   // Add config for reservoir.
-  s_reservoir.add_html_status_button(&s_body);
+  page->snippet([](String* out) { s_reservoir.add_html_status_button(out); });
   // Add a button for watering status for each system
   for (const auto& plant : s_plants) {
-    plant.add_html_status_button(&s_body);
+    page->snippet([&plant](String* out) { plant.add_html_status_button(out); });
   }
   // Add a button for configuring Wifi.
-  s_button_wifi_config.add_button(&s_body);
+  page->snippet([](String* out) { s_button_wifi_config.add_button(out); });
   // Add a button for configuring MQTT.
-  s_button_mqtt_config.add_button(&s_body);
+  page->snippet([](String* out) { s_button_mqtt_config.add_button(out); });
   // Add a button for looking at app state.
-  s_button_app_status.add_button(&s_body);
+  page->snippet([](String* out) { s_button_app_status.add_button(out); });
 
-  s_body +=
-      ("<p><button onclick=\"location.href='/static/test.html'\" type=\"button\">"
-       "Test</button></p>\n");
+  page->button("Test", "/static/test.html");
 
   // Add a button for rebooting the device.
-  s_button_restart.add_button(&s_body);
+  page->snippet([](String* out) { s_button_restart.add_button(out); });
   // Send the page back to the web client.
-  og3::sendWrappedHTML(request, s_app.board_cname(), kSoftware, s_body.c_str());
+  og3::HtmlStream::send(page, request);
 }
 
 // This code draws a graphical display of the watering states of plants that are enabled.
@@ -184,41 +218,71 @@ class PercentToY {
   float m_pmin = 0.0f;
 };
 
+// The positions of the marks last drawn by draw_graphs() for each plant, or -1 for a plant
+//  which was not drawn: min target, max target, moisture level and arrow direction.
+std::array<std::array<int16_t, 4>, 4> s_graph_marks;
+// A hash of the screen buffer after draw_graphs() last drew it, to tell whether another
+//  display in the ring has drawn over it since then.
+uint32_t s_graph_hash = 0;
+
+uint32_t screen_hash(const uint8_t* buffer) {
+  // FNV-1a hash.
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < kScreenWidth * kScreenHeight / 8; i++) {
+    hash = (hash ^ buffer[i]) * 16777619u;
+  }
+  return hash;
+}
+
 void draw_graphs() {
-  s_oled.clear();
   auto& scr = s_oled.screen();
+  std::array<std::array<int16_t, 4>, 4> marks;
   for (size_t i = 0; i < s_plants.size(); i++) {
     const auto& plant = s_plants[i];
     if (!plant.isEnabled()) {
+      marks[i] = {-1, -1, -1, -1};
       continue;
     }
-
     PercentToY p2y(plant.minTarget(), plant.maxTarget());
-    auto line = [&scr, &p2y](int16_t x, float percent, int16_t offset) {
-      const int16_t y1 = p2y.y(percent);
+    marks[i] = {p2y.y(plant.minTarget()), p2y.y(plant.maxTarget()),
+                p2y.y(plant.moisturePercent()), static_cast<int16_t>(plant.direction())};
+  }
+  // If no mark has moved a pixel and the screen still shows the graphs, there is nothing to do.
+  if (marks == s_graph_marks && s_graph_hash == screen_hash(scr.buffer)) {
+    return;
+  }
+
+  s_oled.clear();
+  for (size_t i = 0; i < s_plants.size(); i++) {
+    const auto& mark = marks[i];
+    if (mark[0] < 0) {
+      continue;
+    }
+    auto line = [&scr](int16_t x, int16_t y1, int16_t offset) {
       const int16_t y2 = y1 + offset;
-      // s_app.log().logf("x:%d y1:%d y2:%d", (int)x, (int)y1, (int)y2);
       scr.drawLine(x - 3, y2, x, y1);
       scr.drawLine(x, y1, x + 3, y2);
     };
 
     const int16_t x = kScreenWidth * (1 + 2 * i) / 8;
     scr.drawVerticalLine(x, kMargin, kScreenHeight - (2 * kMargin));
-    line(x, plant.minTarget(), 0);
-    line(x, plant.maxTarget(), 0);
-    line(x, plant.moisturePercent(), 3 * plant.direction());
+    line(x, mark[0], 0);
+    line(x, mark[1], 0);
+    line(x, mark[2], 3 * mark[3]);
   }
-  s_oled.screen().display();
+  // With OLEDDISPLAY_DOUBLE_BUFFER, display() sends only the part of the frame which changed.
+  scr.display();
+  s_graph_marks = marks;
+  s_graph_hash = screen_hash(scr.buffer);
 }
 
 // Return current system status as JSON for AJAX status calls.
 void statusJson(AsyncWebServerRequest* request) {
   s_body.clear();
-  s_shtc3.read();
   JsonDocument jsondoc;
   JsonObject json = jsondoc.to<JsonObject>();
 
-  s_climate_vg.toJson(json, 0);
+  s_climate.variables().toJson(json, 0);
   s_reservoir.variables().toJson(json, 0);
   for (const auto& plant : s_plants) {
     plant.variables().toJson(json, 0);
@@ -227,19 +291,34 @@ void statusJson(AsyncWebServerRequest* request) {
   request->send(200, "application/json", s_body);
 }
 
-void apiGetPlants(AsyncWebServerRequest* request) {
-  JsonDocument jsondoc;
-  JsonArray array = jsondoc.to<JsonArray>();
+// Send an API response as JSON, or as MessagePack with numbered keys if the client sent
+//  "Accept: application/msgpack" (see GET /api/schema).
+void sendJson(AsyncWebServerRequest* request, const JsonDocument& jsondoc) {
+  if (og3::Telemetry::wantsMsgPack(request)) {
+    s_telemetry.sendMsgPack(request, jsondoc);
+    return;
+  }
+  s_body.clear();
+  serializeJson(jsondoc, s_body);
+  request->send(200, "application/json", s_body);
+}
 
+// Fill json with configuration and state of each plant.
+void getPlants(JsonArray array) {
   int id = 0;
   for (const auto& plant : s_plants) {
     JsonObject json = array.add<JsonObject>();
     id += 1;
     json["id"] = id;
     plant.getApiPlants(json);
+    json["rawMoisture"] = plant.rawMoisture();
   }
-  serializeJson(jsondoc, s_body);
-  request->send(200, "application/json", s_body);
+}
+
+void apiGetPlants(AsyncWebServerRequest* request) {
+  JsonDocument jsondoc;
+  getPlants(jsondoc.to<JsonArray>());
+  sendJson(request, jsondoc);
 }
 
 void apiGetMoisture(AsyncWebServerRequest* request) {
@@ -256,44 +335,136 @@ void apiGetMoisture(AsyncWebServerRequest* request) {
     json["doseCount"] = plant.doseLog().doseCount();
     json["state"] = plant.stateName();
   }
-  serializeJson(jsondoc, s_body);
-  request->send(200, "application/json", s_body);
+  sendJson(request, jsondoc);
 }
 
-void apiGetStatus(AsyncWebServerRequest* request) {
-  JsonDocument jsondoc;
-  JsonObject json = jsondoc.to<JsonObject>();
-  json["temperature"] = s_shtc3.temperature();
-  json["humidity"] = s_shtc3.humidity();
+// Fill json with the state of the device and its sensors.
+void getStatus(JsonObject json) {
+  json["temperature"] = s_climate.temperature();
+  json["humidity"] = s_climate.humidity();
   json["waterLevel"] = s_reservoir.haveWater();
   json["pumpTimeRemaining"] = s_reservoir.secondsRemaining();
+  json["reservoirLiters"] = s_reservoir.liters();
+  json["reservoirDaysLeft"] = s_reservoir.daysLeft();
   json["mqttConnected"] = s_app.mqtt_manager().isConnected();
+  json["mqttBacklog"] = s_telemetry.backlogSize();
+  s_live_config.toJson(json["netConfig"].to<JsonObject>());
+  s_limiter.toJson(json["webRequests"].to<JsonObject>());
   json["software"] = SW_VERSION;
 #if BOARD_V13
   json["hardware"] = "1.3";
 #else
   json["hardware"] = "1.2";
 #endif
-  serializeJson(jsondoc, s_body);
+}
+
+void apiGetStatus(AsyncWebServerRequest* request) {
+  JsonDocument jsondoc;
+  getStatus(jsondoc.to<JsonObject>());
+  sendJson(request, jsondoc);
+}
+
+// Return min/mean/max summaries of recent moisture and climate readings for charts.
+// The "res" parameter selects the interval in seconds: 60, 900 or 3600.
+void apiGetRollups(AsyncWebServerRequest* request) {
+  const uint32_t res_sec =
+      request->hasParam("res") ? request->getParam("res")->value().toInt() : og3::kSecInMin;
+  const auto res = og3::Rollup::resolutionForSec(res_sec);
+  char buf[64];
+  snprintf(buf, sizeof(buf), "{\"interval\":%lu,\"plants\":[",
+           static_cast<unsigned long>(og3::Rollup::intervalSec(res)));
+  s_body = buf;
+  for (size_t i = 0; i < s_plants.size(); i++) {
+    snprintf(buf, sizeof(buf), "%s{\"id\":%u,\"moisture\":", i == 0 ? "" : ",",
+             static_cast<unsigned>(i + 1));
+    s_body += buf;
+    s_plants[i].moistureRollup().writeJson(res, &s_body);
+    s_body += "}";
+  }
+  s_body += "],\"temperature\":";
+  s_temperature_rollup.writeJson(res, &s_body);
+  s_body += ",\"humidity\":";
+  s_humidity_rollup.writeJson(res, &s_body);
+  s_body += "}";
   request->send(200, "application/json", s_body);
 }
 
-// Return current system status as JSON for AJAX status calls.
-void putApiPlant(int id, AsyncWebServerRequest* request, JsonVariant& jsonIn) {
-  if (id < 1 || id > static_cast<int>(s_plants.size())) {
-    request->send(500, "text/plain", "bad plant id");
+// Send {"errors": [{"id", "field", "message"}, ...]} for settings which were not applied.
+void sendErrors(AsyncWebServerRequest* request, const JsonDocument& jsondoc) {
+  s_body.clear();
+  serializeJson(jsondoc, s_body);
+  request->send(400, "application/json", s_body);
+}
+
+void addError(JsonArray errors, int id, const char* field, const char* message) {
+  JsonObject error = errors.add<JsonObject>();
+  error["id"] = id;
+  error["field"] = field;
+  error["message"] = message;
+}
+
+// Update the settings of a plant, for PUT /api/plants/<N>.
+//  s_router admits the request through s_limiter.
+void putApiPlant(unsigned plant, AsyncWebServerRequest* request, JsonVariant jsonIn) {
+  JsonDocument jsondoc;
+  JsonArray errors = jsondoc["errors"].to<JsonArray>();
+  if (plant >= s_plants.size() || !jsonIn.is<JsonObject>()) {
+    addError(errors, plant + 1, "", "not a json object for a plant");
+    sendErrors(request, jsondoc);
     return;
   }
-  if (!jsonIn.is<JsonObject>()) {
-    request->send(500, "text/plain", "not a json object");
+  if (!s_plants[plant].putApiPlants(jsonIn.as<JsonObjectConst>(), errors)) {
+    sendErrors(request, jsondoc);
     return;
   }
-  JsonObject obj = jsonIn.as<JsonObject>();
-  if (!s_plants[id - 1].putApiPlants(obj)) {
-    request->send(500, "text/plain", "failed to update plant");
+  request->send(200, "text/plain", "ok");
+}
+
+// Update settings of any number of plants, for PATCH /api/plants.  The body is an array of
+//  objects like those from GET /api/plants, each with "id" and any of the settings.
+// Every setting is checked before any is applied, and each updated plant is saved once.
+void patchApiPlants(AsyncWebServerRequest* request, JsonVariant jsonIn) {
+  JsonDocument jsondoc;
+  JsonArray errors = jsondoc["errors"].to<JsonArray>();
+  if (!jsonIn.is<JsonArray>()) {
+    addError(errors, 0, "", "not a json array");
+    sendErrors(request, jsondoc);
     return;
   }
-  request->send(200, "text/plain", "ok");
+  std::array<JsonObjectConst, std::tuple_size<decltype(s_plants)>::value> updates;
+  for (JsonVariantConst item : jsonIn.as<JsonArrayConst>()) {
+    const int id = item["id"] | 0;
+    if (!item.is<JsonObjectConst>() || id < 1 || id > static_cast<int>(s_plants.size())) {
+      addError(errors, id, "id", "bad plant id");
+      continue;
+    }
+    if (!updates[id - 1].isNull()) {
+      addError(errors, id, "id", "plant listed twice");
+      continue;
+    }
+    updates[id - 1] = item.as<JsonObjectConst>();
+    s_plants[id - 1].checkApiPlants(updates[id - 1], errors);
+  }
+  if (errors.size() > 0) {
+    sendErrors(request, jsondoc);
+    return;
+  }
+  // Apply every update before the slower flash writes.
+  unsigned updated = 0;
+  for (size_t i = 0; i < s_plants.size(); i++) {
+    if (!updates[i].isNull()) {
+      s_plants[i].applyApiPlants(updates[i]);
+      updated += 1;
+    }
+  }
+  for (size_t i = 0; i < s_plants.size(); i++) {
+    if (!updates[i].isNull()) {
+      s_plants[i].saveConfig();
+    }
+  }
+  jsondoc.clear();
+  jsondoc["updated"] = updated;
+  sendJson(request, jsondoc);
 }
 
 // Handle ajax POSTS with pump-test commands like: "{pumpId: 1, duration: 1000}"
@@ -357,17 +528,18 @@ void configJson(AsyncWebServerRequest* request) {
   request->send(200, "application/json", s_body);
 }
 
-void apiGetWifi(AsyncWebServerRequest* request) {
-  JsonDocument jsondoc;
-  JsonObject json = jsondoc.to<JsonObject>();
-
+// Fill json with the WiFi configuration.
+void getWifi(JsonObject json) {
   const auto& wifi = s_app.wifi_manager();
-
   json["board"] = wifi.board();
   json["password"] = wifi.password();
   json["essid"] = wifi.essid();
-  serializeJson(jsondoc, s_body);
-  request->send(200, "application/json", s_body);
+}
+
+void apiGetWifi(AsyncWebServerRequest* request) {
+  JsonDocument jsondoc;
+  getWifi(jsondoc.to<JsonObject>());
+  sendJson(request, jsondoc);
 }
 
 // Return current system status as JSON for AJAX status calls.
@@ -376,25 +548,94 @@ void putWifiConfig(AsyncWebServerRequest* request, JsonVariant& jsonIn) {
     request->send(500, "text/plain", "not a json object");
     return;
   }
-  JsonObject obj = jsonIn.as<JsonObject>();
-  if (s_app.wifi_manager().variables().updateFromJson(obj) == 0) {
-    request->send(500, "text/plain", "no values updated");
-  }
-  s_app.config().write_config(s_app.wifi_manager().variables());
-  request->send(200, "text/plain", "ok");
+  const auto reply = s_live_config.applyWifi(jsonIn.as<JsonObject>());
+  request->send(reply.http_status, "text/plain", reply.message);
 }
 
-void apiGetMqtt(AsyncWebServerRequest* request) {
-  JsonDocument jsondoc;
-  JsonObject json = jsondoc.to<JsonObject>();
-
+// Fill json with the MQTT configuration.
+void getMqtt(JsonObject json) {
   const auto& mqtt = s_app.mqtt_manager();
-
   json["host"] = mqtt.host();
+  json["port"] = s_live_config.mqttPort();
   json["password"] = mqtt.auth_password();
   json["user"] = mqtt.auth_user();
-  serializeJson(jsondoc, s_body);
-  request->send(200, "application/json", s_body);
+  s_telemetry.configVariables().toJson(json, og3::VariableBase::Flags::kConfig);
+}
+
+void apiGetMqtt(AsyncWebServerRequest* request) {
+  JsonDocument jsondoc;
+  getMqtt(jsondoc.to<JsonObject>());
+  sendJson(request, jsondoc);
+}
+
+// Tracks changes to dashboard values so polling clients can be sent only what changed.
+// Versions start from a random value so that versions from before a reboot are not valid.
+og3::ChangeTracker s_dashboard_changes(esp_random() & 0x7fffffff);
+// Values which change with nearly every reading or request are sent at most this often in
+//  dashboard deltas, so that a delta is empty when nothing else has changed.
+constexpr unsigned long kDashboardVolatileMsec = 60 * 1000;
+
+// Return everything the web dashboard needs in one response.
+// - fields=plants,status,wifi,mqtt selects which sections to return (default all).
+// - since=<version> returns only values which changed after a version from an earlier
+//   response.  Plants with no changes are left out, and changed plants include their id.
+void apiGetDashboard(AsyncWebServerRequest* request) {
+  const String fields = request->hasParam("fields") ? request->getParam("fields")->value() : "";
+  auto wants = [&fields](const char* section) -> bool {
+    if (fields.length() == 0) {
+      return true;
+    }
+    // Match a whole entry of the comma-separated list.
+    const int len = strlen(section);
+    for (int pos = fields.indexOf(section); pos >= 0; pos = fields.indexOf(section, pos + 1)) {
+      const bool starts = pos == 0 || fields[pos - 1] == ',';
+      const bool ends = pos + len == static_cast<int>(fields.length()) || fields[pos + len] == ',';
+      if (starts && ends) {
+        return true;
+      }
+    }
+    return false;
+  };
+  const uint32_t since =
+      request->hasParam("since") ? strtoul(request->getParam("since")->value().c_str(), nullptr, 10)
+                                 : 0;
+
+  JsonDocument full;
+  JsonDocument jsondoc;
+  JsonObject json = jsondoc.to<JsonObject>();
+  s_dashboard_changes.beginResponse(millis());
+  auto addSection = [&](const char* section, const std::function<void(JsonObject)>& fill) {
+    if (!wants(section)) {
+      return;
+    }
+    JsonObject in = full[section].to<JsonObject>();
+    fill(in);
+    JsonDocument out;
+    if (s_dashboard_changes.diff(section, in, out.to<JsonObject>(), since) > 0) {
+      json[section] = out;
+    }
+  };
+  addSection("status", getStatus);
+  addSection("wifi", getWifi);
+  addSection("mqtt", getMqtt);
+  if (wants("plants")) {
+    JsonArray in = full["plants"].to<JsonArray>();
+    getPlants(in);
+    JsonArray out = json["plants"].to<JsonArray>();
+    for (JsonObject plant : in) {
+      char path[16];
+      snprintf(path, sizeof(path), "plants.%d", plant["id"].as<int>());
+      JsonDocument changed;
+      if (s_dashboard_changes.diff(path, plant, changed.to<JsonObject>(), since, "id") > 0) {
+        out.add(changed);
+      }
+    }
+    if (out.size() == 0) {
+      json.remove("plants");
+    }
+  }
+  json["version"] = s_dashboard_changes.version();
+  sendJson(request, jsondoc);
 }
 
 // Return current system status as JSON for AJAX status calls.
@@ -404,11 +645,15 @@ void putMqttConfig(AsyncWebServerRequest* request, JsonVariant& jsonIn) {
     return;
   }
   JsonObject obj = jsonIn.as<JsonObject>();
-  if (s_app.mqtt_manager().variables().updateFromJson(obj) == 0) {
-    request->send(500, "text/plain", "no values updated");
+  const auto reply = s_live_config.applyMqtt(obj);
+  // Telemetry settings are applied unless the MQTT settings were rejected.
+  const int telemetry_updated = reply.updated < 0 ? 0 : s_telemetry.updateConfig(obj);
+  if (reply.updated == 0 && telemetry_updated > 0) {
+    // Only the telemetry settings changed.
+    request->send(200, "text/plain", "ok");
+    return;
   }
-  s_app.config().write_config(s_app.mqtt_manager().variables());
-  request->send(200, "text/plain", "ok");
+  request->send(reply.http_status, "text/plain", reply.message);
 }
 
 }  // namespace
@@ -418,51 +663,83 @@ void setup() {
   // Register the graphical watering state display as one of the views the OLED display
   //  will rotate through.
   s_oled.addDisplayFn(draw_graphs);
+  // Record each climate reading in the flash history and the chart rollups.
+  s_climate.addListener([](const og3::ClimateSampler& climate) {
+    s_history.addClimate(climate.temperature(), climate.humidity());
+    s_temperature_rollup.add(og3::Rollup::nowSecs(), climate.temperature());
+    s_humidity_rollup.add(og3::Rollup::nowSecs(), climate.humidity());
+    s_trace.addClimate(climate.temperature(), climate.humidity());
+  });
+  for (auto& plant : s_plants) {
+    plant.setClimate(&s_climate.readings());
+  }
+  for (const char* key : {"rawMoisture", "sensorNoise", "webRequests"}) {
+    s_dashboard_changes.setVolatile(key, kDashboardVolatileMsec);
+  }
   // Setup URL handlers in the web server.
   // Serve static files from the /config subdirectory in flash.
   s_app.web_server().serveStatic("/config/", LittleFS, "/");
   // Serve the root URL via the handleWebRoot() callback function.
   s_app.web_server().on("/test/status", statusJson);
   s_app.web_server().on("/test/config", configJson);
-  s_app.web_server().on("/root", handleWebRoot);
+  s_app.web_server().on("/root", limited(og3::RateLimiter::kRootPage, handleWebRoot));
   initSvelteStaticFiles(&s_app.web_server());
-  s_app.web_server().on("/api/plants", HTTP_GET, apiGetPlants);
-  s_app.web_server().on("/api/wifi", HTTP_GET, apiGetWifi);
-  s_app.web_server().on("/api/mqtt", HTTP_GET, apiGetMqtt);
-  s_app.web_server().on("/api/moisture", HTTP_GET, apiGetMoisture);
-  s_app.web_server().on("/api/status", HTTP_GET, apiGetStatus);
+  og3::StaticCache::install(&s_app.web_server());
+  constexpr auto kApiRead = og3::RateLimiter::kApiRead;
+  s_app.web_server().on("/api/plants", HTTP_GET, limited(kApiRead, apiGetPlants));
+  s_app.web_server().on("/api/wifi", HTTP_GET, limited(kApiRead, apiGetWifi));
+  s_app.web_server().on("/api/mqtt", HTTP_GET, limited(kApiRead, apiGetMqtt));
+  s_app.web_server().on("/api/moisture", HTTP_GET, limited(kApiRead, apiGetMoisture));
+  s_app.web_server().on("/api/status", HTTP_GET, limited(kApiRead, apiGetStatus));
+  s_app.web_server().on("/api/rollups", HTTP_GET, limited(kApiRead, apiGetRollups));
+  s_app.web_server().on("/api/dashboard", HTTP_GET, limited(kApiRead, apiGetDashboard));
 
   {  // Add pump test json callback.
     AsyncCallbackJsonWebHandler* pumpTestHandler = new AsyncCallbackJsonWebHandler("/test/pump");
     pumpTestHandler->setMethod(HTTP_POST);
-    pumpTestHandler->onRequest(
-        [](AsyncWebServerRequest* request, JsonVariant json) { pumpTest(request, json); });
+    pumpTestHandler->onRequest([](AsyncWebServerRequest* request, JsonVariant json) {
+      if (s_limiter.admit(og3::RateLimiter::kPumpTest, request)) {
+        pumpTest(request, json);
+      }
+    });
     s_app.web_server().addHandler(pumpTestHandler);
   }
 
-  for (int id = 1; id <= static_cast<int>(s_plants.size()); id++) {
-    char path[80];
-    snprintf(path, sizeof(path), "/api/plants/%d", id);
-    AsyncCallbackJsonWebHandler* api_handler = new AsyncCallbackJsonWebHandler(path);
-    api_handler->setMethod(HTTP_PUT);
-    api_handler->onRequest([id](AsyncWebServerRequest* request, JsonVariant& json) {
-      putApiPlant(id, request, json);
+  s_router.setApi(putApiPlant);
+  // Limit the requests which modules handle themselves.
+  s_router.setLimiter(&s_limiter);
+  s_reservoir.setLimiter(&s_limiter);
+  s_history.setLimiter(&s_limiter);
+  s_trace.setLimiter(&s_limiter);
+  {  // Add the batch plant settings callback.
+    AsyncCallbackJsonWebHandler* handler = new AsyncCallbackJsonWebHandler("/api/plants");
+    handler->setMethod(HTTP_PATCH);
+    handler->onRequest([](AsyncWebServerRequest* request, JsonVariant json) {
+      if (s_limiter.admit(og3::RateLimiter::kPlantSettings, request)) {
+        patchApiPlants(request, json);
+      }
     });
-    s_app.web_server().addHandler(api_handler);
+    s_app.web_server().addHandler(handler);
   }
 
   {  // Add WiFi callback
     AsyncCallbackJsonWebHandler* handler = new AsyncCallbackJsonWebHandler("/api/wifi");
     handler->setMethod(HTTP_PUT);
-    handler->onRequest(
-        [](AsyncWebServerRequest* request, JsonVariant json) { putWifiConfig(request, json); });
+    handler->onRequest([](AsyncWebServerRequest* request, JsonVariant json) {
+      if (s_limiter.admit(og3::RateLimiter::kWifiSettings, request)) {
+        putWifiConfig(request, json);
+      }
+    });
     s_app.web_server().addHandler(handler);
   }
   {  // Add Mqtt callback
     AsyncCallbackJsonWebHandler* handler = new AsyncCallbackJsonWebHandler("/api/mqtt");
     handler->setMethod(HTTP_PUT);
-    handler->onRequest(
-        [](AsyncWebServerRequest* request, JsonVariant json) { putMqttConfig(request, json); });
+    handler->onRequest([](AsyncWebServerRequest* request, JsonVariant json) {
+      if (s_limiter.admit(og3::RateLimiter::kMqttSettings, request)) {
+        putMqttConfig(request, json);
+      }
+    });
     s_app.web_server().addHandler(handler);
   }
 
@@ -474,6 +751,16 @@ void setup() {
   // Run the og3 application setup code.
   s_app.setup();
 
+  {  // Record the configuration loaded from flash at the start of the trace.
+    JsonDocument jsondoc;
+    getPlants(jsondoc["plants"].to<JsonArray>());
+    s_reservoir.configVariables().toJson(jsondoc["reservoir"].to<JsonObject>(),
+                                         og3::VariableBase::Flags::kConfig);
+    s_body.clear();
+    serializeJson(jsondoc, s_body);
+    s_trace.addConfig(s_body.c_str(), s_body.length());
+  }
+
   // Initialize Watchdog Timer with 5 second timeout
   esp_task_wdt_init(5, true);
   esp_task_wdt_add(NULL);  // Add current thread (loopTask) to WDT
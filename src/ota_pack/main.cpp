@@ -0,0 +1,84 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+// Compresses a firmware image for POST /api/ota (see lib/watering/ota_image.h), and checks
+//  that it decompresses to the same firmware.
+//
+//   pio run -e node32s && pio run -e ota_pack
+//   .pio/build/ota_pack/program .pio/build/node32s/firmware.bin firmware.p13z
+//   curl -u admin:<ota password> --data-binary @firmware.p13z http://plant133.local/api/ota
+
+#include <ota_image.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+bool readFile(const char* path, std::vector<uint8_t>* data) {
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    return false;
+  }
+  uint8_t buf[4096];
+  size_t len;
+  while ((len = fread(buf, 1, sizeof(buf), file)) > 0) {
+    data->insert(data->end(), buf, buf + len);
+  }
+  const bool ok = !ferror(file);
+  fclose(file);
+  return ok;
+}
+
+bool writeFile(const char* path, const std::vector<uint8_t>& data) {
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+  const bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+  return fclose(file) == 0 && ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s firmware.bin firmware.p13z\n", argv[0]);
+    return 2;
+  }
+  std::vector<uint8_t> firmware;
+  if (!readFile(argv[1], &firmware) || firmware.empty()) {
+    fprintf(stderr, "Failed to read %s.\n", argv[1]);
+    return 1;
+  }
+  std::vector<uint8_t> image;
+  og3::ota_image::compress(firmware.data(), firmware.size(), &image);
+
+  // Decompress in TCP-sized chunks as the device does.
+  size_t same = 0;
+  og3::OtaDecoder decoder([&firmware, &same](const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++, same++) {
+      if (same >= firmware.size() || data[i] != firmware[same]) {
+        return false;
+      }
+    }
+    return true;
+  });
+  constexpr size_t kChunk = 1436;
+  for (size_t pos = 0; pos < image.size(); pos += kChunk) {
+    decoder.write(image.data() + pos, std::min(kChunk, image.size() - pos));
+  }
+  const og3::OtaDecoder::Status status = decoder.finish();
+  if (status != og3::OtaDecoder::Status::kOk) {
+    fprintf(stderr, "Image does not decompress: %s.\n", og3::OtaDecoder::statusName(status));
+    return 1;
+  }
+  if (!writeFile(argv[2], image)) {
+    fprintf(stderr, "Failed to write %s.\n", argv[2]);
+    return 1;
+  }
+  printf("%s: %zu bytes -> %s: %zu bytes (%.0f%%)\n", argv[1], firmware.size(), argv[2],
+         image.size(), 100.0 * image.size() / firmware.size());
+  return 0;
+}
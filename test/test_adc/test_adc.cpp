@@ -0,0 +1,54 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <adc_linearization.h>
+#include <unity.h>
+
+namespace {
+
+using og3::adc::Fit11db;
+using og3::adc::kNumCounts;
+using og3::adc::millivolts;
+
+// The table is built at compile time.
+static_assert(og3::adc::MillivoltTable<Fit11db>::kMillivolts[0] == 34, "table at 0 counts");
+static_assert(og3::adc::MillivoltTable<Fit11db>::kMillivolts[kNumCounts - 1] == 3140,
+              "table at full scale");
+
+void test_monotonic() {
+  for (unsigned counts = 1; counts < kNumCounts; counts++) {
+    TEST_ASSERT_TRUE(millivolts<Fit11db>(counts) >= millivolts<Fit11db>(counts - 1));
+  }
+}
+
+void test_nonlinear() {
+  // The ADC reads low at the bottom of its range, so a linear fit through the ends is off by
+  //  tens of millivolts in the middle.
+  const float linear = 34.0f + (3140.0f - 34.0f) * 1000.0f / (kNumCounts - 1);
+  TEST_ASSERT_TRUE(millivolts<Fit11db>(1000) - linear > 50.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 1000.0f * Fit11db::volts(2000), millivolts<Fit11db>(2000));
+}
+
+void test_masked() {
+  TEST_ASSERT_EQUAL_UINT(millivolts<Fit11db>(5), millivolts<Fit11db>(kNumCounts + 5));
+}
+
+}  // namespace
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_monotonic);
+  RUN_TEST(test_nonlinear);
+  RUN_TEST(test_masked);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
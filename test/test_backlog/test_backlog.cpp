@@ -0,0 +1,103 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <mqtt_backlog.h>
+#include <unity.h>
+
+#include <cstdio>
+#include <string>
+
+namespace {
+
+constexpr char kFile[] = "test_backlog.bin";
+
+// Messages are 16 bytes: a 5-byte topic and an 11-byte payload.
+std::string payload(int i) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "message %03d", i);
+  return buf;
+}
+
+void push(og3::MqttBacklog* backlog, int i) {
+  const std::string msg = payload(i);
+  backlog->push("topic", msg.data(), msg.size());
+}
+
+// Pop messages first to last, in order.
+void expectMessages(og3::MqttBacklog* backlog, int first, int last) {
+  for (int i = first; i <= last; i++) {
+    const og3::MqttBacklog::Message* msg = backlog->front();
+    TEST_ASSERT_NOT_NULL(msg);
+    TEST_ASSERT_EQUAL_STRING("topic", msg->topic.c_str());
+    TEST_ASSERT_EQUAL_STRING(payload(i).c_str(), msg->payload.c_str());
+    backlog->pop();
+  }
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() { remove(kFile); }
+
+void test_ram_only() {
+  og3::MqttBacklog backlog(160);
+  for (int i = 0; i < 15; i++) {
+    push(&backlog, i);
+  }
+  TEST_ASSERT_EQUAL_UINT(10, backlog.size());
+  TEST_ASSERT_EQUAL_UINT(5, backlog.dropped());
+  expectMessages(&backlog, 5, 14);
+  TEST_ASSERT_TRUE(backlog.empty());
+  TEST_ASSERT_NULL(backlog.front());
+}
+
+void test_overflow_file() {
+  // 10 messages fit in RAM and 5 (of 19 bytes with the header) in the file.
+  og3::MqttBacklog backlog(160, kFile, 95);
+  for (int i = 0; i < 20; i++) {
+    push(&backlog, i);
+  }
+  TEST_ASSERT_EQUAL_UINT(15, backlog.size());
+  TEST_ASSERT_EQUAL_UINT(5, backlog.dropped());
+  // The oldest from the file, then the newest from RAM.
+  expectMessages(&backlog, 0, 4);
+  expectMessages(&backlog, 10, 19);
+  TEST_ASSERT_TRUE(backlog.empty());
+}
+
+void test_overflow_file_order() {
+  og3::MqttBacklog backlog(160, kFile, 1000);
+  for (int i = 0; i < 30; i++) {
+    push(&backlog, i);
+  }
+  TEST_ASSERT_EQUAL_UINT(30, backlog.size());
+  TEST_ASSERT_EQUAL_UINT(0, backlog.dropped());
+  // Send some, then lose the connection again.
+  for (int i = 0; i < 8; i++) {
+    backlog.pop();
+  }
+  for (int i = 30; i < 40; i++) {
+    push(&backlog, i);
+  }
+  expectMessages(&backlog, 8, 39);
+  TEST_ASSERT_TRUE(backlog.empty());
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_ram_only);
+  RUN_TEST(test_overflow_file);
+  RUN_TEST(test_overflow_file_order);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
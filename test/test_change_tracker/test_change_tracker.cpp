@@ -0,0 +1,96 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <ArduinoJson.h>
+#include <change_tracker.h>
+#include <unity.h>
+
+namespace {
+
+// Diff the object in json against since, returning the delta.
+JsonDocument diff(og3::ChangeTracker* tracker, const char* json, uint32_t since,
+                  unsigned long now_msec = 0) {
+  JsonDocument in;
+  deserializeJson(in, json);
+  JsonDocument out;
+  tracker->beginResponse(now_msec);
+  tracker->diff("plants.1", in.as<JsonObjectConst>(), out.to<JsonObject>(), since, "id");
+  return out;
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_changed_values() {
+  og3::ChangeTracker tracker(100);
+  JsonDocument out = diff(&tracker, R"({"id":1,"a":1,"b":2})", 0);
+  TEST_ASSERT_EQUAL_UINT(3, out.size());
+  const uint32_t version = tracker.version();
+
+  out = diff(&tracker, R"({"id":1,"a":1,"b":2})", version);
+  TEST_ASSERT_EQUAL_UINT(0, out.size());
+  TEST_ASSERT_EQUAL_UINT(version, tracker.version());
+
+  out = diff(&tracker, R"({"id":1,"a":1,"b":3})", version);
+  TEST_ASSERT_EQUAL_UINT(2, out.size());
+  TEST_ASSERT_EQUAL(3, out["b"].as<int>());
+  TEST_ASSERT_EQUAL(1, out["id"].as<int>());
+}
+
+void test_removed_key() {
+  og3::ChangeTracker tracker(100);
+  diff(&tracker, R"({"id":1,"a":1,"nextWateringSec":600})", 0);
+  const uint32_t version = tracker.version();
+
+  // The key is sent as null once it is left out.
+  JsonDocument out = diff(&tracker, R"({"id":1,"a":1})", version);
+  TEST_ASSERT_EQUAL_UINT(2, out.size());
+  TEST_ASSERT_TRUE(out["nextWateringSec"].isNull());
+  const uint32_t removed_version = tracker.version();
+  TEST_ASSERT_TRUE(removed_version > version);
+
+  // It is not sent again, nor in a full response.
+  out = diff(&tracker, R"({"id":1,"a":1})", removed_version);
+  TEST_ASSERT_EQUAL_UINT(0, out.size());
+  out = diff(&tracker, R"({"id":1,"a":1})", 0);
+  TEST_ASSERT_EQUAL_UINT(2, out.size());
+
+  // A key which comes back is a change, even with the same value.
+  out = diff(&tracker, R"({"id":1,"a":1,"nextWateringSec":600})", removed_version);
+  TEST_ASSERT_EQUAL_UINT(2, out.size());
+  TEST_ASSERT_EQUAL(600, out["nextWateringSec"].as<int>());
+}
+
+void test_volatile_key() {
+  og3::ChangeTracker tracker(100);
+  tracker.setVolatile("raw", 60000);
+  diff(&tracker, R"({"id":1,"raw":10})", 0, 0);
+  const uint32_t version = tracker.version();
+
+  JsonDocument out = diff(&tracker, R"({"id":1,"raw":11})", version, 1000);
+  TEST_ASSERT_EQUAL_UINT(0, out.size());
+  out = diff(&tracker, R"({"id":1,"raw":12})", version, 61000);
+  TEST_ASSERT_EQUAL_UINT(2, out.size());
+  TEST_ASSERT_EQUAL(12, out["raw"].as<int>());
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_changed_values);
+  RUN_TEST(test_removed_key);
+  RUN_TEST(test_volatile_key);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
@@ -0,0 +1,87 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <config_trial.h>
+#include <unity.h>
+
+using og3::ConfigTrial;
+using Status = og3::ConfigTrial::Status;
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_applied() {
+  ConfigTrial trial(30000);
+  TEST_ASSERT_TRUE(trial.status() == Status::kIdle);
+  trial.begin(1000, 5);
+  TEST_ASSERT_TRUE(trial.applying());
+  // The connection from before the new settings doesn't count.
+  TEST_ASSERT_TRUE(trial.update(1200, 5) == Status::kApplying);
+  TEST_ASSERT_TRUE(trial.update(9000, 5) == Status::kApplying);
+  TEST_ASSERT_TRUE(trial.update(9500, 6) == Status::kApplied);
+  // The result doesn't change after the trial.
+  TEST_ASSERT_TRUE(trial.update(60000, 6) == Status::kApplied);
+  TEST_ASSERT_EQUAL_STRING("applied", ConfigTrial::statusName(trial.status()));
+}
+
+void test_fast_reconnect() {
+  // A reconnect which was over before the first check still counts.
+  ConfigTrial trial(20000);
+  trial.begin(1000, 1);
+  TEST_ASSERT_TRUE(trial.update(1100, 2) == Status::kApplied);
+
+  // As does one which makes the count wrap around.
+  trial.begin(5000, 0xffffffffU);
+  TEST_ASSERT_TRUE(trial.update(5100, 0) == Status::kApplied);
+}
+
+void test_rolled_back() {
+  ConfigTrial trial(30000);
+  trial.begin(1000, 0);
+  TEST_ASSERT_TRUE(trial.update(2000, 0) == Status::kApplying);
+  TEST_ASSERT_TRUE(trial.update(30999, 0) == Status::kApplying);
+  TEST_ASSERT_TRUE(trial.update(31000, 0) == Status::kRolledBack);
+  TEST_ASSERT_TRUE(trial.update(32000, 1) == Status::kRolledBack);
+  TEST_ASSERT_EQUAL_STRING("rolled back", ConfigTrial::statusName(trial.status()));
+
+  // A connection which was never made again is also rolled back.
+  trial.begin(40000, 1);
+  TEST_ASSERT_TRUE(trial.update(50000, 1) == Status::kApplying);
+  TEST_ASSERT_TRUE(trial.update(70000, 1) == Status::kRolledBack);
+}
+
+void test_millis_wrap() {
+  ConfigTrial trial(20000);
+  trial.begin(0xffffff00UL, 3);
+  TEST_ASSERT_TRUE(trial.update(0x100, 3) == Status::kApplying);
+  TEST_ASSERT_TRUE(trial.update(0x200, 4) == Status::kApplied);
+}
+
+void test_applied_without_trial() {
+  ConfigTrial trial(20000);
+  trial.begin(1000, 0);
+  trial.applied();
+  TEST_ASSERT_FALSE(trial.applying());
+  TEST_ASSERT_TRUE(trial.update(50000, 0) == Status::kApplied);
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_applied);
+  RUN_TEST(test_fast_reconnect);
+  RUN_TEST(test_rolled_back);
+  RUN_TEST(test_millis_wrap);
+  RUN_TEST(test_applied_without_trial);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
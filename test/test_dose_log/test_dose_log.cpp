@@ -0,0 +1,205 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <ArduinoFake.h>
+#include <dose_log.h>
+#include <og3/logger.h>
+#include <og3/module_system.h>
+#include <unity.h>
+#include <watering_constants.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+class TestLogger : public og3::Logger {
+ public:
+  void log(const char* msg) final { printf("%s\n", msg); }
+};
+
+constexpr uint64_t kMsecInHour = 60 * 60 * 1000;
+
+// The virtual clock, as milliseconds since boot.  millis() returns it modulo 2^32, so it
+//  wraps as on the device.  The uptime clock extends millis() across wraps, so this only
+//  moves forward, across all tests.
+uint64_t s_now_msec = 0;
+
+void fakeClock() {
+  using namespace fakeit;
+  When(Method(ArduinoFake(), millis)).AlwaysDo([]() -> unsigned long {
+    return static_cast<uint32_t>(s_now_msec);
+  });
+}
+
+// A dose at a time, to check the window of the DoseLog by brute force.
+struct Dose {
+  uint64_t msec;
+  float pump_secs;
+};
+
+// The number of doses and pump seconds in the hour buckets of the last day.
+void expected(const std::vector<Dose>& doses, unsigned* count, float* pump_secs) {
+  const uint64_t hour = s_now_msec / kMsecInHour;
+  *count = 0;
+  *pump_secs = 0.0f;
+  for (const Dose& dose : doses) {
+    if (dose.msec / kMsecInHour + og3::DoseLog::kNumBuckets > hour) {
+      *count += 1;
+      *pump_secs += dose.pump_secs;
+    }
+  }
+}
+
+// The number of doses in the last secs seconds.
+unsigned dosesInLast(const std::vector<Dose>& doses, uint64_t secs) {
+  unsigned count = 0;
+  for (const Dose& dose : doses) {
+    if (dose.msec + secs * 1000 > s_now_msec) {
+      count += 1;
+    }
+  }
+  return count;
+}
+
+// Check that the doses by hour add up to count.
+void checkHistogram(const og3::DoseLog& dose_log, unsigned count) {
+  JsonDocument doc;
+  JsonArray hours = doc.to<JsonArray>();
+  dose_log.dosesByHour(hours);
+  TEST_ASSERT_EQUAL_UINT(og3::DoseLog::kNumBuckets, hours.size());
+  unsigned sum = 0;
+  for (JsonVariant doses : hours) {
+    sum += doses.as<unsigned>();
+  }
+  TEST_ASSERT_EQUAL_UINT(count, sum);
+}
+
+}  // namespace
+
+void setUp() { fakeClock(); }
+
+void tearDown() {}
+
+void test_window() {
+  TestLogger log;
+  og3::ModuleSystem module_system(&log);
+  og3::VariableGroup vg("plant1");
+  og3::VariableGroup cfg_vg("plant1_cfg");
+  og3::DoseLog dose_log(vg, cfg_vg, &module_system, nullptr);
+
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<uint64_t> step_msec(1, 90 * 60 * 1000);
+  std::uniform_int_distribution<unsigned> doses_per_cycle(0, 4);
+  std::uniform_real_distribution<float> dose_msec(500.0f, 5000.0f);
+  std::vector<Dose> doses;
+
+  // About 150 days of watering cycles, so millis() wraps around three times.
+  for (unsigned cycle = 0; cycle < 5000; cycle++) {
+    s_now_msec += step_msec(rng);
+    const unsigned num_doses = doses_per_cycle(rng);
+    dose_log.update(num_doses > 0);
+    for (unsigned i = 0; i < num_doses; i++) {
+      const float msec = dose_msec(rng);
+      dose_log.addDose();
+      dose_log.addPumpMsec(msec);
+      doses.push_back({s_now_msec, 1e-3f * msec});
+    }
+    dose_log.update(false);
+
+    unsigned count;
+    float pump_secs;
+    expected(doses, &count, &pump_secs);
+    TEST_ASSERT_EQUAL_UINT(count, dose_log.doseCount());
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, pump_secs, dose_log.pumpSecs());
+    checkHistogram(dose_log, count);
+    // The window is the current hour and the 23 before it, so it covers 23 to 24 hours.
+    TEST_ASSERT_TRUE(dose_log.doseCount() >= dosesInLast(doses, 23 * 3600));
+    TEST_ASSERT_TRUE(dose_log.doseCount() <= dosesInLast(doses, 24 * 3600));
+  }
+  TEST_ASSERT_TRUE(s_now_msec > 3 * (uint64_t(1) << 32));
+}
+
+void test_millis_wrap() {
+  TestLogger log;
+  og3::ModuleSystem module_system(&log);
+  og3::VariableGroup vg("plant1");
+  og3::VariableGroup cfg_vg("plant1_cfg");
+  og3::DoseLog dose_log(vg, cfg_vg, &module_system, nullptr);
+
+  // Run up to two hours before millis() wraps, updating as the watering loop would.
+  const uint64_t wrap_msec = (s_now_msec | 0xffffffffull) + 1;
+  while (s_now_msec + 2 * kMsecInHour < wrap_msec) {
+    s_now_msec = std::min(s_now_msec + kMsecInHour, wrap_msec - 2 * kMsecInHour);
+    dose_log.update(false);
+  }
+  dose_log.update(true);
+  for (unsigned i = 0; i < 3; i++) {
+    dose_log.addDose();
+    dose_log.addPumpMsec(2000.0f);
+  }
+  dose_log.update(false);
+  TEST_ASSERT_EQUAL_UINT(3, dose_log.doseCount());
+
+  // Doses from before the wrap are still counted after it.
+  s_now_msec = wrap_msec + kMsecInHour;
+  dose_log.update(false);
+  TEST_ASSERT_TRUE(static_cast<uint32_t>(s_now_msec) < 2 * kMsecInHour);
+  TEST_ASSERT_EQUAL_UINT(3, dose_log.doseCount());
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 6.0f, dose_log.pumpSecs());
+
+  // And expire a day after they were added.
+  s_now_msec += 20 * kMsecInHour;
+  dose_log.update(false);
+  TEST_ASSERT_EQUAL_UINT(3, dose_log.doseCount());
+  s_now_msec += 2 * kMsecInHour;
+  dose_log.update(false);
+  TEST_ASSERT_EQUAL_UINT(0, dose_log.doseCount());
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, dose_log.pumpSecs());
+  checkHistogram(dose_log, 0);
+}
+
+void test_pause() {
+  TestLogger log;
+  og3::ModuleSystem module_system(&log);
+  og3::VariableGroup vg("plant1");
+  og3::VariableGroup cfg_vg("plant1_cfg");
+  og3::DoseLog dose_log(vg, cfg_vg, &module_system, nullptr);
+  dose_log.setMaxDoesPerCycle(3);
+
+  s_now_msec += kMsecInHour;
+  dose_log.update(true);
+  dose_log.addDose();
+  dose_log.addDose();
+  TEST_ASSERT_FALSE(dose_log.shouldPauseWatering());
+  dose_log.addDose();
+  TEST_ASSERT_TRUE(dose_log.shouldPauseWatering());
+  // A new cycle starts its count again, but the doses of the day still pause watering.
+  dose_log.update(false);
+  s_now_msec += kMsecInHour;
+  dose_log.update(true);
+  TEST_ASSERT_TRUE(dose_log.shouldPauseWatering());
+  s_now_msec += og3::kWateringPauseSec * 1000ull;
+  dose_log.update(true);
+  TEST_ASSERT_FALSE(dose_log.shouldPauseWatering());
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_window);
+  RUN_TEST(test_millis_wrap);
+  RUN_TEST(test_pause);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
@@ -0,0 +1,604 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+// Randomized fault injection for the watering safety logic.
+//
+// Each scenario runs the real watering code on a simulated Plant133 with random settings,
+//  soil which dries and is wetted by the pumps, and a reservoir which empties and is refilled.
+//  Each scenario also injects random faults: a stuck moisture ADC, a disconnected probe, a
+//  probe pulled out of the soil, a chattering reservoir float, millis() wrapping around, and
+//  reboots (some in the middle of a dose).  These invariants are checked within each boot:
+//   - A pump is never on for much longer than its dose.
+//   - A plant gets at most max_doses_per_cycle doses in any 23 hours (the dose log expires
+//     doses in hourly buckets, so 23 hours is the window it guarantees), and so at most
+//     that many doses of pump time.
+//   - Doses of a plant start at least between_doses_sec apart.
+//   - With the reservoir check enabled, a dose does not start after the pumps have run for
+//     kLowWaterSecsRemaining since the float last saw water.
+//   - No dose starts after the probe is disconnected.
+// The dose log and reservoir budget are kept in RAM, so they restart with each boot.
+//
+// Scenarios run in parallel in worker processes, one per core, because ArduinoFake is global.
+//  For each violation, the seed and the events leading up to it are printed, and a trace of
+//  the boot is written as fault_<seed>.bin, which test_replay can replay.
+//
+//   pio test -e native -f test_faults
+//   PLANT133_FAULT_SCENARIOS=20000 PLANT133_FAULT_JOBS=16 pio test -e native -f test_faults
+//   PLANT133_FAULT_SEED=1234 PLANT133_FAULT_SCENARIOS=1 pio test -e native -f test_faults
+
+#include <sim_device.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unity.h>
+#include <watering_constants.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using og3::Watering;
+
+constexpr uint64_t kMsecInHour = 3600 * 1000;
+// Each scenario simulates this long, which is enough to see the daily dose limit expire.
+constexpr uint64_t kScenarioMsec = 30 * kMsecInHour;
+// The application loop runs every kMinStepMsec to kMaxStepMsec.
+constexpr uint32_t kMinStepMsec = 200;
+constexpr uint32_t kMaxStepMsec = 5000;
+// Doses counted against the daily limit, as explained above.
+constexpr uint64_t kDoseWindowMsec = og3::kWateringPauseSec * 1000ull - kMsecInHour;
+// Soil and reservoir model.
+constexpr float kReservoirLowMl = 500.0f;
+constexpr float kAdcNoise = 8.0f;
+
+enum Fault {
+  kFaultStuckAdc,
+  kFaultDisconnectedProbe,
+  kFaultProbeOutOfSoil,
+  kFaultFloatChatter,
+  kFaultClockWrap,
+  kFaultReboots,
+  kNumFaults,
+};
+const char* const kFaultNames[kNumFaults] = {
+    "stuck-adc",     "disconnected-probe", "probe-out-of-soil",
+    "float-chatter", "clock-wrap",         "reboots",
+};
+
+unsigned envUnsigned(const char* name, unsigned default_value) {
+  const char* val = getenv(name);
+  return val ? static_cast<unsigned>(strtoul(val, nullptr, 0)) : default_value;
+}
+
+// One randomized scenario.
+class Scenario {
+ public:
+  explicit Scenario(unsigned seed);
+
+  // Run the scenario, and return false if an invariant was violated.
+  bool run();
+  // Print the counterexample and write its trace.
+  void report() const;
+
+ private:
+  struct Plant {
+    // Settings.
+    int min_moisture;
+    int max_moisture;
+    int dose_msec;
+    int between_doses_sec;
+    int max_doses;
+    bool enabled;
+    bool reservoir_check;
+    // Soil model.
+    float moisture;
+    float dry_per_hour;
+    float wet_per_sec;
+    // Doses this boot: sim msec of pump on and off (0 while on).
+    std::vector<std::pair<uint64_t, uint64_t>> doses;
+    unsigned last_state = 0;
+  };
+
+  bool has(Fault fault) const { return m_faults & (1u << fault); }
+  bool faultActive() const { return m_t >= m_fault_start && m_t < m_fault_end; }
+  uint32_t millis() const { return static_cast<uint32_t>(m_boot_millis + (m_t - m_boot_t)); }
+  std::string configJson() const;
+
+  void boot(uint32_t millis);
+  void shutDown();
+  void stepPhysics(uint32_t dt);
+  uint16_t adcCounts(unsigned plant);
+  void onPump(unsigned plant, bool on);
+  void noteState(unsigned plant);
+  void checkPumps();
+  void event(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  void violation(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  void addRecord(og3::trace::Kind kind, unsigned channel, uint16_t value);
+
+  const unsigned m_seed;
+  std::mt19937 m_rng;
+  unsigned m_faults = 0;
+  Plant m_plants[sim::kNumPlants];
+  float m_reservoir_ml = og3::kReservoirCapacityMl;
+  uint64_t m_refill_period = 0;
+  uint64_t m_next_refill = 0;
+
+  // Faults.
+  unsigned m_fault_plant = 0;
+  uint64_t m_fault_start = 0;
+  uint64_t m_fault_end = 0;
+  uint16_t m_stuck_counts = 0;
+  std::vector<uint64_t> m_reboots;
+  bool m_reboot_mid_dose = false;
+
+  // Simulation state.
+  std::unique_ptr<sim::Device> m_device;
+  uint64_t m_t = 0;
+  uint64_t m_boot_t = 0;
+  uint32_t m_boot_millis = 0;
+  int m_last_float = -1;
+  // Pump msec of doses which ended with the float low, since the float last saw water.
+  uint64_t m_low_pump_msec = 0;
+  // m_low_pump_msec at the start of the previous step, and whether the float was low then.
+  // A dose starts the step after the state machine decides on it.
+  uint64_t m_low_pump_msec_prev = 0;
+  bool m_float_low = false;
+  bool m_float_low_prev = false;
+  uint64_t m_low_pump_msec_step = 0;
+
+  std::deque<std::string> m_events;
+  std::string m_violation;
+  std::vector<uint8_t> m_trace;
+};
+
+Scenario::Scenario(unsigned seed) : m_seed(seed), m_rng(seed) {
+  auto uniform = [this](int lo, int hi) {
+    return std::uniform_int_distribution<>(lo, hi)(m_rng);
+  };
+  auto uniformf = [this](float lo, float hi) {
+    return std::uniform_real_distribution<float>(lo, hi)(m_rng);
+  };
+  for (auto& plant : m_plants) {
+    plant.min_moisture = uniform(30, 70);
+    plant.max_moisture = plant.min_moisture + uniform(5, 20);
+    plant.dose_msec = uniform(500, 8000);
+    plant.between_doses_sec = uniform(0, 3) == 0 ? uniform(30, 1800) : og3::kPumpOffSec;
+    plant.max_doses = uniform(1, 8);
+    plant.enabled = uniform(0, 9) != 0;
+    plant.reservoir_check = uniform(0, 4) != 0;
+    plant.moisture = uniformf(20.0f, 90.0f);
+    plant.dry_per_hour = uniformf(0.1f, 3.0f);
+    plant.wet_per_sec = uniformf(0.05f, 2.0f);
+  }
+  m_refill_period = uniform(2, 40) * kMsecInHour;
+  m_next_refill = m_refill_period;
+
+  m_faults = uniform(0, (1 << kNumFaults) - 1);
+  m_fault_plant = uniform(0, sim::kNumPlants - 1);
+  m_fault_start = uniform(0, static_cast<int>(kScenarioMsec / 1000)) * 1000ull;
+  m_fault_end = m_fault_start + uniform(60, 12 * 3600) * 1000ull;
+  if (has(kFaultReboots)) {
+    for (int i = uniform(1, 4); i > 0; i--) {
+      m_reboots.push_back(uniform(0, static_cast<int>(kScenarioMsec / 1000)) * 1000ull);
+    }
+    std::sort(m_reboots.begin(), m_reboots.end());
+    m_reboot_mid_dose = uniform(0, 1) != 0;
+  }
+}
+
+std::string Scenario::configJson() const {
+  JsonDocument doc;
+  JsonArray plants = doc["plants"].to<JsonArray>();
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    const Plant& plant = m_plants[i];
+    JsonObject json = plants.add<JsonObject>();
+    json["id"] = i + 1;
+    json["name"] = sim::kPlantNames[i];
+    json["minMoisture"] = plant.min_moisture;
+    json["maxMoisture"] = plant.max_moisture;
+    json["adc0"] = og3::kNoMoistureCounts;
+    json["adc100"] = og3::kFullMoistureCounts;
+    json["pumpOnTime"] = plant.dose_msec;
+    json["secsBetweenDoses"] = plant.between_doses_sec;
+    json["maxDosesPerCycle"] = plant.max_doses;
+    json["enabled"] = plant.enabled;
+    json["reservoirCheck"] = plant.reservoir_check;
+  }
+  doc["reservoir"].to<JsonObject>();
+  std::string out;
+  serializeJson(doc, out);
+  return out;
+}
+
+void Scenario::event(const char* fmt, ...) {
+  char msg[160];
+  const int n = snprintf(msg, sizeof(msg), "%8.3fh millis=%10u ", m_t / double(kMsecInHour),
+                         millis());
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(msg + n, sizeof(msg) - n, fmt, args);
+  va_end(args);
+  m_events.push_back(msg);
+  if (m_events.size() > 40) {
+    m_events.pop_front();
+  }
+}
+
+void Scenario::violation(const char* fmt, ...) {
+  if (!m_violation.empty()) {
+    return;
+  }
+  char msg[200];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(msg, sizeof(msg), fmt, args);
+  va_end(args);
+  m_violation = msg;
+  event("VIOLATION: %s", msg);
+}
+
+void Scenario::addRecord(og3::trace::Kind kind, unsigned channel, uint16_t value) {
+  og3::trace::Record rec;
+  rec.msec = millis();
+  rec.kind = kind;
+  rec.channel = channel;
+  rec.value = value;
+  uint8_t data[og3::trace::kRecordBytes];
+  og3::trace::encode(rec, data);
+  m_trace.insert(m_trace.end(), data, data + sizeof(data));
+}
+
+void Scenario::boot(uint32_t millis) {
+  m_boot_t = m_t;
+  m_boot_millis = millis;
+  sim::hw().now_msec = millis;
+  m_device.reset(new sim::Device());
+  const std::string config = configJson();
+  m_device->applyConfig(config.c_str(), config.size());
+
+  // Everything checked per boot starts over.
+  for (auto& plant : m_plants) {
+    plant.doses.clear();
+    plant.last_state = 0;
+  }
+  m_low_pump_msec = m_low_pump_msec_prev = m_low_pump_msec_step = 0;
+  m_float_low = m_float_low_prev = false;
+  m_last_float = -1;
+
+  m_trace.resize(og3::trace::kHeaderBytes);
+  og3::trace::writeHeader(m_trace.data());
+  addRecord(og3::trace::kKindBoot, 0, 0);
+  const std::string recorded = m_device->config();
+  addRecord(og3::trace::kKindConfig, 0, recorded.size());
+  m_trace.insert(m_trace.end(), recorded.begin(), recorded.end());
+  m_trace.resize(m_trace.size() + og3::trace::paddedBytes(recorded.size()) - recorded.size());
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    m_plants[i].last_state = m_device->plant(i).state();
+  }
+  event("boot");
+}
+
+void Scenario::shutDown() {
+  // Power loss turns off the pumps with everything else.
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    if (sim::hw().pump_on[i]) {
+      sim::hw().pump_on[i] = false;
+      onPump(i, false);
+    }
+  }
+  m_device.reset();
+}
+
+void Scenario::stepPhysics(uint32_t dt) {
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    Plant& plant = m_plants[i];
+    plant.moisture -= plant.dry_per_hour * dt / kMsecInHour;
+    if (sim::hw().pump_on[i] && m_reservoir_ml > 0.0f) {
+      plant.moisture += plant.wet_per_sec * dt / 1000.0f;
+      m_reservoir_ml -= og3::kPumpFlowMlPerSec * dt / 1000.0f;
+    }
+    plant.moisture = std::min(100.0f, std::max(0.0f, plant.moisture));
+  }
+  m_reservoir_ml = std::max(0.0f, m_reservoir_ml);
+  if (m_t >= m_next_refill) {
+    m_reservoir_ml = og3::kReservoirCapacityMl;
+    m_next_refill += m_refill_period;
+  }
+  int level = m_reservoir_ml > kReservoirLowMl ? HIGH : LOW;
+  if (has(kFaultFloatChatter) && faultActive()) {
+    level = (m_rng() & 1) ? HIGH : LOW;
+  }
+  sim::hw().float_level = level;
+}
+
+uint16_t Scenario::adcCounts(unsigned plant) {
+  const float full = og3::kFullMoistureCounts;
+  const float none = og3::kNoMoistureCounts;
+  float counts = none + (full - none) * m_plants[plant].moisture / 100.0f;
+  counts += std::normal_distribution<float>(0.0f, kAdcNoise)(m_rng);
+  if (plant == m_fault_plant && faultActive()) {
+    if (has(kFaultDisconnectedProbe)) {
+      counts = m_rng() % 300;
+    } else if (has(kFaultProbeOutOfSoil)) {
+      counts = none + std::normal_distribution<float>(0.0f, kAdcNoise)(m_rng);
+    } else if (has(kFaultStuckAdc)) {
+      if (m_stuck_counts == 0) {
+        m_stuck_counts = static_cast<uint16_t>(counts);
+      }
+      counts = m_stuck_counts;
+    }
+  }
+  return static_cast<uint16_t>(std::min(4095.0f, std::max(0.0f, counts)));
+}
+
+void Scenario::onPump(unsigned i, bool on) {
+  Plant& plant = m_plants[i];
+  event("plant%u pump %s", i + 1, on ? "on" : "off");
+  if (!on) {
+    if (!plant.doses.empty() && plant.doses.back().second == 0) {
+      plant.doses.back().second = m_t;
+      if (m_float_low) {
+        m_low_pump_msec += m_t - plant.doses.back().first;
+      }
+    }
+    return;
+  }
+  if (!plant.doses.empty() &&
+      m_t - plant.doses.back().first < plant.between_doses_sec * 1000ull) {
+    violation("plant%u dose %.1f sec after the last, limit is %d sec", i + 1,
+              (m_t - plant.doses.back().first) * 1e-3, plant.between_doses_sec);
+  }
+  plant.doses.push_back({m_t, 0});
+  unsigned count = 0;
+  for (const auto& dose : plant.doses) {
+    count += m_t - dose.first < kDoseWindowMsec ? 1 : 0;
+  }
+  if (count > static_cast<unsigned>(plant.max_doses)) {
+    violation("plant%u dose %u in 23 hours, limit is %d", i + 1, count, plant.max_doses);
+  }
+  if (plant.reservoir_check && m_float_low && m_float_low_prev &&
+      m_low_pump_msec_prev >= og3::kLowWaterSecsRemaining * 1000 + 50) {
+    violation("plant%u dose with reservoir low, after pumping %.1f sec since the float was up",
+              i + 1, m_low_pump_msec_prev * 1e-3);
+  }
+  if (has(kFaultDisconnectedProbe) && i == m_fault_plant && faultActive() &&
+      m_t >= m_fault_start + 2 * kMaxStepMsec) {
+    violation("plant%u dose %.1f sec after its probe was disconnected", i + 1,
+              (m_t - m_fault_start) * 1e-3);
+  }
+  if (m_reboot_mid_dose && m_rng() % 8 == 0) {
+    const uint64_t at = m_t + m_rng() % plant.dose_msec;
+    m_reboots.insert(std::upper_bound(m_reboots.begin(), m_reboots.end(), at), at);
+  }
+}
+
+void Scenario::noteState(unsigned i) {
+  const unsigned state = m_device->plant(i).state();
+  if (state != m_plants[i].last_state) {
+    addRecord(og3::trace::kKindState, i, state);
+    event("plant%u -> %s", i + 1, Watering::s_state_names[state]);
+    m_plants[i].last_state = state;
+  }
+}
+
+void Scenario::checkPumps() {
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    const Plant& plant = m_plants[i];
+    if (sim::hw().pump_on[i] && !plant.doses.empty() &&
+        m_t - plant.doses.back().first > plant.dose_msec + 2ull * kMaxStepMsec) {
+      violation("plant%u pump on for %.1f sec, dose is %d msec", i + 1,
+                (m_t - plant.doses.back().first) * 1e-3, plant.dose_msec);
+    }
+  }
+}
+
+bool Scenario::run() {
+  sim::fakeHardware();
+  sim::hw() = sim::Hardware();
+  sim::hw().on_pump = [this](unsigned plant, bool on) { onPump(plant, on); };
+  uint32_t first_millis = 0;
+  if (has(kFaultClockWrap)) {
+    // Wrap around during the scenario.
+    first_millis = static_cast<uint32_t>(0u - static_cast<uint32_t>(m_rng() % kScenarioMsec));
+  }
+  boot(first_millis);
+  size_t next_reboot = 0;
+  while (m_t < kScenarioMsec && m_violation.empty()) {
+    const uint32_t dt = kMinStepMsec + m_rng() % (kMaxStepMsec - kMinStepMsec);
+    m_t += dt;
+    sim::hw().now_msec = millis();
+    stepPhysics(dt);
+    if (next_reboot < m_reboots.size() && m_t >= m_reboots[next_reboot]) {
+      next_reboot += 1;
+      shutDown();
+      m_t += 1000;
+      boot(0);
+      continue;
+    }
+    if (has(kFaultStuckAdc) && !faultActive()) {
+      m_stuck_counts = 0;
+    }
+
+    m_float_low_prev = m_float_low;
+    m_float_low = sim::hw().float_level == LOW;
+    if (!m_float_low) {
+      m_low_pump_msec = 0;
+    }
+    m_low_pump_msec_prev = m_low_pump_msec_step;
+    m_low_pump_msec_step = m_low_pump_msec;
+    if (sim::hw().float_level != m_last_float) {
+      m_last_float = sim::hw().float_level;
+      addRecord(og3::trace::kKindFloat, 0, m_last_float == HIGH ? 1 : 0);
+      event("float %s", m_last_float == HIGH ? "up" : "down");
+    }
+
+    for (unsigned i = 0; i < sim::kNumPlants; i++) {
+      Watering& plant = m_device->plant(i);
+      // The same check as at the start of Watering::loop(), made here so that the trace
+      //  records the enable change as the device does.
+      const bool enabled = plant.isEnabled();
+      if (enabled != (plant.state() != Watering::kStateDisabled)) {
+        addRecord(og3::trace::kKindEnable, i, enabled ? 1 : 0);
+        plant.setPumpEnable(enabled);
+        noteState(i);
+      }
+      sim::hw().adc[i] = adcCounts(i);
+      addRecord(og3::trace::kKindTick, i, sim::hw().adc[i]);
+      plant.loop();
+      noteState(i);
+    }
+    checkPumps();
+  }
+  sim::hw().on_pump = nullptr;
+  shutDown();
+  return m_violation.empty();
+}
+
+void Scenario::report() const {
+  std::string out = "seed " + std::to_string(m_seed) + ": " + m_violation + "\n  faults:";
+  for (unsigned f = 0; f < kNumFaults; f++) {
+    if (has(static_cast<Fault>(f))) {
+      out += std::string(" ") + kFaultNames[f];
+    }
+  }
+  char buf[120];
+  snprintf(buf, sizeof(buf), " (plant%u, %.2fh to %.2fh)\n  config: ", m_fault_plant + 1,
+           m_fault_start / double(kMsecInHour), m_fault_end / double(kMsecInHour));
+  out += buf + configJson() + "\n";
+  for (const auto& event : m_events) {
+    out += "  " + event + "\n";
+  }
+  const std::string path = "fault_" + std::to_string(m_seed) + ".bin";
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file) {
+    fwrite(m_trace.data(), 1, m_trace.size(), file);
+    fclose(file);
+    out += "  trace of this boot: " + path + "\n";
+  }
+  fwrite(out.data(), 1, out.size(), stdout);
+  fflush(stdout);
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_faults() {
+  const unsigned first_seed = envUnsigned("PLANT133_FAULT_SEED", 1);
+  const unsigned num_scenarios = envUnsigned("PLANT133_FAULT_SCENARIOS", 1000);
+  unsigned num_jobs = envUnsigned("PLANT133_FAULT_JOBS", std::thread::hardware_concurrency());
+  num_jobs = std::max(1u, std::min(num_jobs, num_scenarios));
+
+  fflush(stdout);
+  std::vector<pid_t> workers;
+  for (unsigned job = 0; job < num_jobs; job++) {
+    const pid_t pid = fork();
+    TEST_ASSERT_TRUE_MESSAGE(pid >= 0, "fork failed");
+    if (pid == 0) {
+      unsigned failures = 0;
+      for (unsigned i = job; i < num_scenarios; i += num_jobs) {
+        Scenario scenario(first_seed + i);
+        if (!scenario.run()) {
+          scenario.report();
+          failures += 1;
+        }
+      }
+      _exit(std::min(failures, 100u));
+    }
+    workers.push_back(pid);
+  }
+  unsigned failures = 0;
+  bool crashed = false;
+  for (const pid_t pid : workers) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (WIFEXITED(status)) {
+      failures += WEXITSTATUS(status);
+    } else {
+      crashed = true;
+    }
+  }
+  printf("%u scenarios from seed %u in %u workers: %u violations\n", num_scenarios, first_seed,
+         num_jobs, failures);
+  TEST_ASSERT_FALSE_MESSAGE(crashed, "a worker crashed");
+  TEST_ASSERT_EQUAL_UINT_MESSAGE(0, failures, "invariant violations, see the output above");
+}
+
+// A probe pulled out of the soil reads as dry soil.  The first readings pull the smoothed
+//  moisture below the minimum before the median of the readings says that the probe is out of
+//  the soil, and the plant must not be watered on them.
+void test_probe_pulled_out() {
+  sim::fakeHardware();
+  sim::hw() = sim::Hardware();
+  unsigned doses = 0;
+  sim::hw().on_pump = [&doses](unsigned plant, bool on) {
+    if (plant == 0 && on) {
+      doses += 1;
+    }
+  };
+  sim::Device device;
+  JsonDocument doc;
+  JsonObject json = doc["plants"].to<JsonArray>().add<JsonObject>();
+  json["id"] = 1;
+  json["enabled"] = true;
+  json["minMoisture"] = 50;
+  json["maxMoisture"] = 60;
+  json["adc0"] = og3::kNoMoistureCounts;
+  json["adc100"] = og3::kFullMoistureCounts;
+  std::string config;
+  serializeJson(doc, config);
+  TEST_ASSERT_TRUE(device.applyConfig(config.c_str(), config.size()));
+
+  // Run for msec in steps of a second, with the probe reading percent.
+  std::mt19937 rng(1);
+  auto run = [&device, &rng](uint64_t msec, float percent) {
+    const float full = og3::kFullMoistureCounts;
+    const float none = og3::kNoMoistureCounts;
+    for (uint64_t t = 0; t < msec; t += 1000) {
+      const float counts = none + (full - none) * percent / 100.0f +
+                           std::normal_distribution<float>(0.0f, kAdcNoise)(rng);
+      sim::hw().adc[0] = static_cast<uint16_t>(counts + 0.5f);
+      sim::hw().now_msec += 1000;
+      device.loop();
+    }
+  };
+
+  // The soil stays a little wetter than the minimum, so nothing else starts watering.
+  run(2 * kMsecInHour, 53.0f);
+  TEST_ASSERT_EQUAL_UINT(0, doses);
+  TEST_ASSERT_TRUE(device.plant(0).moistureSensor().health().canWater());
+
+  // Pull out the probe, and run for the next few readings.
+  for (unsigned reading = 0; reading < 5; reading++) {
+    run(og3::kWaitForNextCycleMsec, 0.0f);
+    TEST_ASSERT_FALSE(device.plant(0).moistureSensor().health().canWater());
+  }
+  TEST_ASSERT_EQUAL_UINT(0, doses);
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_faults);
+  RUN_TEST(test_probe_pulled_out);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
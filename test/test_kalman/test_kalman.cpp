@@ -0,0 +1,98 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <moisture_kalman.h>
+#include <unity.h>
+
+#include <cmath>
+#include <random>
+
+namespace {
+
+// Soil which dries at kDryPerHour and rises by kRisePerMl for each ml of water, which soaks
+//  in with a one-minute time constant, read every 2 seconds with noisy readings.
+constexpr float kDryPerHour = -0.5f;
+constexpr float kRisePerMl = 0.1f;
+constexpr float kSoakSec = 60.0f;
+constexpr float kReadSec = 2.0f;
+constexpr float kNoise = 2.0f;
+
+class Soil {
+ public:
+  explicit Soil(float moisture) : m_moisture(moisture), m_rng(1234) {}
+
+  void dose(og3::MoistureKalman* kalman, float ml) {
+    m_soaking_ml += ml;
+    kalman->addDose(ml);
+  }
+
+  // Run for secs, reading every kReadSec.
+  void run(og3::MoistureKalman* kalman, float secs) {
+    std::normal_distribution<float> noise(0.0f, kNoise);
+    for (float t = 0.0f; t < secs; t += kReadSec) {
+      const float ml = m_soaking_ml * (1.0f - std::exp(-kReadSec / kSoakSec));
+      m_soaking_ml -= ml;
+      m_moisture += kDryPerHour * kReadSec / 3600.0f + kRisePerMl * ml;
+      m_secs += kReadSec;
+      kalman->addReading(m_secs, m_moisture + noise(m_rng));
+    }
+  }
+
+  float moisture() const { return m_moisture; }
+
+ private:
+  float m_moisture;
+  float m_soaking_ml = 0.0f;
+  float m_secs = 0.0f;
+  std::mt19937 m_rng;
+};
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_drying_rate() {
+  og3::MoistureKalman kalman;
+  Soil soil(60.0f);
+  soil.run(&kalman, 12 * 3600.0f);
+  TEST_ASSERT_TRUE(kalman.valid());
+  TEST_ASSERT_FLOAT_WITHIN(0.2f, kDryPerHour, kalman.ratePerHour());
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, soil.moisture(), kalman.value());
+}
+
+void test_doses() {
+  og3::MoistureKalman kalman;
+  Soil soil(50.0f);
+  soil.run(&kalman, 6 * 3600.0f);
+  for (int cycle = 0; cycle < 4; cycle++) {
+    for (int i = 0; i < 3; i++) {
+      soil.dose(&kalman, 30.0f);
+      // The estimate follows the dose within a few minutes.
+      soil.run(&kalman, 5 * 60.0f);
+      TEST_ASSERT_FLOAT_WITHIN(1.5f, soil.moisture(), kalman.value());
+      soil.run(&kalman, 10 * 60.0f);
+    }
+    soil.run(&kalman, 18 * 3600.0f);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, kRisePerMl, kalman.riseFromMl());
+  TEST_ASSERT_FLOAT_WITHIN(0.2f, kDryPerHour, kalman.ratePerHour());
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_drying_rate);
+  RUN_TEST(test_doses);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
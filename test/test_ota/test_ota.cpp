@@ -0,0 +1,171 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <ota_image.h>
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+using og3::OtaDecoder;
+
+namespace {
+
+// Data something like firmware: runs of instruction-like words from a small set, strings,
+//  random constants and zero padding.
+std::vector<uint8_t> fakeFirmware(size_t len) {
+  std::mt19937 rng(133);
+  std::vector<uint32_t> words(200);
+  for (auto& word : words) {
+    word = rng();
+  }
+  std::vector<uint8_t> data;
+  while (data.size() < len) {
+    switch (rng() % 4) {
+      case 0:
+        for (unsigned i = 0, n = rng() % 64; i < n; i++) {
+          const uint32_t word = words[rng() % 20 + (rng() % 4 == 0 ? rng() % 180 : 0)];
+          for (unsigned b = 0; b < 3; b++) {
+            data.push_back(word >> (8 * b));
+          }
+        }
+        break;
+      case 1:
+        for (const char* c = "plant133 watering state %s\n"; *c; c++) {
+          data.push_back(*c);
+        }
+        break;
+      case 2:
+        for (unsigned i = 0, n = rng() % 32; i < n; i++) {
+          data.push_back(rng());
+        }
+        break;
+      default:
+        data.insert(data.end(), rng() % 300, 0);
+        break;
+    }
+  }
+  data.resize(len);
+  return data;
+}
+
+// Decompress image in chunks of chunk bytes, and return the status.
+OtaDecoder::Status decode(const std::vector<uint8_t>& image, size_t chunk,
+                          std::vector<uint8_t>* out) {
+  OtaDecoder decoder([out](const uint8_t* data, size_t len) {
+    out->insert(out->end(), data, data + len);
+    return len <= og3::ota_image::kWindowBytes;
+  });
+  for (size_t pos = 0; pos < image.size(); pos += chunk) {
+    decoder.write(image.data() + pos, std::min(chunk, image.size() - pos));
+  }
+  return decoder.finish();
+}
+
+void expectRoundTrip(const std::vector<uint8_t>& firmware, size_t chunk) {
+  std::vector<uint8_t> image;
+  og3::ota_image::compress(firmware.data(), firmware.size(), &image);
+  std::vector<uint8_t> out;
+  TEST_ASSERT_TRUE(decode(image, chunk, &out) == OtaDecoder::Status::kOk);
+  TEST_ASSERT_TRUE(out == firmware);
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_crc32() {
+  const char text[] = "123456789";
+  TEST_ASSERT_EQUAL_UINT(
+      0xcbf43926, og3::ota_image::crc32(0, reinterpret_cast<const uint8_t*>(text), 9));
+}
+
+void test_round_trip() {
+  const std::vector<uint8_t> firmware = fakeFirmware(200000);
+  for (size_t chunk : {1, 7, 1436, 200000}) {
+    expectRoundTrip(firmware, chunk);
+  }
+  expectRoundTrip(std::vector<uint8_t>(1, 42), 1);
+  expectRoundTrip(std::vector<uint8_t>(100000, 0), 1436);
+
+  std::vector<uint8_t> image;
+  og3::ota_image::compress(firmware.data(), firmware.size(), &image);
+  TEST_ASSERT_TRUE(image.size() < firmware.size() / 2);
+}
+
+void test_bad_images() {
+  const std::vector<uint8_t> firmware = fakeFirmware(50000);
+  std::vector<uint8_t> image;
+  og3::ota_image::compress(firmware.data(), firmware.size(), &image);
+  std::vector<uint8_t> out;
+
+  std::vector<uint8_t> bad = image;
+  bad[0] = 'X';
+  TEST_ASSERT_TRUE(decode(bad, 1436, &out) == OtaDecoder::Status::kBadHeader);
+
+  bad = image;
+  bad.resize(image.size() - 10);
+  TEST_ASSERT_TRUE(decode(bad, 1436, &out) == OtaDecoder::Status::kTruncated);
+
+  // A changed literal byte gets past decompression, but not the CRC.
+  bad = image;
+  bad[og3::ota_image::kHeaderBytes + 1] ^= 1;
+  TEST_ASSERT_FALSE(decode(bad, 1436, &out) == OtaDecoder::Status::kOk);
+
+  // Extra data after the firmware is corrupt.
+  bad = image;
+  bad.push_back(0);
+  bad.push_back(1);
+  TEST_ASSERT_TRUE(decode(bad, 1436, &out) == OtaDecoder::Status::kCorrupt);
+
+  size_t written = 0;
+  OtaDecoder decoder([&written](const uint8_t*, size_t len) {
+    written += len;
+    return written < 20000;
+  });
+  TEST_ASSERT_FALSE(decoder.write(image.data(), image.size()));
+  TEST_ASSERT_TRUE(decoder.finish() == OtaDecoder::Status::kSinkFailed);
+}
+
+// Compress a real firmware build, from PLANT133_FIRMWARE or the default build path.
+void test_firmware() {
+  const char* path = getenv("PLANT133_FIRMWARE");
+  std::ifstream in(path ? path : ".pio/build/node32s/firmware.bin", std::ios::binary);
+  const std::vector<uint8_t> firmware(std::istreambuf_iterator<char>(in), {});
+  if (firmware.empty()) {
+    TEST_IGNORE_MESSAGE("build node32s or set PLANT133_FIRMWARE to compress a firmware build");
+  }
+  std::vector<uint8_t> image;
+  og3::ota_image::compress(firmware.data(), firmware.size(), &image);
+  std::vector<uint8_t> out;
+  TEST_ASSERT_TRUE(decode(image, 1436, &out) == OtaDecoder::Status::kOk);
+  TEST_ASSERT_TRUE(out == firmware);
+  printf("firmware: %zu bytes, compressed: %zu bytes (%.0f%%)\n", firmware.size(), image.size(),
+         100.0 * image.size() / firmware.size());
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc32);
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_bad_images);
+  RUN_TEST(test_firmware);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
@@ -0,0 +1,106 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+// Checks and partial updates of plant settings, as used by PUT and PATCH /api/plants.
+
+#include <sim_device.h>
+#include <unity.h>
+
+#include <memory>
+
+namespace {
+
+std::unique_ptr<sim::Device> s_device;
+
+JsonDocument parse(const char* json) {
+  JsonDocument doc;
+  deserializeJson(doc, json);
+  return doc;
+}
+
+}  // namespace
+
+void setUp() {
+  sim::fakeHardware();
+  sim::hw().now_msec = 0;
+  s_device.reset(new sim::Device());
+}
+
+void tearDown() { s_device.reset(); }
+
+void test_partial_update() {
+  og3::Watering& plant = s_device->plant(1);
+  const float max_target = plant.maxTarget();
+  const JsonDocument update = parse(R"({"id":2,"minMoisture":30,"enabled":true})");
+  JsonDocument errors;
+  TEST_ASSERT_TRUE(plant.checkApiPlants(update.as<JsonObjectConst>(), errors.to<JsonArray>()));
+  TEST_ASSERT_EQUAL_UINT(0, errors.size());
+  plant.applyApiPlants(update.as<JsonObjectConst>());
+  TEST_ASSERT_EQUAL(30, plant.minTarget());
+  TEST_ASSERT_TRUE(plant.isEnabled());
+  // Settings which were not in the update keep their values.
+  TEST_ASSERT_EQUAL(max_target, plant.maxTarget());
+}
+
+void test_errors() {
+  og3::Watering& plant = s_device->plant(0);
+  const JsonDocument update =
+      parse(R"({"minMoisture":101,"pumpOnTime":"long","enabled":1,"name":"basil"})");
+  JsonDocument errors;
+  TEST_ASSERT_FALSE(plant.checkApiPlants(update.as<JsonObjectConst>(), errors.to<JsonArray>()));
+  TEST_ASSERT_EQUAL_UINT(3, errors.size());
+  TEST_ASSERT_EQUAL(1, errors[0]["id"].as<int>());
+  TEST_ASSERT_EQUAL_STRING("minMoisture", errors[0]["field"].as<const char*>());
+  TEST_ASSERT_EQUAL_STRING("pumpOnTime", errors[1]["field"].as<const char*>());
+  TEST_ASSERT_EQUAL_STRING("enabled", errors[2]["field"].as<const char*>());
+}
+
+void test_checks_against_current_settings() {
+  og3::Watering& plant = s_device->plant(2);
+  JsonDocument errors;
+  const JsonDocument targets = parse(R"({"minMoisture":40,"maxMoisture":60})");
+  TEST_ASSERT_TRUE(plant.checkApiPlants(targets.as<JsonObjectConst>(), errors.to<JsonArray>()));
+  plant.applyApiPlants(targets.as<JsonObjectConst>());
+  // The minimum must not be above the current maximum.
+  const JsonDocument update = parse(R"({"minMoisture":70})");
+  TEST_ASSERT_FALSE(plant.checkApiPlants(update.as<JsonObjectConst>(), errors.to<JsonArray>()));
+  TEST_ASSERT_EQUAL_STRING("minMoisture", errors[0]["field"].as<const char*>());
+  // Unless the maximum changes too.
+  const JsonDocument both = parse(R"({"minMoisture":70,"maxMoisture":80})");
+  TEST_ASSERT_TRUE(plant.checkApiPlants(both.as<JsonObjectConst>(), errors.to<JsonArray>()));
+}
+
+void test_put() {
+  og3::Watering& plant = s_device->plant(3);
+  const float min_target = plant.minTarget();
+  // A bad setting is reported, and none of the settings are applied.
+  const JsonDocument bad = parse(R"({"minMoisture":20,"adc0":-1})");
+  JsonDocument errors;
+  TEST_ASSERT_FALSE(plant.putApiPlants(bad.as<JsonObjectConst>(), errors.to<JsonArray>()));
+  TEST_ASSERT_EQUAL_UINT(1, errors.size());
+  TEST_ASSERT_EQUAL_STRING("adc0", errors[0]["field"].as<const char*>());
+  TEST_ASSERT_EQUAL(min_target, plant.minTarget());
+  const JsonDocument good = parse(R"({"minMoisture":20})");
+  TEST_ASSERT_TRUE(plant.putApiPlants(good.as<JsonObjectConst>(), errors.to<JsonArray>()));
+  TEST_ASSERT_EQUAL_UINT(0, errors.size());
+  TEST_ASSERT_EQUAL(20, plant.minTarget());
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_partial_update);
+  RUN_TEST(test_errors);
+  RUN_TEST(test_checks_against_current_settings);
+  RUN_TEST(test_put);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
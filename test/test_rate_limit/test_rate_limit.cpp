@@ -0,0 +1,87 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <rate_limiter.h>
+#include <unity.h>
+
+namespace {
+
+using og3::RateLimiter;
+using og3::TokenBucket;
+
+void test_bucket() {
+  // Bursts of 2, then one every 10 seconds.
+  TokenBucket bucket(2, 6);
+  TEST_ASSERT_TRUE(bucket.take(1000));
+  TEST_ASSERT_TRUE(bucket.take(1000));
+  TEST_ASSERT_FALSE(bucket.take(1000));
+  TEST_ASSERT_EQUAL_UINT(10, bucket.retryAfterSec(1000));
+  TEST_ASSERT_EQUAL_UINT(5, bucket.retryAfterSec(6000));
+  TEST_ASSERT_FALSE(bucket.take(10999));
+  TEST_ASSERT_TRUE(bucket.take(11000));
+  // Waiting longer doesn't save up more than the burst.
+  TEST_ASSERT_TRUE(bucket.take(1000000));
+  TEST_ASSERT_TRUE(bucket.take(1000000));
+  TEST_ASSERT_FALSE(bucket.take(1000000));
+}
+
+void test_bucket_wraps() {
+  TokenBucket bucket(1, 6);
+  TEST_ASSERT_TRUE(bucket.take(0xfffff000));
+  TEST_ASSERT_FALSE(bucket.take(0xfffff000));
+  // millis() wraps around 10 seconds later.
+  TEST_ASSERT_TRUE(bucket.take(10000 - 0x1000));
+}
+
+void test_endpoints() {
+  RateLimiter limiter;
+  const unsigned burst = RateLimiter::limit(RateLimiter::kPumpTest).burst;
+  for (unsigned i = 0; i < burst; i++) {
+    TEST_ASSERT_EQUAL_UINT(0, limiter.admit(RateLimiter::kPumpTest, 1000));
+    limiter.release();
+  }
+  TEST_ASSERT_TRUE(limiter.admit(RateLimiter::kPumpTest, 1000) > 0);
+  TEST_ASSERT_EQUAL_UINT(1, limiter.rejected(RateLimiter::kPumpTest));
+  // Other endpoints have their own buckets.
+  TEST_ASSERT_EQUAL_UINT(0, limiter.admit(RateLimiter::kPlantSettings, 1000));
+  limiter.release();
+  TEST_ASSERT_EQUAL_UINT(0, limiter.inFlight());
+}
+
+void test_in_flight() {
+  RateLimiter limiter;
+  for (unsigned i = 0; i < RateLimiter::kMaxInFlight; i++) {
+    TEST_ASSERT_EQUAL_UINT(0, limiter.admit(RateLimiter::kApiRead, 1000));
+  }
+  TEST_ASSERT_EQUAL_UINT(1, limiter.admit(RateLimiter::kApiRead, 1000));
+  TEST_ASSERT_EQUAL_UINT(1, limiter.rejectedBusy());
+  TEST_ASSERT_EQUAL_UINT(0, limiter.rejected(RateLimiter::kApiRead));
+  limiter.release();
+  TEST_ASSERT_EQUAL_UINT(0, limiter.admit(RateLimiter::kApiRead, 1000));
+
+  JsonDocument jsondoc;
+  limiter.toJson(jsondoc.to<JsonObject>());
+  TEST_ASSERT_EQUAL_UINT(RateLimiter::kMaxInFlight, jsondoc["inFlight"].as<unsigned>());
+  TEST_ASSERT_EQUAL_UINT(1, jsondoc["rejected"]["busy"].as<unsigned>());
+}
+
+}  // namespace
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_bucket);
+  RUN_TEST(test_bucket_wraps);
+  RUN_TEST(test_endpoints);
+  RUN_TEST(test_in_flight);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
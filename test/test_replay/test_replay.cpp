@@ -0,0 +1,322 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+// Replay a trace recorded by a device (see lib/watering/trace_log.h) through the watering
+//  state machines, and check that they make the same state changes at the same times.
+//
+// By default, a trace of a day of watering is recorded on simulated hardware by TraceLog and
+//  replayed, along with a trace long enough that its first segments have been deleted.
+//  To replay a trace from a device instead:
+//
+//   curl -o trace.bin http://plant133.local/api/trace?prev=1
+//   PLANT133_TRACE=trace.bin pio test -e native -f test_replay
+//
+// Set PLANT133_CONFIG to a JSON file like the config in the trace ({"plants": [...],
+//  "reservoir": {...}}) to replay with different settings, or set PLANT133_COMPARE=0.
+//  Either way, the state changes are printed instead of checked.
+// For example, {"plants": [{"id": 1, "kalman": true}]} replays with plant 1 watered by the
+//  Kalman moisture estimate.  The number of doses and the peak moisture estimates of both
+//  filters are printed for each plant, to compare them.
+
+#include <sim_device.h>
+#include <trace_log.h>
+#include <unity.h>
+#include <watering_constants.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kMsecInHour = 3600 * 1000;
+
+// The doses and peak moisture estimates of a plant.
+struct Summary {
+  unsigned doses = 0;
+  float kernel_peak = 0.0f;
+  float kalman_peak = 0.0f;
+
+  void add(const og3::Watering& plant, unsigned prev_state) {
+    const og3::MoistureSensor& sensor = plant.moistureSensor();
+    if (plant.state() == og3::Watering::kStateDose && prev_state != og3::Watering::kStateDose) {
+      doses += 1;
+    }
+    kernel_peak = std::max(kernel_peak, sensor.filter().value());
+    if (sensor.kalman().valid()) {
+      kalman_peak = std::max(kalman_peak, sensor.kalman().value());
+    }
+  }
+};
+
+struct Transition {
+  uint32_t msec;
+  unsigned state;
+  bool operator==(const Transition& o) const { return msec == o.msec && state == o.state; }
+};
+
+std::vector<uint8_t> readFile(const char* path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});
+}
+
+void printTransitions(unsigned plant, const char* what, const std::vector<Transition>& list) {
+  printf("plant%u %s:\n", plant + 1, what);
+  for (const auto& t : list) {
+    printf("  %10u.%03u %s\n", t.msec / 1000, t.msec % 1000,
+           og3::Watering::s_state_names[t.state]);
+  }
+}
+
+// Record a trace of hours of watering on simulated hardware with TraceLog, as a device
+//  would, into data as downloaded from /api/trace.
+void recordTrace(uint32_t hours, std::vector<uint8_t>* data) {
+  sim::fakeHardware();
+  sim::hw() = sim::Hardware();
+  std::unique_ptr<sim::Device> device(new sim::Device(true /*trace*/));
+  og3::TraceLog* trace = device->trace();
+  TEST_ASSERT_NOT_NULL(trace);
+
+  // Plants 1 and 2 are watered, and plants 3 and 4 are disabled.
+  JsonDocument doc;
+  JsonArray plants = doc["plants"].to<JsonArray>();
+  for (unsigned i = 0; i < 2; i++) {
+    JsonObject json = plants.add<JsonObject>();
+    json["id"] = i + 1;
+    json["enabled"] = true;
+    json["minMoisture"] = 50;
+    json["maxMoisture"] = 60;
+    json["adc0"] = og3::kNoMoistureCounts;
+    json["adc100"] = og3::kFullMoistureCounts;
+  }
+  std::string config;
+  serializeJson(doc, config);
+  TEST_ASSERT_TRUE(device->applyConfig(config.c_str(), config.size()));
+  const std::string recorded = device->config();
+  trace->addConfig(recorded.c_str(), recorded.size());
+
+  // A soil model: plants dry by a few % an hour, and a dose soaks in at once.
+  std::mt19937 rng(1);
+  float moisture[sim::kNumPlants] = {45.0f, 58.0f, 40.0f, 70.0f};
+  const float dry_per_hour[sim::kNumPlants] = {1.0f, 2.0f, 1.0f, 1.0f};
+  std::normal_distribution<float> noise(0.0f, 4.0f);
+  const float full = og3::kFullMoistureCounts;
+  const float none = og3::kNoMoistureCounts;
+  const uint64_t end_msec = static_cast<uint64_t>(hours) * kMsecInHour;
+  for (uint64_t t = 0; t < end_msec;) {
+    const uint32_t dt = 200 + rng() % 4800;
+    t += dt;
+    sim::hw().now_msec = static_cast<uint32_t>(t);
+    for (unsigned i = 0; i < sim::kNumPlants; i++) {
+      moisture[i] -= dry_per_hour[i] * dt / kMsecInHour;
+      if (sim::hw().pump_on[i]) {
+        moisture[i] += 1.5f * dt / 1000.0f;
+      }
+      moisture[i] = std::min(100.0f, std::max(0.0f, moisture[i]));
+      sim::hw().adc[i] = static_cast<uint16_t>(none + (full - none) * moisture[i] / 100.0f +
+                                               noise(rng) + 0.5f);
+    }
+    device->loop();
+  }
+  trace->flush();
+  TEST_ASSERT_TRUE(trace->keptBytes() <= og3::kTraceMaxBytes);
+
+  og3::TraceLog::Reader reader(trace, false /*prev*/);
+  TEST_ASSERT_TRUE(reader.valid());
+  data->clear();
+  uint8_t buffer[100];
+  for (size_t len = reader.read(buffer, sizeof(buffer)); len > 0;
+       len = reader.read(buffer, sizeof(buffer))) {
+    data->insert(data->end(), buffer, buffer + len);
+  }
+}
+
+// Replay a trace, and check that it makes the recorded state changes if compare.
+// Set starts_at_boot to whether the trace starts at boot, rather than after its first
+//  segments were deleted.
+void replay(const std::vector<uint8_t>& data, const char* config_path, bool compare,
+            bool* starts_at_boot) {
+  TEST_ASSERT_TRUE_MESSAGE(data.size() >= og3::trace::kHeaderBytes, "trace is too short");
+  TEST_ASSERT_TRUE_MESSAGE(og3::trace::checkHeader(data.data()), "not a plant133 trace");
+
+  sim::fakeHardware();
+  sim::hw() = sim::Hardware();
+  // Devices boot with millis() at 0, but simulations may record a different boot time.
+  size_t pos = og3::trace::kHeaderBytes;
+  og3::trace::Record rec;
+  sim::hw().now_msec = 0;
+  if (pos + og3::trace::kRecordBytes <= data.size() &&
+      og3::trace::decode(data.data() + pos, &rec) && rec.kind == og3::trace::kKindBoot) {
+    sim::hw().now_msec = rec.msec;
+    pos += og3::trace::kRecordBytes;
+  }
+  // A trace whose first segments were deleted starts part way through a boot, with the
+  //  filters and state machines in a state which the trace doesn't record.
+  *starts_at_boot = true;
+  if (pos + og3::trace::kRecordBytes <= data.size() &&
+      og3::trace::decode(data.data() + pos, &rec) && rec.kind == og3::trace::kKindSegment &&
+      rec.value > 0) {
+    *starts_at_boot = false;
+    sim::hw().now_msec = rec.msec;
+    printf("The trace starts %u segments after boot, so state changes are printed instead of "
+           "checked.\n",
+           rec.value);
+    compare = false;
+  }
+  std::unique_ptr<sim::Device> device(new sim::Device());
+
+  std::vector<Transition> expected[sim::kNumPlants];
+  std::vector<Transition> actual[sim::kNumPlants];
+  Summary summary[sim::kNumPlants];
+  auto noteState = [&](unsigned plant) {
+    const unsigned state = device->plant(plant).state();
+    summary[plant].add(device->plant(plant), actual[plant].back().state);
+    if (actual[plant].empty() || actual[plant].back().state != state) {
+      actual[plant].push_back({sim::hw().now_msec, state});
+    }
+  };
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    actual[i].push_back({sim::hw().now_msec, device->plant(i).state()});
+    expected[i].push_back({sim::hw().now_msec, device->plant(i).state()});
+  }
+
+  float temperature = 0.0f;
+  bool have_config = false;
+  while (pos + og3::trace::kRecordBytes <= data.size()) {
+    TEST_ASSERT_TRUE_MESSAGE(og3::trace::decode(data.data() + pos, &rec), "bad trace record");
+    pos += og3::trace::kRecordBytes;
+    sim::hw().now_msec = rec.msec;
+    const unsigned plant = rec.channel;
+    switch (rec.kind) {
+      case og3::trace::kKindConfig: {
+        const char* json = reinterpret_cast<const char*>(data.data() + pos);
+        pos += og3::trace::paddedBytes(rec.value);
+        TEST_ASSERT_TRUE_MESSAGE(pos <= data.size(), "truncated config record");
+        if (have_config) {
+          // Later segments repeat the config from boot.
+          break;
+        }
+        have_config = true;
+        TEST_ASSERT_TRUE_MESSAGE(device->applyConfig(json, rec.value),
+                                 "bad config JSON in trace");
+        if (config_path) {
+          const std::vector<uint8_t> cfg = readFile(config_path);
+          TEST_ASSERT_TRUE_MESSAGE(
+              device->applyConfig(reinterpret_cast<const char*>(cfg.data()), cfg.size()),
+              "bad JSON in PLANT133_CONFIG");
+        }
+        break;
+      }
+      case og3::trace::kKindTick:
+        TEST_ASSERT_TRUE(plant < sim::kNumPlants);
+        if (rec.value != og3::trace::kNoReading) {
+          sim::hw().adc[plant] = rec.value;
+        }
+        device->plant(plant).loop();
+        noteState(plant);
+        break;
+      case og3::trace::kKindEnable:
+        TEST_ASSERT_TRUE(plant < sim::kNumPlants);
+        device->plant(plant).setPumpEnable(rec.value != 0);
+        noteState(plant);
+        break;
+      case og3::trace::kKindFloat:
+        sim::hw().float_level = rec.value ? HIGH : LOW;
+        break;
+      case og3::trace::kKindTemperature:
+        temperature = og3::trace::fromCenti(rec.value);
+        break;
+      case og3::trace::kKindHumidity:
+        device->climate().set(temperature, og3::trace::fromCenti(rec.value), rec.msec);
+        break;
+      case og3::trace::kKindState:
+        TEST_ASSERT_TRUE(plant < sim::kNumPlants);
+        expected[plant].push_back({rec.msec, rec.value});
+        break;
+      case og3::trace::kKindBoot:
+        TEST_FAIL_MESSAGE("boot record after the start of the trace");
+        break;
+      case og3::trace::kKindSegment:
+        break;
+    }
+  }
+
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    const og3::Watering& plant = device->plant(i);
+    printf("plant%u: %u doses (%s), max target %.1f%%, peak moisture %.1f%% kernel, "
+           "%.1f%% Kalman\n",
+           i + 1, summary[i].doses, plant.moistureSensor().useKalman() ? "Kalman" : "kernel",
+           plant.maxTarget(), summary[i].kernel_peak, summary[i].kalman_peak);
+  }
+  for (unsigned i = 0; i < sim::kNumPlants; i++) {
+    if (!compare) {
+      printTransitions(i, "replayed", actual[i]);
+      continue;
+    }
+    if (actual[i] != expected[i]) {
+      printTransitions(i, "recorded", expected[i]);
+      printTransitions(i, "replayed", actual[i]);
+      TEST_FAIL_MESSAGE("replayed state changes differ from the trace");
+    }
+  }
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_recorded_trace() {
+  std::vector<uint8_t> data;
+  recordTrace(12, &data);
+  bool starts_at_boot = false;
+  replay(data, nullptr, true /*compare*/, &starts_at_boot);
+  TEST_ASSERT_TRUE(starts_at_boot);
+}
+
+void test_rotated_trace() {
+  // Long enough that the first segments of the boot are deleted.
+  std::vector<uint8_t> data;
+  recordTrace(48, &data);
+  TEST_ASSERT_TRUE(data.size() <= og3::kTraceMaxBytes);
+  bool starts_at_boot = true;
+  replay(data, nullptr, false /*compare*/, &starts_at_boot);
+  TEST_ASSERT_FALSE(starts_at_boot);
+}
+
+void test_replay() {
+  const char* trace_path = getenv("PLANT133_TRACE");
+  if (!trace_path) {
+    TEST_IGNORE_MESSAGE("set PLANT133_TRACE to the path of a trace to replay");
+  }
+  const char* config_path = getenv("PLANT133_CONFIG");
+  const char* compare_env = getenv("PLANT133_COMPARE");
+  const bool compare = !config_path && !(compare_env && compare_env[0] == '0');
+  bool starts_at_boot = false;
+  replay(readFile(trace_path), config_path, compare, &starts_at_boot);
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_recorded_trace);
+  RUN_TEST(test_rotated_trace);
+  RUN_TEST(test_replay);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
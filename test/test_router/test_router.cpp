@@ -0,0 +1,79 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <plant_router.h>
+#include <unity.h>
+
+using og3::PlantRouter;
+
+namespace {
+
+void assertRoute(const char* url, PlantRouter::Action action, unsigned plant) {
+  PlantRouter::Route route;
+  TEST_ASSERT_TRUE_MESSAGE(PlantRouter::parse(url, &route), url);
+  TEST_ASSERT_EQUAL_UINT_MESSAGE(action, route.action, url);
+  TEST_ASSERT_EQUAL_UINT_MESSAGE(plant, route.plant, url);
+}
+
+void assertNoRoute(const char* url) {
+  PlantRouter::Route route;
+  TEST_ASSERT_FALSE_MESSAGE(PlantRouter::parse(url, &route), url);
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_parse() {
+  assertRoute("/plant1/status", PlantRouter::kStatusPage, 0);
+  assertRoute("/plant4/config", PlantRouter::kConfigPage, 3);
+  assertRoute("/plant2/pump", PlantRouter::kPumpPage, 1);
+  assertRoute("/plant32/status", PlantRouter::kStatusPage, 31);
+  assertRoute("/api/plants/1", PlantRouter::kApiPut, 0);
+  assertRoute("/api/plants/16", PlantRouter::kApiPut, 15);
+}
+
+void test_parse_other_urls() {
+  assertNoRoute("/");
+  assertNoRoute("/api/plants");
+  assertNoRoute("/api/plants/");
+  assertNoRoute("/api/plants/0");
+  assertNoRoute("/api/plants/01");
+  assertNoRoute("/api/plants/33");
+  assertNoRoute("/api/plants/1/x");
+  assertNoRoute("/api/plantsx/1");
+  assertNoRoute("/plant/status");
+  assertNoRoute("/plant0/status");
+  assertNoRoute("/plant1");
+  assertNoRoute("/plant1/");
+  assertNoRoute("/plant1/statusx");
+  assertNoRoute("/plant99999999999/status");
+}
+
+void test_endpoint() {
+  TEST_ASSERT_EQUAL(og3::RateLimiter::kRootPage, PlantRouter::endpoint(PlantRouter::kStatusPage));
+  TEST_ASSERT_EQUAL(og3::RateLimiter::kPlantSettings,
+                    PlantRouter::endpoint(PlantRouter::kConfigPage));
+  TEST_ASSERT_EQUAL(og3::RateLimiter::kPumpTest, PlantRouter::endpoint(PlantRouter::kPumpPage));
+  TEST_ASSERT_EQUAL(og3::RateLimiter::kPlantSettings, PlantRouter::endpoint(PlantRouter::kApiPut));
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_parse);
+  RUN_TEST(test_parse_other_urls);
+  RUN_TEST(test_endpoint);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
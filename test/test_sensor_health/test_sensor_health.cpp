@@ -0,0 +1,153 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <sensor_health.h>
+#include <unity.h>
+#include <watering_constants.h>
+
+#include <random>
+
+using og3::SensorHealth;
+using Status = og3::SensorHealth::Status;
+
+namespace {
+
+// Counts of a probe at a moisture percent, as calibrated by default.
+unsigned countsAt(float percent) {
+  const float full = og3::kFullMoistureCounts;
+  const float none = og3::kNoMoistureCounts;
+  return static_cast<unsigned>(none + (full - none) * percent / 100.0f + 0.5f);
+}
+
+// Add readings of a probe at percent with normally distributed noise.
+void addReadings(SensorHealth* health, std::mt19937* rng, unsigned num, float percent,
+                 float noise) {
+  std::normal_distribution<float> dist(0.0f, noise);
+  for (unsigned i = 0; i < num; i++) {
+    const float val = percent + dist(*rng);
+    health->add(countsAt(val), val, false);
+  }
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_ok() {
+  std::mt19937 rng(1);
+  SensorHealth health;
+  addReadings(&health, &rng, 500, 60.0f, 0.5f);
+  TEST_ASSERT_TRUE(health.status() == Status::kOk);
+  TEST_ASSERT_TRUE(health.canWater());
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 60.0f, health.median());
+  // The MAD of normal noise is 0.67 of its standard deviation.
+  TEST_ASSERT_FLOAT_WITHIN(0.2f, 0.34f, health.mad());
+  TEST_ASSERT_FLOAT_WITHIN(0.2f, 0.5f, health.noise());
+  TEST_ASSERT_EQUAL_UINT(500, health.readings());
+}
+
+void test_outliers_and_level_changes() {
+  std::mt19937 rng(2);
+  SensorHealth health;
+  addReadings(&health, &rng, 100, 50.0f, 0.5f);
+  // Single spikes barely move the median.
+  for (unsigned i = 0; i < 5; i++) {
+    health.add(countsAt(100.0f), 100.0f, false);
+    addReadings(&health, &rng, 10, 50.0f, 0.5f);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 50.0f, health.median());
+  // A dose of water raises the level, and the median follows it.
+  addReadings(&health, &rng, 15, 70.0f, 0.5f);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 70.0f, health.median());
+  TEST_ASSERT_TRUE(health.status() == Status::kOk);
+}
+
+void test_disconnected() {
+  std::mt19937 rng(3);
+  SensorHealth health;
+  addReadings(&health, &rng, 50, 60.0f, 0.5f);
+  // The ADC reading is out of its valid range.
+  health.add(100, 190.0f, true);
+  TEST_ASSERT_TRUE(health.status() == Status::kDisconnected);
+  TEST_ASSERT_FALSE(health.canWater());
+  addReadings(&health, &rng, 1, 60.0f, 0.5f);
+  TEST_ASSERT_TRUE(health.status() == Status::kOk);
+  // Readings far wetter than water.
+  addReadings(&health, &rng, 20, 180.0f, 0.5f);
+  TEST_ASSERT_TRUE(health.status() == Status::kDisconnected);
+}
+
+void test_out_of_soil() {
+  std::mt19937 rng(4);
+  SensorHealth health;
+  addReadings(&health, &rng, 50, 60.0f, 0.5f);
+  // The first reading out of the soil stops watering, before the median follows it.
+  addReadings(&health, &rng, 1, 0.0f, 0.5f);
+  TEST_ASSERT_TRUE(health.median() > og3::kMinPlausibleMoisture);
+  TEST_ASSERT_TRUE(health.status() == Status::kOutOfSoil);
+  TEST_ASSERT_FALSE(health.canWater());
+  addReadings(&health, &rng, 19, 0.0f, 0.5f);
+  TEST_ASSERT_TRUE(health.status() == Status::kOutOfSoil);
+  TEST_ASSERT_FALSE(health.canWater());
+  addReadings(&health, &rng, 20, 60.0f, 0.5f);
+  TEST_ASSERT_TRUE(health.status() == Status::kOk);
+
+  // A probe in air from the first reading.
+  SensorHealth in_air;
+  addReadings(&in_air, &rng, 1, 0.0f, 0.5f);
+  TEST_ASSERT_TRUE(in_air.status() == Status::kOutOfSoil);
+}
+
+void test_stuck() {
+  std::mt19937 rng(5);
+  SensorHealth health;
+  addReadings(&health, &rng, 50, 60.0f, 0.5f);
+  for (unsigned i = 1; i < og3::kSensorStuckReadings; i++) {
+    health.add(countsAt(40.0f), 40.0f, false);
+  }
+  TEST_ASSERT_TRUE(health.status() != Status::kStuck);
+  health.add(countsAt(40.0f), 40.0f, false);
+  TEST_ASSERT_TRUE(health.status() == Status::kStuck);
+  TEST_ASSERT_FALSE(health.canWater());
+  health.add(countsAt(41.0f), 41.0f, false);
+  TEST_ASSERT_TRUE(health.status() == Status::kOk);
+}
+
+void test_noisy() {
+  std::mt19937 rng(6);
+  SensorHealth health;
+  addReadings(&health, &rng, 100, 60.0f, 0.5f);
+  addReadings(&health, &rng, 100, 60.0f, 10.0f);
+  TEST_ASSERT_TRUE(health.status() == Status::kNoisy);
+  // A noisy probe still waters, with smaller doses.
+  TEST_ASSERT_TRUE(health.canWater());
+  TEST_ASSERT_FLOAT_WITHIN(3.0f, 60.0f, health.median());
+  addReadings(&health, &rng, 200, 60.0f, 0.5f);
+  TEST_ASSERT_TRUE(health.status() == Status::kOk);
+  TEST_ASSERT_EQUAL_STRING("ok", SensorHealth::s_status_names[static_cast<int>(Status::kOk)]);
+  TEST_ASSERT_EQUAL_STRING("out of soil",
+                           SensorHealth::s_status_names[static_cast<int>(Status::kOutOfSoil)]);
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_ok);
+  RUN_TEST(test_outliers_and_level_changes);
+  RUN_TEST(test_disconnected);
+  RUN_TEST(test_out_of_soil);
+  RUN_TEST(test_stuck);
+  RUN_TEST(test_noisy);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
@@ -0,0 +1,48 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <static_cache.h>
+#include <unity.h>
+
+using og3::StaticCache;
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_policy() {
+  TEST_ASSERT_TRUE(StaticCache::policy("/assets/index-B2x9fQ_a.js") ==
+                   StaticCache::Policy::kImmutable);
+  TEST_ASSERT_TRUE(StaticCache::policy("/assets/index-Cq1kP3sZ.css") ==
+                   StaticCache::Policy::kImmutable);
+  TEST_ASSERT_TRUE(StaticCache::policy("/") == StaticCache::Policy::kRevalidate);
+  TEST_ASSERT_TRUE(StaticCache::policy("/index.html") == StaticCache::Policy::kRevalidate);
+  TEST_ASSERT_TRUE(StaticCache::policy("/api/dashboard") == StaticCache::Policy::kDefault);
+  TEST_ASSERT_TRUE(StaticCache::policy("/assets") == StaticCache::Policy::kDefault);
+  TEST_ASSERT_TRUE(StaticCache::policy("/config/assets/x.js") == StaticCache::Policy::kDefault);
+}
+
+void test_cache_control() {
+  TEST_ASSERT_EQUAL_STRING("public, max-age=31536000, immutable",
+                           StaticCache::cacheControl(StaticCache::Policy::kImmutable));
+  TEST_ASSERT_EQUAL_STRING("no-cache",
+                           StaticCache::cacheControl(StaticCache::Policy::kRevalidate));
+  TEST_ASSERT_NULL(StaticCache::cacheControl(StaticCache::Policy::kDefault));
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_policy);
+  RUN_TEST(test_cache_control);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
@@ -0,0 +1,82 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <ArduinoJson.h>
+#include <telemetry_codec.h>
+#include <unity.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> encode(og3::TelemetryCodec* codec, const char* json) {
+  JsonDocument doc;
+  deserializeJson(doc, json);
+  std::vector<uint8_t> out;
+  codec->encode(doc, &out);
+  return out;
+}
+
+void assertBytes(const std::vector<uint8_t>& expected, const std::vector<uint8_t>& actual) {
+  TEST_ASSERT_EQUAL_UINT(expected.size(), actual.size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected.data(), actual.data(), expected.size());
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_encode() {
+  og3::TelemetryCodec codec(0x1234);
+  assertBytes({0x93, 0xcd, 0x12, 0x34, 0xcd, 0x00, 0x03,  // [tag, 3 keys,
+               0x83,                                       //  {
+               0x00, 0x01,                                 //   0: 1,
+               0x01, 0x93, 0xc3, 0xff, 0xa1, 'x',          //   1: [true, -1, "x"],
+               0x02, 0xca, 0x3f, 0xc0, 0x00, 0x00},        //   2: 1.5f}]
+              encode(&codec, R"({"a":1,"b":[true,-1,"x"],"c":1.5})"));
+  // Keys keep their numbers, and new keys are numbered after them.
+  assertBytes({0x93, 0xcd, 0x12, 0x34, 0xcd, 0x00, 0x04,  //
+               0x82, 0x02, 0xcc, 0xc8, 0x03, 0xd1, 0xfe, 0x0c},
+              encode(&codec, R"({"c":200,"d":-500})"));
+
+  JsonDocument schema;
+  codec.schemaJson(schema.to<JsonObject>());
+  TEST_ASSERT_EQUAL(0x1234, schema["tag"].as<int>());
+  TEST_ASSERT_EQUAL(4, schema["keys"].size());
+  TEST_ASSERT_EQUAL_STRING("d", schema["keys"][3].as<const char*>());
+}
+
+void test_key_limit() {
+  og3::TelemetryCodec codec(1);
+  JsonDocument doc;
+  for (size_t i = 0; i < og3::TelemetryCodec::kMaxKeys; i++) {
+    doc[std::to_string(i)] = 0;
+  }
+  std::vector<uint8_t> out;
+  codec.encode(doc, &out);
+  TEST_ASSERT_EQUAL_UINT(og3::TelemetryCodec::kMaxKeys, codec.numKeys());
+  // Keys past the limit are sent as strings.
+  assertBytes({0x93, 0xcd, 0x00, 0x01, 0xcd, 0x02, 0x00, 0x81, 0xa3, 'n', 'e', 'w', 0x00},
+              encode(&codec, R"({"new":0})"));
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_encode);
+  RUN_TEST(test_key_limit);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }
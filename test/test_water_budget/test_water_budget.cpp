@@ -0,0 +1,114 @@
+// Copyright (c) 2025 Chris Lee and contibuters.
+// Licensed under the MIT license. See LICENSE file in the project root for details.
+
+#include <unity.h>
+#include <water_budget.h>
+
+using og3::WaterBudget;
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_inactive() {
+  WaterBudget budget;
+  budget.setNeed(0, 10.0f);
+  TEST_ASSERT_FALSE(budget.active());
+  // Before the float drops, a plant may use whatever is left.
+  TEST_ASSERT_EQUAL_FLOAT(7.0f, budget.allowanceSec(0, 7.0f));
+  budget.addUsedSec(0, 3.0f);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, budget.usedSec(0));
+}
+
+void test_shares_by_need() {
+  WaterBudget budget;
+  budget.setNeed(0, 30.0f);
+  budget.setNeed(1, 10.0f);
+  budget.setNeed(2, -5.0f);
+  budget.start(20.0f);
+  TEST_ASSERT_TRUE(budget.active());
+  TEST_ASSERT_EQUAL_FLOAT(0.75f, budget.share(0));
+  TEST_ASSERT_EQUAL_FLOAT(0.25f, budget.share(1));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, budget.share(2));
+  TEST_ASSERT_EQUAL_FLOAT(15.0f, budget.allowanceSec(0, 20.0f));
+  TEST_ASSERT_EQUAL_FLOAT(5.0f, budget.allowanceSec(1, 20.0f));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, budget.allowanceSec(2, 20.0f));
+  // Shares are of the water left.
+  TEST_ASSERT_EQUAL_FLOAT(3.0f, budget.allowanceSec(0, 4.0f));
+}
+
+void test_used_time() {
+  WaterBudget budget;
+  budget.setNeed(0, 10.0f);
+  budget.setNeed(1, 10.0f);
+  budget.start(10.0f);
+  budget.addUsedSec(0, 3.0f);
+  TEST_ASSERT_EQUAL_FLOAT(2.0f, budget.allowanceSec(0, 7.0f));
+  budget.addUsedSec(0, 3.0f);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, budget.allowanceSec(0, 4.0f));
+  // Once plant 0 has been watered, its need falls and plant 1 may use the rest.
+  budget.setNeed(0, 0.0f);
+  TEST_ASSERT_EQUAL_FLOAT(4.0f, budget.allowanceSec(1, 4.0f));
+  // A refill starts a new budget.
+  budget.stop();
+  budget.setNeed(0, 10.0f);
+  budget.start(10.0f);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, budget.usedSec(0));
+  TEST_ASSERT_EQUAL_FLOAT(5.0f, budget.allowanceSec(0, 10.0f));
+}
+
+void test_three_plants() {
+  WaterBudget budget;
+  for (unsigned i = 0; i < 3; i++) {
+    budget.setNeed(i, 10.0f);
+  }
+  budget.start(60.0f);
+  float remaining = 60.0f;
+  TEST_ASSERT_EQUAL_FLOAT(20.0f, budget.allowanceSec(0, remaining));
+  // Plant 0 pumps its share and no longer needs water.
+  budget.addUsedSec(0, 20.0f);
+  remaining -= 20.0f;
+  budget.setNeed(0, 0.0f);
+  // Plants 1 and 2 split what is left, and plant 1 can't take plant 2's share.
+  TEST_ASSERT_EQUAL_FLOAT(20.0f, budget.allowanceSec(1, remaining));
+  budget.addUsedSec(1, 20.0f);
+  remaining -= 20.0f;
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, budget.allowanceSec(1, remaining));
+  TEST_ASSERT_EQUAL_FLOAT(20.0f, budget.allowanceSec(2, remaining));
+  // Plant 2 pumps part of its share.
+  budget.addUsedSec(2, 5.0f);
+  remaining -= 5.0f;
+  TEST_ASSERT_EQUAL_FLOAT(15.0f, budget.allowanceSec(2, remaining));
+  // Once plant 1 is satisfied, plant 2 may use everything left.
+  budget.setNeed(1, 0.0f);
+  TEST_ASSERT_EQUAL_FLOAT(15.0f, budget.allowanceSec(2, remaining));
+}
+
+void test_out_of_range() {
+  WaterBudget budget;
+  budget.setNeed(WaterBudget::kMaxPlants, 10.0f);
+  budget.start(10.0f);
+  budget.addUsedSec(WaterBudget::kMaxPlants, 1.0f);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, budget.needOf(WaterBudget::kMaxPlants));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, budget.allowanceSec(WaterBudget::kMaxPlants, 10.0f));
+}
+
+int runUnityTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_inactive);
+  RUN_TEST(test_shares_by_need);
+  RUN_TEST(test_used_time);
+  RUN_TEST(test_three_plants);
+  RUN_TEST(test_out_of_range);
+  return UNITY_END();
+}
+
+// For native platform.
+int main() { return runUnityTests(); }
+
+// For arduion framework
+void setup() {}
+void loop() {}
+
+// For ESP-IDF framework
+void app_main() { runUnityTests(); }